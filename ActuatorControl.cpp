@@ -1,4 +1,6 @@
 #include "ActuatorControl.h"
+#include "EventBus.h"
+#include "Logger.h"
 
 // Pin definitions (sesuaikan dengan HardwareConfig.h Anda)
 #define PIN_VALVE_DRAIN   33
@@ -17,12 +19,11 @@ ActuatorControl::ActuatorControl()
     , pumpUVState(false)
     , ozoneState(false)
     , buzzerState(false)
+    , eventBus(nullptr)
 {
-    mutex = xSemaphoreCreateMutex();
 }
 
 ActuatorControl::~ActuatorControl() {
-    if (mutex) vSemaphoreDelete(mutex);
 }
 
 // ===== PUBLIC API =====
@@ -39,75 +40,67 @@ void ActuatorControl::begin() {
     // Initial state: ALL OFF
     allOff();
     
-    Serial.println("[ACTUATOR] Initialized - All actuators OFF");
+    LOG_I("ACTUATOR", "Initialized - All actuators OFF");
+}
+
+void ActuatorControl::setEventBus(EventBus* bus) {
+    eventBus = bus;
 }
 
 // ===== VALVE CONTROL =====
 
 void ActuatorControl::setValveDrain(bool state) {
-    lock();
     valveDrainState = state;
     digitalWrite(PIN_VALVE_DRAIN, state ? HIGH : LOW);
-    unlock();
     
-    Serial.print("[ACTUATOR] Valve Drain: ");
-    Serial.println(state ? "OPEN" : "CLOSED");
+    LOG_I("ACTUATOR", "Valve Drain: %s", state ? "OPEN" : "CLOSED");
+    publish(Actuator::VALVE_DRAIN, state);
 }
 
 void ActuatorControl::setValveInlet(bool state) {
-    lock();
     valveInletState = state;
     digitalWrite(PIN_VALVE_INLET, state ? HIGH : LOW);
-    unlock();
     
-    Serial.print("[ACTUATOR] Valve Inlet: ");
-    Serial.println(state ? "OPEN" : "CLOSED");
+    LOG_I("ACTUATOR", "Valve Inlet: %s", state ? "OPEN" : "CLOSED");
+    publish(Actuator::VALVE_INLET, state);
 }
 
 // ===== COOLING CONTROL =====
 
 void ActuatorControl::setCompressor(bool state) {
-    lock();
     compressorState = state;
     digitalWrite(PIN_COMPRESSOR, state ? HIGH : LOW);
-    unlock();
     
-    Serial.print("[ACTUATOR] Compressor: ");
-    Serial.println(state ? "ON" : "OFF");
+    LOG_I("ACTUATOR", "Compressor: %s", state ? "ON" : "OFF");
+    publish(Actuator::COMPRESSOR, state);
 }
 
 // ===== PUMP & TREATMENT =====
 
 void ActuatorControl::setPumpUV(bool state) {
-    lock();
     pumpUVState = state;
     digitalWrite(PIN_PUMP_UV, state ? HIGH : LOW);
-    unlock();
     
-    Serial.print("[ACTUATOR] Pump UV: ");
-    Serial.println(state ? "ON" : "OFF");
+    LOG_I("ACTUATOR", "Pump UV: %s", state ? "ON" : "OFF");
+    publish(Actuator::PUMP_UV, state);
 }
 
 void ActuatorControl::setOzone(bool state) {
-    lock();
     ozoneState = state;
     digitalWrite(PIN_OZONE, state ? HIGH : LOW);
-    unlock();
     
-    Serial.print("[ACTUATOR] Ozone: ");
-    Serial.println(state ? "ON" : "OFF");
+    LOG_I("ACTUATOR", "Ozone: %s", state ? "ON" : "OFF");
+    publish(Actuator::OZONE, state);
 }
 
 // ===== BUZZER =====
 
 void ActuatorControl::setBuzzer(bool state) {
-    lock();
     buzzerState = state;
     digitalWrite(PIN_BUZZER, state ? HIGH : LOW);
-    unlock();
     
-    Serial.print("[ACTUATOR] Buzzer: ");
-    Serial.println(state ? "ON" : "OFF");
+    LOG_I("ACTUATOR", "Buzzer: %s", state ? "ON" : "OFF");
+    publish(Actuator::BUZZER, state);
 }
 
 void ActuatorControl::beep(uint16_t durationMs) {
@@ -119,8 +112,6 @@ void ActuatorControl::beep(uint16_t durationMs) {
 // ===== EMERGENCY =====
 
 void ActuatorControl::allOff() {
-    lock();
-    
     valveDrainState = false;
     valveInletState = false;
     compressorState = false;
@@ -135,9 +126,8 @@ void ActuatorControl::allOff() {
     digitalWrite(PIN_OZONE, LOW);
     digitalWrite(PIN_BUZZER, LOW);
     
-    unlock();
-    
-    Serial.println("[ACTUATOR] ALL OFF");
+    LOG_I("ACTUATOR", "ALL OFF");
+    publish(Actuator::ALL, false);
 }
 
 // ===== GETTERS =====
@@ -166,11 +156,17 @@ bool ActuatorControl::getBuzzerState() const {
     return buzzerState;
 }
 
+// ===== EVENTS =====
+
+void ActuatorControl::publish(Actuator actuator, bool on) {
+    if (!eventBus) return;
+    ActuatorChange change = { actuator, on };
+    eventBus->actuators.publish(change);
+}
+
 // ===== DEBUG =====
 
 void ActuatorControl::printStatus() {
-    lock();
-    
     Serial.println("╔════════════════════════════════════╗");
     Serial.println("║      ACTUATOR STATUS               ║");
     Serial.println("╠════════════════════════════════════╣");
@@ -187,20 +183,4 @@ void ActuatorControl::printStatus() {
     Serial.print("║ Buzzer       : ");
     Serial.println(buzzerState ? "ON        ║" : "OFF       ║");
     Serial.println("╚════════════════════════════════════╝");
-    
-    unlock();
-}
-
-// ===== MUTEX =====
-
-void ActuatorControl::lock() {
-    if (mutex) {
-        xSemaphoreTake(mutex, portMAX_DELAY);
-    }
 }
-
-void ActuatorControl::unlock() {
-    if (mutex) {
-        xSemaphoreGive(mutex);
-    }
-}
\ No newline at end of file
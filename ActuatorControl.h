@@ -2,8 +2,15 @@
 #define ACTUATOR_CONTROL_H
 
 #include <Arduino.h>
+#include <atomic>
+
+struct EventBus;
+enum class Actuator : uint8_t;
 
 // ===== ACTUATOR CONTROLLER CLASS =====
+// Dimiliki FSM task: setter hanya dipanggil dari sana (state handler,
+// AutoCycle, controller) dan dari setup() sebelum task jalan - tanpa mutex.
+// Task lain membaca state lewat getter (atomic).
 class ActuatorControl {
 public:
     ActuatorControl();
@@ -11,6 +18,9 @@ public:
     
     void begin();
     
+    // Setiap perubahan di-publish ke topic actuators
+    void setEventBus(EventBus* bus);
+    
     // ===== VALVE CONTROL =====
     void setValveDrain(bool state);
     void setValveInlet(bool state);
@@ -41,18 +51,17 @@ public:
     void printStatus();
 
 private:
-    SemaphoreHandle_t mutex;
-    
     // State tracking
-    bool valveDrainState;
-    bool valveInletState;
-    bool compressorState;
-    bool pumpUVState;
-    bool ozoneState;
-    bool buzzerState;
-    
-    void lock();
-    void unlock();
+    std::atomic<bool> valveDrainState;
+    std::atomic<bool> valveInletState;
+    std::atomic<bool> compressorState;
+    std::atomic<bool> pumpUVState;
+    std::atomic<bool> ozoneState;
+    std::atomic<bool> buzzerState;
+    
+    EventBus* eventBus;
+    
+    void publish(Actuator actuator, bool on);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,513 @@
+// AutoCycle.cpp
+#include "AutoCycle.h"
+#include "Logger.h"
+
+static const char* AUTO_STAGE_NAMES[AUTO_STAGE_COUNT] = {
+    "INACTIVE",
+    "WAIT_SCHEDULE",
+    "RUNNING",
+    "FAULT"
+};
+
+static const uint32_t SECONDS_PER_DAY = 86400UL;
+
+// ===== CONSTRUCTOR / DESTRUCTOR =====
+
+AutoCycle::AutoCycle(
+    StateConditionHandler* condHandler,
+    ActuatorControl* actuators,
+    SensorManager* sensors,
+    NextionOutput* display,
+    SystemStorage* storage,
+    RTCManager* rtc,
+    RecipeStore* recipes
+)
+    : conditionHandler(condHandler)
+    , actuator(actuators)
+    , sensor(sensors)
+    , nextion(display)
+    , systemStorage(storage)
+    , rtcManager(rtc)
+    , recipeStore(recipes)
+    , runner(condHandler, actuators, sensors, storage)
+    , planner()
+    , stage(AutoStage::AUTO_INACTIVE)
+    , circulationEnabled(false)
+    , retryCount(0)
+    , faultedStep(0)
+    , stepFaulted(false)
+    , lastReadyTime(0)
+    , batchRecipeCrc(0)
+    , plannedStart(0)
+    , batchStartMs(0)
+    , coolStartTemp(0)
+    , readyReached(false)
+    , resumePending(false)
+    , resumePoint()
+    , resumeAgeS(0)
+    , stats()
+{
+    TimerService::initFlag(scheduleTimer);
+    TimerService::initFlag(retryTimer);
+}
+
+AutoCycle::~AutoCycle() {
+    timerService.cancel(scheduleTimer);
+    timerService.cancel(retryTimer);
+}
+
+void AutoCycle::begin() {
+    planner.begin();
+}
+
+void AutoCycle::flush() {
+    planner.flush();
+}
+
+void AutoCycle::setEventQueue(QueueHandle_t queue) {
+    TimerService::initEvent(scheduleTimer, queue, FsmEvent::EV_DEADLINE);
+    TimerService::initEvent(retryTimer, queue, FsmEvent::EV_DEADLINE);
+    runner.setEventQueue(queue);
+}
+
+// ===== PUBLIC API =====
+
+void AutoCycle::start(bool circulation) {
+    circulationEnabled = circulation;
+    runner.setCirculation(circulation);
+    retryCount = 0;
+
+    LOG_I("AUTO", "Auto cycle started (circulation %s)", circulation ? "ON" : "OFF");
+
+    if (resumePending) {
+        resumePending = false;
+        lastReadyTime = resumePoint.readyUnix;    // Interval hari lanjut dari batch terakhir
+        if (resumeBatch()) return;
+    }
+    enterStage(AutoStage::AUTO_WAIT_SCHEDULE);
+}
+
+void AutoCycle::setCirculation(bool circulation) {
+    if (circulation == circulationEnabled) return;
+    circulationEnabled = circulation;
+
+    LOG_I("AUTO", "Circulation %s (stage %s)", circulation ? "ON" : "OFF", stageName(stage));
+    runner.setCirculation(circulation);
+}
+
+void AutoCycle::update() {
+    switch (stage) {
+        case AutoStage::AUTO_WAIT_SCHEDULE: updateWaitSchedule(); break;
+        case AutoStage::AUTO_RUNNING:       updateRunning();      break;
+        case AutoStage::AUTO_FAULT:         updateFault();        break;
+        default: break;
+    }
+}
+
+void AutoCycle::stop() {
+    if (stage == AutoStage::AUTO_INACTIVE) return;
+
+    bool midBatch = (stage != AutoStage::AUTO_WAIT_SCHEDULE);
+
+    runner.stop();
+    stage = AutoStage::AUTO_INACTIVE;
+    lastReadyTime = 0;                    // start() berikutnya merencanakan dari jam setAuto terdekat
+    timerService.cancel(scheduleTimer);
+    rtcManager->cancelAlarm(RtcAlarm::ALARM_AUTO_START);
+    timerService.cancel(retryTimer);
+    nextion->setErrorBlink(false);
+
+    if (midBatch) {
+        stats.batchesAborted++;
+        LOG_W("AUTO", "Auto cycle stopped by user - batch aborted");
+    } else {
+        LOG_I("AUTO", "Auto cycle stopped");
+    }
+}
+
+// ===== CHECKPOINT =====
+
+void AutoCycle::fillCheckpoint(FsmCheckpoint& checkpoint) {
+    checkpoint.autoStage = static_cast<uint8_t>(stage);
+    checkpoint.readyUnix = lastReadyTime;
+
+    bool inBatch = (stage == AutoStage::AUTO_RUNNING || stage == AutoStage::AUTO_FAULT);
+    checkpoint.stepIndex = inBatch ? runner.getStepIndex() : 0;
+    checkpoint.recipeCrc = inBatch ? batchRecipeCrc : 0;
+    checkpoint.stepElapsedS = inBatch ? runner.getStepElapsedMs() / 1000 : 0;
+    checkpoint.stepLiters = inBatch ? runner.getStepLiters() : 0;
+}
+
+void AutoCycle::setResume(const FsmCheckpoint& checkpoint, uint32_t ageS) {
+    resumePoint = checkpoint;
+    resumeAgeS = ageS;
+    resumePending = true;
+}
+
+AutoStage AutoCycle::getStage() const {
+    return stage;
+}
+
+bool AutoCycle::isRunning() const {
+    return stage != AutoStage::AUTO_INACTIVE;
+}
+
+const char* AutoCycle::stageName(AutoStage s) const {
+    uint8_t index = static_cast<uint8_t>(s);
+    return index < AUTO_STAGE_COUNT ? AUTO_STAGE_NAMES[index] : "UNKNOWN";
+}
+
+AutoCycleStats AutoCycle::getStats() const {
+    return stats;
+}
+
+// ===== DEBUG =====
+
+void AutoCycle::printStatus() {
+    LOG_I("AUTO", "Stage %s, batches done=%lu aborted=%lu faults=%lu, last batch %lus",
+          stageName(stage),
+          (unsigned long)stats.batchesCompleted,
+          (unsigned long)stats.batchesAborted,
+          (unsigned long)stats.faults,
+          (unsigned long)(stats.lastBatchMs / 1000));
+
+    uint32_t nextStart = rtcManager->getAlarm(RtcAlarm::ALARM_AUTO_START);
+    if (nextStart) {
+        LOG_I("AUTO", "  next start at %lu (in %lds)", (unsigned long)nextStart,
+              (long)(nextStart - rtcManager->getUnixTime()));
+    }
+
+    if (stage == AutoStage::AUTO_RUNNING || stage == AutoStage::AUTO_FAULT) {
+        LOG_I("AUTO", "  step %u/%u %s", runner.getStepIndex() + 1, runner.getStepCount(),
+              recipeOpName(runner.getCurrentOp()));
+    }
+
+    for (uint8_t i = 0; i < stats.stepCount; i++) {
+        LOG_I("AUTO", "  step %2u %lus", i + 1, (unsigned long)(stats.stepDurationMs[i] / 1000));
+    }
+
+    if (stats.plannedReady) {
+        LOG_I("AUTO", "  last ready: planned %lu, actual %lu (%+lds)",
+              (unsigned long)stats.plannedReady, (unsigned long)stats.actualReady,
+              (long)stats.readyErrorS);
+    }
+
+    FillReport fill = conditionHandler->getLastFillReport();
+    if (fill.durationMs) {
+        LOG_I("AUTO", "  last fill: %.2f L in %lus (%s), overfill %+.2f L",
+              fill.volumeL, (unsigned long)(fill.durationMs / 1000),
+              fill.predictive ? "predictive" : "float", fill.overfillL);
+    }
+    planner.printModel();
+}
+
+// ===== STAGE HANDLING =====
+
+void AutoCycle::enterStage(AutoStage next) {
+    if (stage == AutoStage::AUTO_FAULT && next != AutoStage::AUTO_FAULT) {
+        timerService.cancel(retryTimer);
+        nextion->setErrorBlink(false);
+    }
+
+    stage = next;
+
+    switch (next) {
+        case AutoStage::AUTO_WAIT_SCHEDULE:
+            timerService.cancel(scheduleTimer);
+            updateWaitSchedule();
+            break;
+
+        case AutoStage::AUTO_FAULT:
+            actuator->allOff();
+            nextion->setErrorBlink(true);
+            timerService.arm(retryTimer, AUTO_FAULT_RETRY_MS);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void AutoCycle::startBatch(uint32_t readyTime) {
+    // Snapshot recipe: perubahan recipe saat batch jalan berlaku di batch berikutnya
+    RecipeProgram program = recipeStore->getProgram();
+
+    lastReadyTime = readyTime;
+    batchRecipeCrc = CheckpointStore::crc16(program.code, program.length);
+    plannedStart = 0;
+    batchStartMs = TimerService::nowMs();
+    retryCount = 0;
+    stepFaulted = false;
+    readyReached = false;
+    stats.plannedReady = readyTime;
+    stats.actualReady = 0;
+    stats.readyErrorS = 0;
+    nextion->setErrorBlink(false);
+    timerService.cancel(scheduleTimer);
+    rtcManager->cancelAlarm(RtcAlarm::ALARM_AUTO_START);
+
+    LOG_I("AUTO", "Scheduled batch starting (%u steps)", program.stepCount);
+    stage = AutoStage::AUTO_RUNNING;
+    runner.start(program);
+}
+
+// Batch yang terputus reset: step & progress dari checkpoint, waktu reset
+// ikut dihitung sebagai waktu step berjalan. Recipe harus masih sama.
+bool AutoCycle::resumeBatch() {
+    AutoStage saved = static_cast<AutoStage>(resumePoint.autoStage);
+    if (saved != AutoStage::AUTO_RUNNING && saved != AutoStage::AUTO_FAULT) return false;
+
+    RecipeProgram program = recipeStore->getProgram();
+    uint16_t crc = CheckpointStore::crc16(program.code, program.length);
+    if (crc != resumePoint.recipeCrc || resumePoint.stepIndex >= program.stepCount) {
+        LOG_W("AUTO", "Recipe changed since reset - batch not resumed");
+        return false;
+    }
+
+    batchRecipeCrc = crc;
+    plannedStart = 0;
+    batchStartMs = TimerService::nowMs();
+    retryCount = 0;
+    stepFaulted = true;          // Step terputus: durasinya tidak dipelajari planner
+
+    // Ready = COOL pertama selesai; sudah lewat jika ada COOL sebelum step ini
+    readyReached = false;
+    RecipeStep earlier;
+    for (uint8_t i = 0; i < resumePoint.stepIndex; i++) {
+        if (recipeDecode(program, i, earlier) && earlier.op == RecipeOp::OP_COOL) {
+            readyReached = true;
+        }
+    }
+    stats.plannedReady = lastReadyTime;
+    nextion->setErrorBlink(false);
+    timerService.cancel(scheduleTimer);
+    rtcManager->cancelAlarm(RtcAlarm::ALARM_AUTO_START);
+
+    LOG_I("AUTO", "Resuming batch at step %u/%u after reset", resumePoint.stepIndex + 1, program.stepCount);
+    stage = AutoStage::AUTO_RUNNING;
+    runner.resume(program, resumePoint.stepIndex,
+                  (resumePoint.stepElapsedS + resumeAgeS) * 1000UL, resumePoint.stepLiters);
+    return true;
+}
+
+void AutoCycle::fault() {
+    stats.faults++;
+    stepFaulted = true;
+
+    // Step baru yang gagal: hitungan retry mulai lagi
+    if (runner.getStepIndex() != faultedStep) {
+        faultedStep = runner.getStepIndex();
+        retryCount = 0;
+    }
+    retryCount++;
+
+    LOG_W("AUTO", "FAULT in step %u %s: %s (attempt %u/%u)",
+          faultedStep + 1, recipeOpName(runner.getCurrentOp()), runner.getFaultReason(),
+          retryCount, AUTO_MAX_RETRIES);
+
+    if (retryCount > AUTO_MAX_RETRIES) {
+        abortBatch(runner.getFaultReason());
+        return;
+    }
+
+    enterStage(AutoStage::AUTO_FAULT);
+}
+
+void AutoCycle::completeBatch() {
+    stats.batchesCompleted++;
+    stats.lastBatchMs = static_cast<uint32_t>(TimerService::nowMs() - batchStartMs);
+    stats.stepCount = runner.getStepCount();
+
+    LOG_I("AUTO", "Batch complete in %lus", (unsigned long)(stats.lastBatchMs / 1000));
+    for (uint8_t i = 0; i < stats.stepCount; i++) {
+        stats.stepDurationMs[i] = runner.getStepDurationMs(i);
+        LOG_I("AUTO", "  step %2u %lus", i + 1, (unsigned long)(stats.stepDurationMs[i] / 1000));
+    }
+
+    runner.stop();
+    enterStage(AutoStage::AUTO_WAIT_SCHEDULE);
+}
+
+void AutoCycle::abortBatch(const char* reason) {
+    stats.batchesAborted++;
+    LOG_E("AUTO", "Batch aborted: %s - waiting for next schedule", reason);
+
+    // Aman: semua actuator OFF, error tetap ditampilkan sampai batch berikutnya mulai
+    runner.stop();
+    actuator->allOff();
+    enterStage(AutoStage::AUTO_WAIT_SCHEDULE);
+    nextion->setErrorBlink(true);
+}
+
+// ===== STAGE UPDATES =====
+
+void AutoCycle::updateWaitSchedule() {
+    if (!rtcManager->isRTCValid()) {
+        // Tanpa RTC tidak ada jadwal - tetap menunggu, cek lagi saat heartbeat
+        return;
+    }
+
+    // Alarm start fire / jam di-set ulang: cukup re-plan di bawah
+    rtcManager->consumeAlarm(RtcAlarm::ALARM_AUTO_START);
+
+    uint32_t now = rtcManager->getUnixTime();
+    uint32_t ready = nextReadyTime(now);
+    if (ready == 0) {
+        rtcManager->cancelAlarm(RtcAlarm::ALARM_AUTO_START);
+        return;  // setAuto belum diisi / tidak valid
+    }
+
+    // Re-plan setiap kali dicek: suhu air / setting / recipe bisa berubah
+    RecipeProgram program = recipeStore->getProgram();
+    uint32_t lead = planLeadSeconds(program);
+    uint32_t start = ready > lead ? ready - lead : 0;
+
+    if (now >= start) {
+        if (now > start + AUTO_SCHEDULE_GRACE_S) {
+            LOG_W("AUTO", "Starting %lus behind plan - batch will be ready late",
+                  (unsigned long)(now - start));
+        }
+        startBatch(ready);
+        return;
+    }
+
+    if (start != plannedStart) {
+        plannedStart = start;
+        LOG_I("AUTO", "Ready in %lus, start planned in %lus (lead %lus)",
+              (unsigned long)(ready - now), (unsigned long)(start - now), (unsigned long)lead);
+    }
+
+    // Start tepat waktu oleh alarm RTC (jam dinding, ikut setTime); timer
+    // hanya untuk re-plan lead jika start masih jauh
+    rtcManager->setAlarm(RtcAlarm::ALARM_AUTO_START, start);
+    if (start - now > AUTO_SCHEDULE_RECHECK_MS / 1000 && !timerService.isArmed(scheduleTimer)) {
+        timerService.arm(scheduleTimer, AUTO_SCHEDULE_RECHECK_MS);
+    }
+}
+
+void AutoCycle::updateRunning() {
+    RecipeOp op = runner.getCurrentOp();
+    uint8_t index = runner.getStepIndex();
+
+    RecipeStatus status = runner.update();
+
+    // Runner maju paling banyak satu step per update
+    if (status == RecipeStatus::RECIPE_COMPLETE ||
+        (status == RecipeStatus::RECIPE_RUNNING && runner.getStepIndex() != index)) {
+        onStepFinished(op, index);
+    }
+
+    switch (status) {
+        case RecipeStatus::RECIPE_COMPLETE:
+            completeBatch();
+            break;
+
+        case RecipeStatus::RECIPE_FAULT:
+            fault();
+            break;
+
+        default:
+            break;
+    }
+}
+
+void AutoCycle::onStepFinished(RecipeOp op, uint8_t index) {
+    bool learn = !stepFaulted;
+    stepFaulted = false;
+
+    SensorData data = sensor->getData();
+    uint32_t durationMs = runner.getStepDurationMs(index);
+
+    if (op == RecipeOp::OP_FILL && learn && data.tempValid) {
+        planner.learnFill(durationMs, data.temperature);
+    }
+
+    // Step berikutnya COOL pertama: catat suhu awal pull-down
+    if (!readyReached && runner.getStatus() == RecipeStatus::RECIPE_RUNNING &&
+        runner.getCurrentOp() == RecipeOp::OP_COOL) {
+        coolStartTemp = data.temperature;
+    }
+
+    if (op != RecipeOp::OP_COOL || readyReached) return;
+
+    // ===== READY: COOL pertama selesai =====
+    readyReached = true;
+    if (learn && data.tempValid) {
+        planner.learnCool(coolStartTemp, data.temperature, durationMs);
+    }
+
+    if (rtcManager->isRTCValid()) {
+        stats.actualReady = rtcManager->getUnixTime();
+        stats.readyErrorS = static_cast<int32_t>(stats.actualReady - stats.plannedReady);
+        LOG_I("AUTO", "Water ready %ld s %s planned time",
+              (long)(stats.readyErrorS < 0 ? -stats.readyErrorS : stats.readyErrorS),
+              stats.readyErrorS > 0 ? "after" : "before");
+    }
+}
+
+void AutoCycle::updateFault() {
+    // Fault saat fill boleh langsung pulih jika aliran kembali normal
+    RecipeOp op = runner.getCurrentOp();
+    bool cleared = (op == RecipeOp::OP_FILL || op == RecipeOp::OP_REFRESH) && conditionHandler->isErrorCleared();
+
+    if (cleared || timerService.consumeExpired(retryTimer)) {
+        enterStage(AutoStage::AUTO_RUNNING);
+        runner.retryStep();
+    }
+}
+
+// ===== SCHEDULE =====
+
+uint32_t AutoCycle::nextReadyTime(uint32_t now) {
+    uint8_t hour, minute;
+    if (!parseAutoTime(hour, minute)) {
+        return 0;
+    }
+
+    uint32_t timeOfDay = hour * 3600UL + minute * 60UL;
+    uint16_t intervalDays = systemStorage->getDaysValue();
+    if (intervalDays == 0) intervalDays = 1;
+
+    if (lastReadyTime != 0) {
+        // Batch berikutnya: hari siap terakhir + interval, di jam setAuto (terbaru).
+        // Jadwal yang sudah lewat (AUTO dimatikan beberapa hari) digeser per interval
+        // utuh - satu batch terlambat boleh, bukan batch susul-menyusul.
+        uint32_t interval = intervalDays * SECONDS_PER_DAY;
+        uint32_t lastDay = lastReadyTime - (lastReadyTime % SECONDS_PER_DAY);
+        uint32_t ready = lastDay + interval + timeOfDay;
+        if (now > ready + AUTO_SCHEDULE_GRACE_S) {
+            ready += ((now - AUTO_SCHEDULE_GRACE_S - ready + interval - 1) / interval) * interval;
+        }
+        return ready;
+    }
+
+    // Belum pernah jalan: jam siap terdekat hari ini (toleransi grace) atau besok
+    uint32_t today = now - (now % SECONDS_PER_DAY) + timeOfDay;
+    if (now <= today + AUTO_SCHEDULE_GRACE_S) {
+        return today;
+    }
+    return today + SECONDS_PER_DAY;
+}
+
+uint32_t AutoCycle::planLeadSeconds(const RecipeProgram& program) {
+    // Satu snapshot: target dan durasi dari setting yang sama
+    SystemVariables settings = systemStorage->getVariables();
+    uint8_t autoTarget = settings.autoTemp;
+    if (autoTarget == 0) autoTarget = settings.coolingValue;
+
+    SensorData data = sensor->getData();
+    float waterTemp = planner.estimateWaterTemp(data.temperature, data.tempValid);
+
+    return planner.leadSeconds(program, autoTarget, settings.countValue, waterTemp);
+}
+
+bool AutoCycle::parseAutoTime(uint8_t &hour, uint8_t &minute) {
+    TimeText setAuto = systemStorage->getSetAuto();
+    if (!systemStorage->isValidTimeFormat(setAuto)) {
+        return false;
+    }
+
+    hour = atoi(setAuto.c_str());
+    minute = atoi(setAuto.from(3));
+    return hour <= 23 && minute <= 59;
+}
@@ -0,0 +1,141 @@
+// AutoCycle.h
+#ifndef AUTO_CYCLE_H
+#define AUTO_CYCLE_H
+
+#include <Arduino.h>
+#include "StateConditionHandler.h"
+#include "SystemVariables.h"
+#include "RTCManager.h"
+#include "Recipe.h"
+#include "RecipeRunner.h"
+#include "PreCoolPlanner.h"
+#include "TimerService.h"
+#include "Checkpoint.h"
+
+// ===== AUTO STAGES =====
+enum class AutoStage : uint8_t {
+    AUTO_INACTIVE = 0,      // FSM tidak di AUTO / AUTO_CIRCULATION
+    AUTO_WAIT_SCHEDULE,     // Menunggu start terencana (siap di jam setAuto, interval daysValue hari)
+    AUTO_RUNNING,           // Recipe batch sedang dijalankan RecipeRunner
+    AUTO_FAULT              // Semua OFF, tunggu retry step yang gagal
+};
+
+#define AUTO_STAGE_COUNT 4
+
+// ===== TIMING =====
+// Timeout per step ada di recipe (lihat Recipe.h)
+#define AUTO_FAULT_RETRY_MS       (60UL * 1000)           // Retry step gagal tiap 1 menit
+#define AUTO_MAX_RETRIES          3                       // Lebih dari ini batch dibatalkan
+#define AUTO_SCHEDULE_RECHECK_MS  (15UL * 60 * 1000)      // Re-plan lead (suhu/setting berubah) tiap 15 menit
+#define AUTO_SCHEDULE_GRACE_S     60                      // Masuk AUTO s/d 1 menit setelah jam siap = tetap jalan
+
+struct AutoCycleStats {
+    uint32_t batchesCompleted;
+    uint32_t batchesAborted;
+    uint32_t faults;
+    uint8_t stepCount;                            // Jumlah step recipe batch terakhir
+    uint32_t stepDurationMs[RECIPE_MAX_STEPS];    // Durasi tiap step pada batch terakhir
+    uint32_t lastBatchMs;                         // Step pertama → OP_END
+    uint32_t plannedReady;                        // Unix: jam setAuto batch terakhir
+    uint32_t actualReady;                         // Unix: step COOL pertama selesai (0 = belum/tanpa COOL)
+    int32_t readyErrorS;                          // actual - planned (+ = terlambat)
+};
+
+// ===== AUTO CYCLE ENGINE =====
+// Menjalankan recipe batch (default: fill → cool → hold → drain) tanpa
+// operator sesuai jadwal, plus retry/abort saat step gagal. setAuto = jam air
+// siap di target; start batch dimajukan oleh PreCoolPlanner. Dijalankan oleh
+// FSM: start() di entry AUTO, update() di setiap event, stop() di exit.
+class AutoCycle {
+public:
+    AutoCycle(
+        StateConditionHandler* condHandler,
+        ActuatorControl* actuators,
+        SensorManager* sensors,
+        NextionOutput* display,
+        SystemStorage* storage,
+        RTCManager* rtc,
+        RecipeStore* recipes
+    );
+    ~AutoCycle();
+
+    void begin();                            // Muat model PreCoolPlanner dari NVS
+    void flush();                            // Dipanggil dari loop(): simpan model planner
+
+    // Timer jadwal/retry/step mem-post EV_DEADLINE ke queue ini
+    void setEventQueue(QueueHandle_t queue);
+
+    void start(bool circulation);
+    void setCirculation(bool circulation);   // Ganti AUTO ↔ AUTO_CIRCULATION tanpa reset batch
+    void update();
+    void stop();
+
+    // ===== CHECKPOINT =====
+    void fillCheckpoint(FsmCheckpoint& checkpoint);
+    // Dipakai start() berikutnya: lanjut batch/jadwal dari checkpoint
+    void setResume(const FsmCheckpoint& checkpoint, uint32_t ageS);
+
+    AutoStage getStage() const;
+    bool isRunning() const;
+    const char* stageName(AutoStage stage) const;
+    AutoCycleStats getStats() const;
+
+    // ===== DEBUG =====
+    void printStatus();
+
+private:
+    // Dependencies
+    StateConditionHandler* conditionHandler;
+    ActuatorControl* actuator;
+    SensorManager* sensor;
+    NextionOutput* nextion;
+    SystemStorage* systemStorage;
+    RTCManager* rtcManager;
+    RecipeStore* recipeStore;
+
+    RecipeRunner runner;
+    PreCoolPlanner planner;
+
+    AutoStage stage;
+    bool circulationEnabled;
+    uint8_t retryCount;
+    uint8_t faultedStep;         // Step recipe yang diulang setelah FAULT
+    bool stepFaulted;            // Step aktif pernah FAULT → durasinya tidak dipelajari
+
+    uint32_t lastReadyTime;      // Unix jam siap (setAuto) batch terakhir, 0 = belum pernah
+    uint16_t batchRecipeCrc;     // Recipe snapshot batch aktif (checkpoint)
+    uint32_t plannedStart;       // Unix start hasil plan terakhir (log hanya saat berubah)
+    uint64_t batchStartMs;
+    float coolStartTemp;         // Suhu saat step COOL pertama mulai
+    bool readyReached;
+
+    Timer scheduleTimer;         // Re-plan berkala; start sendiri lewat alarm RTC
+    
+    // Resume setelah reset (diisi setResume, dipakai start)
+    bool resumePending;
+    FsmCheckpoint resumePoint;
+    uint32_t resumeAgeS;
+    Timer retryTimer;
+
+    AutoCycleStats stats;
+
+    // Stage handling
+    void enterStage(AutoStage next);
+    void startBatch(uint32_t readyTime);
+    bool resumeBatch();
+    void fault();
+    void completeBatch();
+    void abortBatch(const char* reason);
+
+    void updateWaitSchedule();
+    void updateRunning();
+    void updateFault();
+    void onStepFinished(RecipeOp op, uint8_t index);
+
+    // Schedule
+    uint32_t nextReadyTime(uint32_t now);
+    uint32_t planLeadSeconds(const RecipeProgram& program);
+    bool parseAutoTime(uint8_t &hour, uint8_t &minute);
+};
+
+#endif
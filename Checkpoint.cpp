@@ -0,0 +1,188 @@
+// Checkpoint.cpp
+#include "Checkpoint.h"
+#include "Logger.h"
+#include <esp_attr.h>
+#include <esp_system.h>
+
+static const char* NVS_NAMESPACE = "checkpoint";
+static const char* NVS_KEY_CHECKPOINT = "cp";
+
+static_assert(sizeof(FsmCheckpoint) == 40, "FsmCheckpoint layout berubah - naikkan CHECKPOINT_VERSION");
+
+// Tidak di-init ulang oleh startup code: isi dari sebelum reset masih ada
+// (hilang saat power-on; mirror NVS yang menutup kasus itu)
+RTC_NOINIT_ATTR static FsmCheckpoint rtcCheckpoint;
+
+// ===== CONSTRUCTOR / DESTRUCTOR =====
+
+CheckpointStore::CheckpointStore(RTCManager* rtc)
+    : rtcManager(rtc)
+    , restored()
+    , loaded(false)
+    , sequence(0)
+    , resetReason(ESP_RST_UNKNOWN)
+    , pending()
+    , nvsPending(false)
+    , nvsForce(false)
+    , lastNvsMs(0)
+{
+    mutex = xSemaphoreCreateMutexStatic(&mutexBuffer);
+    TimerService::initFlag(retryTimer);
+}
+
+CheckpointStore::~CheckpointStore() {
+    if (mutex) vSemaphoreDelete(mutex);
+}
+
+// ===== PUBLIC API =====
+
+void CheckpointStore::begin() {
+    resetReason = esp_reset_reason();
+    prefs.begin(NVS_NAMESPACE, false);
+
+    FsmCheckpoint fromNvs = FsmCheckpoint();
+    bool nvsValid = prefs.getBytesLength(NVS_KEY_CHECKPOINT) == sizeof(fromNvs) &&
+                    prefs.getBytes(NVS_KEY_CHECKPOINT, &fromNvs, sizeof(fromNvs)) == sizeof(fromNvs) &&
+                    isValid(fromNvs);
+    bool rtcValid = isValid(rtcCheckpoint);
+
+    lock();
+    if (rtcValid && (!nvsValid || rtcCheckpoint.sequence >= fromNvs.sequence)) {
+        restored = rtcCheckpoint;
+        loaded = true;
+    } else if (nvsValid) {
+        restored = fromNvs;
+        loaded = true;
+    }
+    sequence = loaded ? restored.sequence : 0;
+    unlock();
+
+    if (loaded) {
+        LOG_I("CHECKPOINT", "Reset %s: checkpoint #%lu from %s (state %u, step %u)",
+              resetReasonName(), (unsigned long)restored.sequence,
+              (rtcValid && restored.sequence == rtcCheckpoint.sequence) ? "RTC memory" : "NVS",
+              restored.state, restored.stepIndex + 1);
+    } else {
+        LOG_I("CHECKPOINT", "Reset %s: no checkpoint", resetReasonName());
+    }
+}
+
+void CheckpointStore::save(FsmCheckpoint& checkpoint, bool transition) {
+    checkpoint.magic = CHECKPOINT_MAGIC;
+    checkpoint.version = CHECKPOINT_VERSION;
+    checkpoint.savedUnix = (rtcManager && rtcManager->isRTCValid()) ? rtcManager->getUnixTime() : 0;
+
+    lock();
+    checkpoint.sequence = ++sequence;
+    checkpoint.crc = crc16(&checkpoint, offsetof(FsmCheckpoint, crc));
+
+    // RTC memory: hanya memcpy, aman dari FSM task
+    rtcCheckpoint = checkpoint;
+
+    pending = checkpoint;
+    nvsPending = true;
+    if (transition) nvsForce = true;
+    unlock();
+}
+
+// Tulis flash di task prioritas rendah; transisi langsung, progress dibatasi interval
+void CheckpointStore::flush() {
+    if (TimerService::isArmed(retryTimer)) return;
+
+    uint64_t now = TimerService::nowMs();
+
+    lock();
+    bool due = nvsPending && (nvsForce || now - lastNvsMs >= CHECKPOINT_NVS_INTERVAL_MS);
+    bool force = nvsForce;
+    FsmCheckpoint record = pending;
+    if (due) {
+        nvsPending = false;
+        nvsForce = false;
+        lastNvsMs = now;
+    }
+    unlock();
+
+    if (!due) return;
+
+    if (prefs.putBytes(NVS_KEY_CHECKPOINT, &record, sizeof(record)) != sizeof(record)) {
+        LOG_E("CHECKPOINT", "NVS write failed - retry in %lums", (unsigned long)CHECKPOINT_NVS_RETRY_MS);
+        // Transisi tetap dicoba ulang lebih cepat dari interval, tapi tidak
+        // tiap putaran loop(); save() baru di antaranya tetap menang (pending)
+        lock();
+        nvsPending = true;
+        if (force) nvsForce = true;
+        unlock();
+        timerService.arm(retryTimer, CHECKPOINT_NVS_RETRY_MS);
+    }
+}
+
+// ===== RESUME =====
+
+uint32_t CheckpointStore::getAgeS() {
+    if (!loaded || restored.savedUnix == 0 || !rtcManager || !rtcManager->isRTCValid()) {
+        return CHECKPOINT_AGE_UNKNOWN;
+    }
+
+    uint32_t now = rtcManager->getUnixTime();
+    return now >= restored.savedUnix ? now - restored.savedUnix : CHECKPOINT_AGE_UNKNOWN;
+}
+
+const char* CheckpointStore::checkResume(bool needsTemperature, const SensorData& data) {
+    if (!loaded) return "no checkpoint";
+
+    // Tanpa jam yang bisa dipercaya progress step (waktu, jadwal) tidak berarti
+    uint32_t age = getAgeS();
+    if (age == CHECKPOINT_AGE_UNKNOWN) return "checkpoint age unknown (RTC)";
+    if (age > CHECKPOINT_MAX_AGE_S) return "checkpoint too old";
+
+    if (needsTemperature && !data.tempValid) return "temperature sensor invalid";
+
+    return nullptr;
+}
+
+const char* CheckpointStore::resetReasonName() const {
+    switch (resetReason) {
+        case ESP_RST_POWERON:  return "POWER_ON";
+        case ESP_RST_EXT:      return "EXTERNAL";
+        case ESP_RST_SW:       return "SOFTWARE";
+        case ESP_RST_PANIC:    return "PANIC";
+        case ESP_RST_INT_WDT:  return "INT_WDT";
+        case ESP_RST_TASK_WDT: return "TASK_WDT";
+        case ESP_RST_WDT:      return "WDT";
+        case ESP_RST_BROWNOUT: return "BROWNOUT";
+        default:               return "UNKNOWN";
+    }
+}
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), sama dengan frame logger
+uint16_t CheckpointStore::crc16(const void* data, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= static_cast<uint16_t>(bytes[i]) << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+// ===== PRIVATE =====
+
+bool CheckpointStore::isValid(const FsmCheckpoint& checkpoint) const {
+    return checkpoint.magic == CHECKPOINT_MAGIC &&
+           checkpoint.version == CHECKPOINT_VERSION &&
+           checkpoint.crc == crc16(&checkpoint, offsetof(FsmCheckpoint, crc));
+}
+
+void CheckpointStore::lock() {
+    if (mutex) {
+        xSemaphoreTake(mutex, portMAX_DELAY);
+    }
+}
+
+void CheckpointStore::unlock() {
+    if (mutex) {
+        xSemaphoreGive(mutex);
+    }
+}
@@ -0,0 +1,98 @@
+// Checkpoint.h
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "RTCManager.h"
+#include "SensorManager.h"
+#include "TimerService.h"
+
+// ===== CHECKPOINT CONFIG =====
+#define CHECKPOINT_MAGIC          0x49434B50UL   // "ICKP"
+#define CHECKPOINT_VERSION        1
+#define CHECKPOINT_INTERVAL_MS    10000UL        // Progress step → RTC memory
+#define CHECKPOINT_NVS_INTERVAL_MS (5UL * 60 * 1000)   // Mirror NVS (power loss) di luar transisi
+#define CHECKPOINT_MAX_AGE_S      600            // Lebih tua dari ini tidak di-resume
+#define CHECKPOINT_SENSOR_WAIT_MS 5000           // Tunggu sampel sensor valid sebelum resume
+#define CHECKPOINT_NVS_RETRY_MS   5000           // Jeda sebelum tulis NVS diulang setelah gagal
+#define CHECKPOINT_AGE_UNKNOWN    0xFFFFFFFFUL
+
+// Tombol panel yang aktif (NextionData) saat checkpoint
+#define CP_UI_FILLING             0x01
+#define CP_UI_COOLING             0x02
+#define CP_UI_DRAINING            0x04
+#define CP_UI_AUTO                0x08
+#define CP_UI_CIRCULATION         0x10
+
+struct FsmCheckpoint {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t state;              // SystemState
+    uint8_t uiFlags;            // CP_UI_*
+    uint8_t autoStage;          // AutoStage
+    uint8_t stepIndex;          // Step recipe aktif (AUTO_RUNNING / AUTO_FAULT)
+    uint8_t reserved;
+    uint16_t recipeCrc;         // Resume hanya jika recipe masih sama
+    uint32_t sequence;          // Naik tiap simpan: RTC vs NVS → ambil yang terbaru
+    uint32_t savedUnix;         // Jam RTC saat disimpan (umur checkpoint)
+    uint32_t readyUnix;         // AutoCycle: jam siap batch terakhir (jadwal interval hari)
+    uint32_t stepElapsedS;      // Step aktif sudah berjalan (COOL: sejak cooling mulai)
+    uint32_t compressorOffAgeS; // Sejak compressor OFF, CHECKPOINT_AGE_UNKNOWN = tidak ada
+    float stepLiters;           // Volume step FILL/DRAIN/TDS yang sudah dipindah
+    uint16_t reserved2;
+    uint16_t crc;               // CRC-16 semua field sebelumnya
+};
+
+// ===== CHECKPOINT STORE CLASS =====
+// Checkpoint FSM ditulis ke RTC slow memory (RTC_NOINIT, bertahan saat
+// brownout/watchdog/panic reset) pada setiap transisi dan tiap
+// CHECKPOINT_INTERVAL_MS. Mirror NVS (bertahan saat listrik mati) ditulis saat
+// transisi dan paling sering tiap CHECKPOINT_NVS_INTERVAL_MS, dari loop().
+// Saat boot keduanya dibaca; yang valid dengan sequence terbesar dipakai.
+class CheckpointStore {
+public:
+    CheckpointStore(RTCManager* rtc);
+    ~CheckpointStore();
+
+    void begin();
+
+    // transition: tulis mirror NVS juga (di flush() berikutnya)
+    void save(FsmCheckpoint& checkpoint, bool transition);
+    void flush();                               // Dipanggil dari loop()
+
+    // ===== RESUME =====
+    bool hasCheckpoint() const { return loaded; }
+    const FsmCheckpoint& getCheckpoint() const { return restored; }
+    uint32_t getAgeS();                         // Sejak disimpan, CHECKPOINT_AGE_UNKNOWN tanpa RTC
+    // Kebijakan resume: nullptr = boleh, selain itu alasan fallback ke IDLE
+    // (recipe batch dicek AutoCycle: hanya relevan untuk AUTO yang sedang jalan)
+    const char* checkResume(bool needsTemperature, const SensorData& data);
+    const char* resetReasonName() const;
+
+    static uint16_t crc16(const void* data, size_t length);
+
+private:
+    RTCManager* rtcManager;
+    Preferences prefs;
+
+    FsmCheckpoint restored;     // Hasil load saat boot
+    bool loaded;
+    uint32_t sequence;
+    int resetReason;            // esp_reset_reason_t
+
+    FsmCheckpoint pending;      // Menunggu ditulis ke NVS
+    bool nvsPending;
+    bool nvsForce;              // Transisi: tulis tanpa menunggu interval
+    uint64_t lastNvsMs;
+    Timer retryTimer;           // Armed = tulis terakhir gagal, tunggu sebelum coba lagi
+
+    SemaphoreHandle_t mutex;
+    StaticSemaphore_t mutexBuffer;
+
+    bool isValid(const FsmCheckpoint& checkpoint) const;
+    void lock();
+    void unlock();
+};
+
+#endif
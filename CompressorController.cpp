@@ -0,0 +1,277 @@
+// CompressorController.cpp
+#include "CompressorController.h"
+#include "Logger.h"
+
+// Nilai awal model sebelum ada data (tangki ± 50 L, compressor kecil)
+static const CompressorModel DEFAULT_MODEL = {
+    0.10f,      // coolRate  °C/menit
+    0.02f,      // gainRate  °C/menit
+    0.30f,      // coastDown °C
+    0.20f       // coastUp   °C
+};
+
+static const float COAST_TURN_C = 0.1f;        // Suhu berbalik arah → coast selesai
+static const float RATE_MIN = 0.005f;
+static const float RATE_MAX = 5.0f;
+static const float COAST_MAX = 3.0f;
+static const float MODEL_RANGE_C = 3.0f;       // Model linear hanya valid dekat setpoint
+
+static float learn(float current, float observed, float minValue, float maxValue) {
+    if (observed < minValue) observed = minValue;
+    if (observed > maxValue) observed = maxValue;
+    return current + COMP_LEARN_ALPHA * (observed - current);
+}
+
+// ===== CONSTRUCTOR / DESTRUCTOR =====
+
+CompressorController::CompressorController(ActuatorControl* actuators)
+    : actuator(actuators)
+    , running(false)
+    , compressorOn(false)
+    , holding(false)
+    , target(0)
+    , phaseStartMs(0)
+    , lastOffMs(0)
+    , minOffMs(COMP_MIN_OFF_MS)
+    , phaseStartTemp(0)
+    , phaseExtremeTemp(0)
+    , coastTracking(false)
+    , slopeTemp()
+    , slopeTimeMs()
+    , slopeHead(0)
+    , slopeCount(0)
+    , model(DEFAULT_MODEL)
+    , trackingSumSq(0)
+    , trackingSamples(0)
+    , trackingMax(0)
+    , startTimes()
+    , startHead(0)
+    , starts(0)
+{
+    TimerService::initFlag(sampleTimer);
+    TimerService::initFlag(minOffTimer);
+}
+
+CompressorController::~CompressorController() {
+    timerService.cancel(sampleTimer);
+    timerService.cancel(minOffTimer);
+}
+
+void CompressorController::setEventQueue(QueueHandle_t queue) {
+    TimerService::initEvent(sampleTimer, queue, FsmEvent::EV_DEADLINE);
+    TimerService::initEvent(minOffTimer, queue, FsmEvent::EV_DEADLINE);
+}
+
+// ===== PUBLIC API =====
+
+void CompressorController::start(uint8_t targetTemp) {
+    target = targetTemp;
+    running = true;
+    holding = false;
+    trackingSumSq = 0;
+    trackingSamples = 0;
+    trackingMax = 0;
+    slopeCount = 0;
+
+    timerService.armPeriodic(sampleTimer, COMP_SAMPLE_MS);
+}
+
+void CompressorController::update(const SensorData& data) {
+    if (!running) return;
+
+    // Tanpa suhu valid tidak ada prediksi - compressor OFF (aman untuk tangki)
+    if (!data.tempValid) {
+        if (compressorOn) {
+            LOG_W("COMPRESSOR", "Temperature invalid - compressor OFF");
+            switchCompressor(false, data.temperature);
+        }
+        return;
+    }
+
+    float temperature = data.temperature;
+
+    if (timerService.consumeExpired(sampleTimer)) {
+        sample(temperature);
+    }
+    learnCoast(temperature);
+
+    if (temperature <= target) {
+        holding = true;
+    }
+
+    uint64_t now = TimerService::nowMs();
+    float lookaheadMin = COMP_SAMPLE_MS / 60000.0f;   // Sampai evaluasi terjamin berikutnya
+
+    if (compressorOn) {
+        // Prediksi titik terendah jika OFF sekarang: laju sampai sampel berikut + coast
+        float predicted = temperature - model.coolRate * lookaheadMin - model.coastDown;
+
+        if (now - phaseStartMs >= COMP_MIN_ON_MS && predicted <= target - COMP_HOLD_BAND_C) {
+            LOG_I("COMPRESSOR", "OFF at %.2f°C (predicted min %.2f°C)", temperature, predicted);
+            switchCompressor(false, temperature);
+        }
+    } else {
+        // Min-off belum lewat: minOffTimer membangunkan FSM saat boleh start
+        if (lastOffMs != 0 && now - lastOffMs < minOffMs) return;
+
+        // Prediksi puncak jika ON sekarang: heat gain sampai sampel berikut + coast
+        float predicted = temperature + model.gainRate * lookaheadMin + model.coastUp;
+
+        if (predicted >= target) {
+            LOG_I("COMPRESSOR", "ON at %.2f°C (predicted peak %.2f°C)", temperature, predicted);
+            switchCompressor(true, temperature);
+        }
+    }
+}
+
+void CompressorController::stop() {
+    if (compressorOn) {
+        switchCompressor(false, phaseExtremeTemp);
+    }
+
+    running = false;
+    coastTracking = false;
+    timerService.cancel(sampleTimer);
+    timerService.cancel(minOffTimer);
+}
+
+bool CompressorController::isCompressorOn() const {
+    return compressorOn;
+}
+
+bool CompressorController::getOffAgeMs(uint32_t& ageMs) const {
+    if (compressorOn) {
+        ageMs = 0;
+        return true;
+    }
+    if (lastOffMs == 0) return false;
+    ageMs = static_cast<uint32_t>(TimerService::nowMs() - lastOffMs);
+    return true;
+}
+
+void CompressorController::restoreOffAge(uint32_t ageMs) {
+    if (ageMs >= COMP_MIN_OFF_MS) return;
+
+    // Jam boot dimulai dari 0: OFF dianggap sekarang dengan window yang dipendekkan
+    uint64_t now = TimerService::nowMs();
+    lastOffMs = now ? now : 1;
+    minOffMs = COMP_MIN_OFF_MS - ageMs;
+    timerService.arm(minOffTimer, minOffMs);
+    LOG_I("COMPRESSOR", "Off %lus before reset - holding off %lus more",
+          (unsigned long)(ageMs / 1000), (unsigned long)(minOffMs / 1000));
+}
+
+CompressorMetrics CompressorController::getMetrics() {
+    CompressorMetrics metrics;
+    uint64_t now = TimerService::nowMs();
+
+    metrics.model = model;
+    metrics.trackingRmsC = trackingSamples ? sqrtf(trackingSumSq / trackingSamples) : 0;
+    metrics.trackingMaxC = trackingMax;
+    metrics.starts = starts;
+
+    uint8_t recent = 0;
+    for (uint8_t i = 0; i < COMP_STARTS_WINDOW; i++) {
+        if (startTimes[i] != 0 && now - startTimes[i] < 3600000ULL) recent++;
+    }
+    metrics.startsPerHour = recent;
+
+    return metrics;
+}
+
+// ===== DEBUG =====
+
+void CompressorController::printMetrics() {
+    CompressorMetrics m = getMetrics();
+
+    LOG_I("COMPRESSOR", "Model: cool %.3f°C/min, gain %.3f°C/min, coast -%.2f/+%.2f°C",
+          m.model.coolRate, m.model.gainRate, m.model.coastDown, m.model.coastUp);
+    LOG_I("COMPRESSOR", "Tracking RMS %.2f°C max %.2f°C, starts %.0f/h (total %lu)",
+          m.trackingRmsC, m.trackingMaxC, m.startsPerHour, (unsigned long)m.starts);
+}
+
+// ===== PRIVATE =====
+
+void CompressorController::switchCompressor(bool on, float temperature) {
+    uint64_t now = TimerService::nowMs();
+
+    actuator->setCompressor(on);
+    compressorOn = on;
+
+    phaseStartMs = now;
+    phaseStartTemp = temperature;
+    phaseExtremeTemp = temperature;
+    coastTracking = true;
+    slopeCount = 0;     // Window slope tidak boleh melintasi switch
+
+    if (on) {
+        startTimes[startHead] = now;
+        startHead = (startHead + 1) % COMP_STARTS_WINDOW;
+        starts++;
+    } else {
+        lastOffMs = now;
+        minOffMs = COMP_MIN_OFF_MS;
+        timerService.arm(minOffTimer, minOffMs);
+    }
+}
+
+void CompressorController::sample(float temperature) {
+    uint64_t now = TimerService::nowMs();
+
+    // ===== TRACKING ERROR =====
+    if (holding) {
+        float error = temperature - setpoint();
+        trackingSumSq += error * error;
+        trackingSamples++;
+        if (fabsf(error) > trackingMax) trackingMax = fabsf(error);
+    }
+
+    // ===== SLOPE WINDOW =====
+    slopeTemp[slopeHead] = temperature;
+    slopeTimeMs[slopeHead] = now;
+    slopeHead = (slopeHead + 1) % COMP_SLOPE_SAMPLES;
+    if (slopeCount < COMP_SLOPE_SAMPLES) slopeCount++;
+
+    if (slopeCount < COMP_SLOPE_SAMPLES) return;
+
+    // Sampel tertua = slot berikutnya yang akan ditimpa
+    uint64_t oldestMs = slopeTimeMs[slopeHead];
+    if (oldestMs < phaseStartMs + COMP_DEAD_TIME_MS || now <= oldestMs) return;
+
+    if (fabsf(temperature - target) > MODEL_RANGE_C) return;
+
+    float slope = (temperature - slopeTemp[slopeHead]) / ((now - oldestMs) / 60000.0f);
+
+    if (compressorOn && slope < 0) {
+        model.coolRate = learn(model.coolRate, -slope, RATE_MIN, RATE_MAX);
+    } else if (!compressorOn && slope > 0) {
+        model.gainRate = learn(model.gainRate, slope, RATE_MIN, RATE_MAX);
+    }
+}
+
+void CompressorController::learnCoast(float temperature) {
+    // Coast saat pull-down awal tidak mewakili perilaku di sekitar setpoint
+    if (!coastTracking || !holding) return;
+
+    if (compressorOn) {
+        // Setelah ON suhu masih naik sebentar; puncaknya = coastUp
+        if (temperature > phaseExtremeTemp) {
+            phaseExtremeTemp = temperature;
+        } else if (temperature < phaseExtremeTemp - COAST_TURN_C) {
+            model.coastUp = learn(model.coastUp, phaseExtremeTemp - phaseStartTemp, 0, COAST_MAX);
+            coastTracking = false;
+        }
+    } else {
+        // Setelah OFF suhu masih turun sebentar; lembahnya = coastDown
+        if (temperature < phaseExtremeTemp) {
+            phaseExtremeTemp = temperature;
+        } else if (temperature > phaseExtremeTemp + COAST_TURN_C) {
+            model.coastDown = learn(model.coastDown, phaseStartTemp - phaseExtremeTemp, 0, COAST_MAX);
+            coastTracking = false;
+        }
+    }
+}
+
+float CompressorController::setpoint() const {
+    return target - COMP_HOLD_BAND_C / 2;
+}
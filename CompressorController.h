@@ -0,0 +1,102 @@
+// CompressorController.h
+#ifndef COMPRESSOR_CONTROLLER_H
+#define COMPRESSOR_CONTROLLER_H
+
+#include <Arduino.h>
+#include "ActuatorControl.h"
+#include "SensorManager.h"
+#include "TimerService.h"
+
+// ===== CONTROL CONFIG =====
+#define COMP_SAMPLE_MS            10000UL   // Sampling model + evaluasi minimal tiap 10 s
+#define COMP_SLOPE_SAMPLES        7         // Slope dari 6 interval = 60 s
+#define COMP_DEAD_TIME_MS         60000UL   // Sampel awal fase diabaikan (evaporator/lag sensor)
+#define COMP_MIN_OFF_MS           (3UL * 60 * 1000)   // Proteksi compressor: tekanan equalize dulu
+#define COMP_MIN_ON_MS            (2UL * 60 * 1000)
+#define COMP_HOLD_BAND_C          1.0f      // Hold di [target - band, target]
+#define COMP_LEARN_ALPHA          0.2f      // EWMA parameter model
+#define COMP_STARTS_WINDOW        16        // Ring start time untuk starts/jam
+
+// Model linear di sekitar setpoint: laju per fase + coast (lag) setelah switch
+struct CompressorModel {
+    float coolRate;             // °C/menit turun saat compressor ON
+    float gainRate;             // °C/menit naik saat compressor OFF (heat gain)
+    float coastDown;            // °C masih turun setelah OFF
+    float coastUp;              // °C masih naik setelah ON
+};
+
+struct CompressorMetrics {
+    CompressorModel model;
+    float trackingRmsC;         // RMS (T - setpoint) selama hold
+    float trackingMaxC;         // |T - setpoint| terbesar selama hold
+    float startsPerHour;        // Start dalam 60 menit terakhir
+    uint32_t starts;            // Total start sejak boot
+};
+
+// ===== COMPRESSOR CONTROLLER CLASS =====
+// Menggantikan bang-bang + tunggu 10 menit: model thermal dipelajari online,
+// compressor ON/OFF diputuskan dari prediksi suhu (laju + coast), dengan
+// minimum off/on time. Model tetap tersimpan antar sesi cooling.
+class CompressorController {
+public:
+    CompressorController(ActuatorControl* actuators);
+    ~CompressorController();
+
+    // Timer sampling/min-off mem-post EV_DEADLINE ke queue ini
+    void setEventQueue(QueueHandle_t queue);
+
+    void start(uint8_t targetTemp);
+    void update(const SensorData& data);
+    void stop();
+
+    bool isCompressorOn() const;
+    CompressorMetrics getMetrics();
+
+    // ===== RESET RECOVERY =====
+    bool getOffAgeMs(uint32_t& ageMs) const;    // ON = 0 (reset mematikannya); false = belum pernah jalan
+    void restoreOffAge(uint32_t ageMs);         // OFF sebelum reset: sisa min-off tetap ditunggu
+
+    // ===== DEBUG =====
+    void printMetrics();
+
+private:
+    ActuatorControl* actuator;
+
+    bool running;
+    bool compressorOn;
+    bool holding;               // Target sudah tercapai sekali → hitung tracking error
+    uint8_t target;
+
+    uint64_t phaseStartMs;      // Waktu switch ON/OFF terakhir
+    uint64_t lastOffMs;         // Untuk min-off lintas sesi
+    uint32_t minOffMs;          // COMP_MIN_OFF_MS, atau sisa min-off setelah reset
+    float phaseStartTemp;
+    float phaseExtremeTemp;     // Min (setelah OFF) / max (setelah ON) untuk belajar coast
+    bool coastTracking;
+
+    // Slope window
+    float slopeTemp[COMP_SLOPE_SAMPLES];
+    uint64_t slopeTimeMs[COMP_SLOPE_SAMPLES];
+    uint8_t slopeHead;
+    uint8_t slopeCount;
+
+    CompressorModel model;
+
+    // Metrics
+    float trackingSumSq;
+    uint32_t trackingSamples;
+    float trackingMax;
+    uint64_t startTimes[COMP_STARTS_WINDOW];
+    uint8_t startHead;
+    uint32_t starts;
+
+    Timer sampleTimer;
+    Timer minOffTimer;
+
+    void switchCompressor(bool on, float temperature);
+    void sample(float temperature);
+    void learnCoast(float temperature);
+    float setpoint() const;
+};
+
+#endif
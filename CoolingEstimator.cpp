@@ -0,0 +1,118 @@
+// CoolingEstimator.cpp
+#include "CoolingEstimator.h"
+
+static const float P_INITIAL = 100.0f;            // Prior lemah: a, b belum diketahui
+static const float RESIDUAL_ALPHA = 0.1f;
+static const float RESIDUAL_INITIAL = 0.0003f;    // ≈ noise kuantisasi DS18B20 (0.0625²/12)
+static const float GRAD_EPS_A = 1e-4f;
+static const float GRAD_EPS_B = 1e-3f;
+
+// ===== CONSTRUCTOR =====
+
+CoolingEstimator::CoolingEstimator() {
+    reset(0);
+}
+
+// ===== PUBLIC API =====
+
+void CoolingEstimator::reset(uint8_t targetTemp) {
+    target = targetTemp;
+    a = 1.0f;           // Tanpa data: suhu dianggap tetap
+    b = 0.0f;
+    p11 = P_INITIAL;
+    p12 = 0.0f;
+    p22 = P_INITIAL;
+    residualVar = RESIDUAL_INITIAL;
+    lastTemp = 0.0f;
+    hasLast = false;
+    pairNext = false;
+    samples = 0;
+}
+
+void CoolingEstimator::addSample(float temperature) {
+    // Dipusatkan di target: kondisi numerik float lebih baik, Te < 0 ↔ target tercapai
+    float x = temperature - target;
+
+    if (hasLast && pairNext) {
+        float phi1 = lastTemp;      // Regressor [T[k], 1] → T[k+1]
+
+        float pp1 = p11 * phi1 + p12;
+        float pp2 = p12 * phi1 + p22;
+        float denom = ETA_FORGETTING + phi1 * pp1 + pp2;
+        float k1 = pp1 / denom;
+        float k2 = pp2 / denom;
+
+        float error = x - (a * phi1 + b);
+        a += k1 * error;
+        b += k2 * error;
+
+        p11 = (p11 - k1 * pp1) / ETA_FORGETTING;
+        p12 = (p12 - k1 * pp2) / ETA_FORGETTING;
+        p22 = (p22 - k2 * pp2) / ETA_FORGETTING;
+
+        residualVar += RESIDUAL_ALPHA * (error * error - residualVar);
+        if (samples < 0xFFFF) samples++;
+    }
+
+    lastTemp = x;
+    hasLast = true;
+    pairNext = true;
+}
+
+void CoolingEstimator::breakSequence() {
+    pairNext = false;
+}
+
+CoolingEta CoolingEstimator::getEstimate() const {
+    CoolingEta eta = { false, 0, 0, 0.0f };
+
+    if (hasLast && lastTemp <= 0.0f) {
+        // Sudah di/di bawah target
+        eta.valid = true;
+        eta.asymptoteC = (a < 1.0f) ? target + b / (1.0f - a) : target;
+        return eta;
+    }
+
+    if (samples < ETA_MIN_SAMPLES) return eta;
+
+    float n = etaSamples(a, b, lastTemp);
+    if (n < 0) return eta;
+
+    // Delta method: var(n) ≈ σ² · gᵀ P g, g = ∂n/∂(a, b) numerik
+    float na1 = etaSamples(a + GRAD_EPS_A, b, lastTemp);
+    float na0 = etaSamples(a - GRAD_EPS_A, b, lastTemp);
+    float nb1 = etaSamples(a, b + GRAD_EPS_B, lastTemp);
+    float nb0 = etaSamples(a, b - GRAD_EPS_B, lastTemp);
+
+    float sampleMinutes = ETA_SAMPLE_MS / 60000.0f;
+    float minutes = n * sampleMinutes;
+    float margin = ETA_MAX_MINUTES;
+
+    if (na1 >= 0 && na0 >= 0 && nb1 >= 0 && nb0 >= 0) {
+        float ga = (na1 - na0) / (2 * GRAD_EPS_A);
+        float gb = (nb1 - nb0) / (2 * GRAD_EPS_B);
+        float variance = residualVar * (ga * ga * p11 + 2 * ga * gb * p12 + gb * gb * p22);
+        if (variance >= 0) {
+            margin = ETA_CONFIDENCE_Z * sqrtf(variance) * sampleMinutes;
+        }
+    }
+
+    eta.valid = true;
+    eta.minutes = minutes > ETA_MAX_MINUTES ? ETA_MAX_MINUTES : static_cast<uint16_t>(minutes + 0.5f);
+    eta.marginMinutes = margin > ETA_MAX_MINUTES ? ETA_MAX_MINUTES : static_cast<uint16_t>(margin + 0.5f);
+    eta.asymptoteC = target + b / (1.0f - a);
+    return eta;
+}
+
+// ===== PRIVATE =====
+
+// Jumlah sampel sampai x = 0 (target); -1 jika model tidak pernah mencapai target
+float CoolingEstimator::etaSamples(float fa, float fb, float temperature) const {
+    if (fa <= 0.0f || fa >= 1.0f) return -1;
+
+    float asymptote = fb / (1.0f - fa);
+    if (asymptote >= 0.0f || temperature <= asymptote) return -1;
+
+    // x(n) - Te = (x0 - Te)·aⁿ  →  n = ln(-Te / (x0 - Te)) / ln(a)
+    return logf(-asymptote / (temperature - asymptote)) / logf(fa);
+}
@@ -0,0 +1,52 @@
+// CoolingEstimator.h
+#ifndef COOLING_ESTIMATOR_H
+#define COOLING_ESTIMATOR_H
+
+#include <Arduino.h>
+
+// ===== ESTIMATOR CONFIG =====
+#define ETA_SAMPLE_MS           30000UL   // 30 s: perubahan suhu > resolusi DS18B20 (0.0625°C)
+#define ETA_FORGETTING          0.97f     // RLS forgetting factor (~30 sampel efektif)
+#define ETA_MIN_SAMPLES         6         // Sebelum ini ETA belum dilaporkan
+#define ETA_CONFIDENCE_Z        1.96f     // Interval ±95%
+#define ETA_MAX_MINUTES         999
+
+struct CoolingEta {
+    bool valid;                 // false = masih mengumpulkan data / model tidak konvergen
+    uint16_t minutes;           // Perkiraan sisa waktu ke coolingTarget
+    uint16_t marginMinutes;     // ± interval kepercayaan
+    float asymptoteC;           // Suhu evaporator/asimtot hasil fit
+};
+
+// ===== COOLING ETA ESTIMATOR =====
+// Model pendinginan eksponensial T(t) = Te + (T0 - Te)·e^(-t/τ), didiskretkan
+// per sampel: T[k+1] = a·T[k] + b, a = e^(-Δt/τ), Te = b / (1 - a).
+// (a, b) di-fit dengan recursive least squares 2 parameter: memori tetap,
+// O(1) per sampel. Interval kepercayaan dari kovarians RLS (delta method).
+class CoolingEstimator {
+public:
+    CoolingEstimator();
+
+    void reset(uint8_t targetTemp);
+    void addSample(float temperature);  // Hanya saat compressor ON, tiap ETA_SAMPLE_MS
+    void breakSequence();               // Compressor OFF: sampel berikut tidak dipasangkan dengan yang lama
+
+    CoolingEta getEstimate() const;
+
+private:
+    float target;
+
+    // RLS state: theta = [a, b], P = kovarians (simetris 2x2)
+    float a, b;
+    float p11, p12, p22;
+    float residualVar;          // EWMA residual² (σ²)
+
+    float lastTemp;
+    bool hasLast;
+    bool pairNext;
+    uint16_t samples;
+
+    float etaSamples(float fa, float fb, float temperature) const;
+};
+
+#endif
@@ -0,0 +1,235 @@
+// DoseController.cpp
+#include "DoseController.h"
+#include "Logger.h"
+
+static const float MS_PER_MIN = 60000.0f;
+static const float MS_PER_HOUR = 3600000.0f;
+
+// ===== CONSTRUCTOR / DESTRUCTOR =====
+
+DoseController::DoseController(ActuatorControl* actuators, SensorManager* sensors)
+    : actuator(actuators)
+    , sensor(sensors)
+    , active(false)
+    , uvEnabled(false)
+    , ozoneEnabled(false)
+    , pumpControlled(false)
+    , complete(false)
+    , uvLiters(0)
+    , uvTargetLiters(0)
+    , ozoneMg(0)
+    , ozoneTargetMg(0)
+    , ozoneOn(false)
+    , ozonePaused(false)
+    , ozoneDuty(0)
+    , ozoneOffMs(0)
+    , budgetMs(0)
+    , startMs(0)
+    , lastUpdateMs(0)
+    , noFlowSinceMs(0)
+    , noFlowWarned(false)
+{
+    TimerService::initFlag(windowTimer);
+}
+
+DoseController::~DoseController() {
+    timerService.cancel(windowTimer);
+}
+
+void DoseController::setEventQueue(QueueHandle_t queue) {
+    TimerService::initEvent(windowTimer, queue, FsmEvent::EV_DEADLINE);
+}
+
+// ===== PUBLIC API =====
+
+void DoseController::start(float tankLiters, bool uv, bool ozone, bool controlPump, uint32_t budget) {
+    if (tankLiters <= 0) tankLiters = DOSE_DEFAULT_TANK_L;
+
+    active = true;
+    complete = false;
+    uvEnabled = uv;
+    ozoneEnabled = ozone;
+    pumpControlled = controlPump;
+
+    uvLiters = 0;
+    uvTargetLiters = uv ? DOSE_UV_TURNOVERS * tankLiters : 0;
+    ozoneMg = 0;
+    ozoneTargetMg = ozone ? DOSE_OZONE_MG_L * tankLiters : 0;
+
+    ozoneOn = false;
+    ozonePaused = false;
+    ozoneDuty = 0;
+    ozoneOffMs = 0;
+    budgetMs = budget;
+    startMs = TimerService::nowMs();
+    lastUpdateMs = startMs;
+    noFlowSinceMs = 0;
+    noFlowWarned = false;
+    timerService.cancel(windowTimer);
+
+    LOG_I("DOSE", "Treatment %.0f L:%s%s (UV %.0f L, ozone %.1f mg)", tankLiters,
+          uv ? " UV" : "", ozone ? " OZONE" : "", uvTargetLiters, ozoneTargetMg);
+
+    // UV: pump ON terus sampai turnover tercapai; ozone mulai di window pertama
+    setOutputs(uvEnabled, false);
+    if (ozoneEnabled) {
+        startWindow(sensor->getData().flowRate);
+    }
+}
+
+bool DoseController::update(const SensorData& data) {
+    if (!active) return false;
+    if (complete) return true;
+
+    uint64_t now = TimerService::nowMs();
+    float dtMs = static_cast<float>(now - lastUpdateMs);
+    lastUpdateMs = now;
+
+    // ===== INTEGRASI DOSIS =====
+    bool flowing = data.flowRate >= DOSE_MIN_FLOW_LPM;
+    bool pumpOn = actuator->getPumpUVState();
+
+    if (flowing) {
+        noFlowSinceMs = 0;
+        noFlowWarned = false;
+
+        if (uvEnabled && pumpOn) {
+            float effective = data.flowRate < DOSE_UV_RATED_LPM ? data.flowRate : DOSE_UV_RATED_LPM;
+            uvLiters += effective * dtMs / MS_PER_MIN;
+        }
+        if (ozoneOn) {
+            ozoneMg += DOSE_OZONE_OUTPUT_MG_H * dtMs / MS_PER_HOUR;
+        }
+
+        // Aliran kembali: window baru, duty dihitung ulang dari sisa dosis
+        if (ozonePaused) {
+            ozonePaused = false;
+            LOG_I("DOSE", "Circulation flow restored - ozone resumed");
+            startWindow(data.flowRate);
+        }
+    } else if (pumpOn && (uvEnabled || ozoneOn)) {
+        // Pump ON tapi loop tidak mengalir: dosis tidak bertambah
+        if (noFlowSinceMs == 0) {
+            noFlowSinceMs = now;
+        } else if (now - noFlowSinceMs >= DOSE_NO_FLOW_WARN_MS) {
+            if (!noFlowWarned) {
+                LOG_W("DOSE", "No circulation flow - dose not accumulating");
+                noFlowWarned = true;
+            }
+
+            // Ozone ke air diam tidak tersebar: generator OFF sampai aliran kembali,
+            // pump tetap jalan supaya aliran bisa pulih
+            if (ozoneOn) {
+                timerService.cancel(windowTimer);
+                actuator->setOzone(false);
+                ozoneOn = false;
+                ozonePaused = true;
+                LOG_W("DOSE", "Ozone paused - no circulation flow");
+            }
+        }
+    }
+
+    if (dosesReached()) {
+        complete = true;
+        timerService.cancel(windowTimer);
+        setOutputs(false, false);
+        LOG_I("DOSE", "Dose reached in %lus (UV %.0f L, ozone %.1f mg)",
+              (unsigned long)((now - startMs) / 1000), uvLiters, ozoneMg);
+        return true;
+    }
+
+    // Ozone tercapai lebih dulu (UV belum): generator langsung OFF, tidak
+    // menunggu akhir window; pump tetap untuk UV
+    if (ozoneEnabled && ozoneMg >= ozoneTargetMg && (ozoneOn || TimerService::isArmed(windowTimer))) {
+        timerService.cancel(windowTimer);
+        setOutputs(uvEnabled && uvLiters < uvTargetLiters, false);
+        ozoneOn = false;
+        LOG_I("DOSE", "Ozone dose reached (%.1f mg) - generator OFF, UV continues", ozoneMg);
+    }
+
+    // UV selesai lebih dulu: pump hanya ikut fase ozone (pause: pump tetap ON menunggu aliran)
+    if (uvEnabled && uvLiters >= uvTargetLiters && pumpControlled && !ozoneOn && !ozonePaused) {
+        setOutputs(false, false);
+    }
+
+    // ===== OZONE DUTY CYCLE =====
+    if (ozoneEnabled && !ozonePaused && ozoneMg < ozoneTargetMg && timerService.consumeExpired(windowTimer)) {
+        if (ozoneOn && ozoneOffMs > 0) {
+            setOutputs(uvEnabled && uvLiters < uvTargetLiters, false);
+            ozoneOn = false;
+            timerService.arm(windowTimer, ozoneOffMs);
+        } else {
+            startWindow(data.flowRate);
+        }
+    }
+
+    return false;
+}
+
+void DoseController::stop() {
+    if (!active) return;
+
+    timerService.cancel(windowTimer);
+    setOutputs(false, false);
+    active = false;
+
+    if (!complete) {
+        LOG_I("DOSE", "Treatment stopped at UV %.0f/%.0f L, ozone %.1f/%.1f mg",
+              uvLiters, uvTargetLiters, ozoneMg, ozoneTargetMg);
+    }
+}
+
+DoseStatus DoseController::getStatus() const {
+    DoseStatus status;
+    status.active = active;
+    status.uvLiters = uvLiters;
+    status.uvTargetLiters = uvTargetLiters;
+    status.ozoneMg = ozoneMg;
+    status.ozoneTargetMg = ozoneTargetMg;
+    status.ozoneDuty = ozoneDuty;
+    status.elapsedMs = active ? static_cast<uint32_t>(TimerService::nowMs() - startMs) : 0;
+    return status;
+}
+
+// ===== PRIVATE =====
+
+// Duty = waktu ozone yang masih dibutuhkan / waktu yang tersedia
+void DoseController::startWindow(float flowRate) {
+    float remainingMs = (ozoneTargetMg - ozoneMg) / DOSE_OZONE_OUTPUT_MG_H * MS_PER_HOUR;
+    float availableMs = 0;
+
+    if (uvEnabled && uvLiters < uvTargetLiters && flowRate >= DOSE_MIN_FLOW_LPM) {
+        // Sebar ozone sepanjang sisa waktu UV
+        float effective = flowRate < DOSE_UV_RATED_LPM ? flowRate : DOSE_UV_RATED_LPM;
+        availableMs = (uvTargetLiters - uvLiters) / effective * MS_PER_MIN;
+    } else if (budgetMs > 0) {
+        uint32_t used = static_cast<uint32_t>(TimerService::nowMs() - startMs);
+        availableMs = used < budgetMs ? static_cast<float>(budgetMs - used) : 0;
+    }
+
+    ozoneDuty = 1.0f;
+    if (availableMs > remainingMs) {
+        ozoneDuty = remainingMs / availableMs;
+        if (ozoneDuty < DOSE_OZONE_MIN_DUTY) ozoneDuty = DOSE_OZONE_MIN_DUTY;
+    }
+
+    uint32_t onMs = static_cast<uint32_t>(DOSE_OZONE_WINDOW_MS * ozoneDuty);
+    if (onMs > remainingMs) onMs = static_cast<uint32_t>(remainingMs) + 1;
+    ozoneOffMs = onMs < DOSE_OZONE_WINDOW_MS ? DOSE_OZONE_WINDOW_MS - onMs : 0;
+
+    ozoneOn = true;
+    setOutputs(true, true);
+    timerService.arm(windowTimer, onMs);
+    LOG_D("DOSE", "Ozone window: duty %.2f, on %lums", ozoneDuty, (unsigned long)onMs);
+}
+
+void DoseController::setOutputs(bool pump, bool ozone) {
+    if (pumpControlled) {
+        actuator->setPumpUV(pump);
+    }
+    actuator->setOzone(ozone);
+}
+
+bool DoseController::dosesReached() const {
+    return uvLiters >= uvTargetLiters && ozoneMg >= ozoneTargetMg;
+}
@@ -0,0 +1,88 @@
+// DoseController.h
+#ifndef DOSE_CONTROLLER_H
+#define DOSE_CONTROLLER_H
+
+#include <Arduino.h>
+#include "ActuatorControl.h"
+#include "SensorManager.h"
+#include "TimerService.h"
+
+// ===== DOSE CONFIG =====
+// Flow sensor ada di loop sirkulasi: saat inlet & drain tertutup, flowRate = flow pump
+#define DOSE_DEFAULT_TANK_L       50.0f    // Isi tangki tidak diketahui
+#define DOSE_UV_TURNOVERS         3.0f     // Volume efektif lewat reaktor UV = 3× isi tangki
+#define DOSE_UV_RATED_LPM         10.0f    // Di atas ini waktu paparan per lintasan tidak cukup
+#define DOSE_OZONE_OUTPUT_MG_H    400.0f   // Output generator ozone
+#define DOSE_OZONE_MG_L           0.3f     // Dosis ozone per liter isi tangki
+#define DOSE_MIN_FLOW_LPM         0.5f     // Di bawah ini loop dianggap tidak mengalir (dosis tidak dihitung)
+#define DOSE_NO_FLOW_WARN_MS      10000    // Pump ON tanpa aliran selama ini → warning + ozone pause
+#define DOSE_OZONE_WINDOW_MS      60000UL  // Periode duty cycle ozone
+#define DOSE_OZONE_MIN_DUTY       0.25f    // Lebih pendek dari ini generator tidak efisien
+
+struct DoseStatus {
+    bool active;
+    float uvLiters;             // Volume efektif lewat reaktor UV
+    float uvTargetLiters;
+    float ozoneMg;
+    float ozoneTargetMg;
+    float ozoneDuty;            // Duty window aktif
+    uint32_t elapsedMs;
+};
+
+// ===== DOSE CONTROLLER CLASS =====
+// Treatment berbasis dosis terintegrasi, bukan durasi tetap:
+//   UV    : Σ min(flow, rated)·dt  → target = turnover × isi tangki
+//   Ozone : Σ output·t_on (hanya saat loop mengalir) → target = mg/L × isi tangki
+// Ozone dijalankan duty cycle per window supaya dosis tersebar sepanjang sisa
+// waktu UV / budget step, bukan ON terus. Tanpa UV, pump hanya ikut fase ON ozone.
+class DoseController {
+public:
+    DoseController(ActuatorControl* actuators, SensorManager* sensors);
+    ~DoseController();
+
+    // Window duty cycle mem-post EV_DEADLINE ke queue ini
+    void setEventQueue(QueueHandle_t queue);
+
+    // controlPump false: pump milik cooling (HOLD), controller hanya mengatur ozone.
+    // budgetMs: waktu untuk menyebar ozone jika tanpa UV (0 = secepatnya)
+    void start(float tankLiters, bool uv, bool ozone, bool controlPump, uint32_t budgetMs);
+    bool update(const SensorData& data);    // true = semua dosis tercapai
+    void stop();
+
+    bool isActive() const { return active; }
+    DoseStatus getStatus() const;
+
+private:
+    ActuatorControl* actuator;
+    SensorManager* sensor;
+
+    bool active;
+    bool uvEnabled;
+    bool ozoneEnabled;
+    bool pumpControlled;
+    bool complete;
+
+    float uvLiters;
+    float uvTargetLiters;
+    float ozoneMg;
+    float ozoneTargetMg;
+
+    bool ozoneOn;               // Fase ON window aktif
+    bool ozonePaused;           // Window dihentikan karena loop tidak mengalir
+    float ozoneDuty;
+    uint32_t ozoneOffMs;        // Sisa fase OFF window aktif
+    uint32_t budgetMs;
+
+    uint64_t startMs;
+    uint64_t lastUpdateMs;
+    uint64_t noFlowSinceMs;     // 0 = flow normal
+    bool noFlowWarned;
+
+    Timer windowTimer;          // Batas fase ON/OFF ozone
+
+    void startWindow(float flowRate);
+    void setOutputs(bool pump, bool ozone);
+    bool dosesReached() const;
+};
+
+#endif
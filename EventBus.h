@@ -0,0 +1,163 @@
+// EventBus.h
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include <Arduino.h>
+#include "SensorManager.h"
+#include "NextionGateWay.h"
+#include "SystemState.h"
+#include "TimerService.h"
+#include "Logger.h"
+
+// ===== BUS CONFIG =====
+#define BUS_MAX_SUBSCRIBERS       4         // Per topic
+
+// ===== TOPIC MESSAGES =====
+struct StateChange {
+    SystemState from;
+    SystemState to;
+};
+
+enum class Actuator : uint8_t {
+    VALVE_DRAIN = 0,
+    VALVE_INLET,
+    COMPRESSOR,
+    PUMP_UV,
+    OZONE,
+    BUZZER,
+    ALL                         // allOff()
+};
+
+struct ActuatorChange {
+    Actuator actuator;
+    bool on;
+};
+
+struct BusSubscriberStats {
+    uint32_t delivered;
+    uint32_t filtered;          // Ditolak filter (perubahan di bawah threshold)
+    uint32_t throttled;         // Dilewati rate limit
+};
+
+// ===== TOPIC =====
+// Fan-out satu jenis pesan: producer memanggil publish() sekali dengan
+// referensi ke sampelnya (nilai yang sama dengan snapshot seqlock), handler
+// tiap subscriber menerima referensi yang sama. Subscriber baru tidak menambah
+// sampling, copy, maupun lock di producer.
+//
+// Per subscriber:
+//   filter       : nullptr = semua pesan; false = perubahan terlalu kecil
+//   minIntervalMs: rate limit, pesan yang datang lebih cepat dilewati
+//   maxSilenceMs : kirim tanpa filter jika selama ini tidak ada yang lolos (0 = tidak)
+// Pesan pertama selalu dikirim.
+//
+// subscribe() hanya dari setup() sebelum task jalan. publish() tidak reentrant:
+// satu task per topic, atau producer menserialisasi sendiri (ui: mutex writer
+// NextionGateWay, tidak ditunggu reader). Jangan di bawah lock yang dipakai
+// reader. Handler jalan di task publisher: singkat dan tidak blocking.
+template <typename T>
+class BusTopic {
+public:
+    typedef void (*Handler)(void* context, const T& message);
+    typedef bool (*Filter)(void* context, const T& message);
+
+    explicit BusTopic(const char* topicName) : name(topicName), count(0) {}
+
+    bool subscribe(const char* subscriberName, Handler handler, void* context,
+                   Filter filter = nullptr, uint32_t minIntervalMs = 0, uint32_t maxSilenceMs = 0) {
+        if (!handler || count >= BUS_MAX_SUBSCRIBERS) {
+            LOG_E("BUS", "%s: cannot subscribe %s", name, subscriberName);
+            return false;
+        }
+
+        Subscriber& s = subscribers[count++];
+        s.name = subscriberName;
+        s.handler = handler;
+        s.filter = filter;
+        s.context = context;
+        s.minIntervalMs = minIntervalMs;
+        s.maxSilenceMs = maxSilenceMs;
+        s.lastDeliveryMs = 0;
+        s.stats = BusSubscriberStats();
+        return true;
+    }
+
+    void publish(const T& message) {
+        if (count == 0) return;
+
+        uint64_t now = TimerService::nowMs();
+        for (uint8_t i = 0; i < count; i++) {
+            Subscriber& s = subscribers[i];
+            uint64_t sinceMs = now - s.lastDeliveryMs;
+            bool overdue = s.stats.delivered == 0 || (s.maxSilenceMs && sinceMs >= s.maxSilenceMs);
+
+            if (!overdue) {
+                if (sinceMs < s.minIntervalMs) {
+                    s.stats.throttled++;
+                    continue;
+                }
+                if (s.filter && !s.filter(s.context, message)) {
+                    s.stats.filtered++;
+                    continue;
+                }
+            }
+
+            s.handler(s.context, message);
+            s.lastDeliveryMs = now;
+            s.stats.delivered++;
+        }
+    }
+
+    // Debug: counter dibaca tanpa sinkronisasi (boleh selisih satu pesan)
+    void printStats() const {
+        for (uint8_t i = 0; i < count; i++) {
+            const Subscriber& s = subscribers[i];
+            LOG_I("BUS", "%s → %s: delivered %lu filtered %lu throttled %lu",
+                  name, s.name,
+                  (unsigned long)s.stats.delivered,
+                  (unsigned long)s.stats.filtered,
+                  (unsigned long)s.stats.throttled);
+        }
+    }
+
+private:
+    struct Subscriber {
+        const char* name;
+        Handler handler;
+        Filter filter;
+        void* context;
+        uint32_t minIntervalMs;
+        uint32_t maxSilenceMs;
+        uint64_t lastDeliveryMs;
+        BusSubscriberStats stats;
+    };
+
+    const char* name;
+    Subscriber subscribers[BUS_MAX_SUBSCRIBERS];
+    uint8_t count;
+};
+
+// ===== EVENT BUS =====
+// Satu topic per jenis update; producer diberi pointer lewat setEventBus().
+struct EventBus {
+    BusTopic<SensorData> sensors;           // SensorManager: tiap sampel (sensor task)
+    BusTopic<StateChange> states;           // FSM: setelah entry state baru
+    BusTopic<ActuatorChange> actuators;     // ActuatorControl: tiap setter & allOff (FSM task)
+    BusTopic<NextionData> ui;               // NextionGateWay: tiap perubahan data, di bawah mutex writer
+
+    EventBus()
+        : sensors("sensors")
+        , states("states")
+        , actuators("actuators")
+        , ui("ui")
+    {}
+
+    void printStats() const {
+        sensors.printStats();
+        states.printStats();
+        actuators.printStats();
+        ui.printStats();
+    }
+};
+
+#endif
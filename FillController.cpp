@@ -0,0 +1,258 @@
+// FillController.cpp
+#include "FillController.h"
+#include "Logger.h"
+
+// ===== CONSTRUCTOR / DESTRUCTOR =====
+
+FillController::FillController(SensorManager* sensors)
+    : sensor(sensors)
+    , active(false)
+    , fromEmpty(false)
+    , startPulses(0)
+    , startLiters(0)
+    , targetLiters(0)
+    , targetLearned(false)
+    , floatEdgePulses(0)
+    , floatEdgeLiters(0)
+    , floatEdgeMs(0)
+    , edgeSampleValid(false)
+    , learnedLiters(0)
+    , predicted(false)
+    , startMs(0)
+    , settlePending(false)
+    , closeCompleted(false)
+    , closeStartLiters(0)
+    , idealLiters(0)
+    , closePredictive(false)
+    , closeDurationMs(0)
+    , report()
+    , tankLiters(0)
+    , tankKnown(false)
+{
+    mutex = xSemaphoreCreateMutexStatic(&mutexBuffer);
+    TimerService::initFlag(endpointTimer);
+    TimerService::initCallback(settleTimer, onSettled, this);
+}
+
+FillController::~FillController() {
+    timerService.cancel(endpointTimer);
+    timerService.cancel(settleTimer);
+    if (mutex) vSemaphoreDelete(mutex);
+}
+
+void FillController::setEventQueue(QueueHandle_t queue) {
+    TimerService::initEvent(endpointTimer, queue, FsmEvent::EV_DEADLINE);
+}
+
+// ===== PUBLIC API =====
+
+void FillController::start(float target) {
+    // Fill sebelumnya belum settle (valve dibuka lagi): masukkan neraca sekarang
+    timerService.cancel(settleTimer);
+    settle();
+    timerService.cancel(endpointTimer);
+
+    lock();
+    fromEmpty = tankKnown && tankLiters <= 0;
+    unlock();
+
+    active = true;
+    predicted = false;
+    floatEdgePulses = 0;
+    floatEdgeLiters = 0;
+    edgeSampleValid = false;
+    startPulses = sensor->getPulseCount();
+    startLiters = sensor->getLiters();
+    startMs = TimerService::nowMs();
+
+    if (target > 0) {
+        targetLiters = target;
+        targetLearned = false;
+    } else if (fromEmpty && learnedLiters > 0) {
+        targetLiters = learnedLiters;
+        targetLearned = true;
+    } else {
+        // Tangki tidak kosong / belum ada data: float switch saja
+        targetLiters = 0;
+        targetLearned = false;
+    }
+
+    if (targetLiters > 0) {
+        LOG_I("FILL", "Target %.1f L (%s)", targetLiters, targetLearned ? "learned" : "recipe");
+    }
+}
+
+bool FillController::shouldClose(const SensorData& data) {
+    if (!active || targetLiters <= 0) return false;
+    if (predicted) return true;
+
+    float delivered = static_cast<float>(sensor->getLiters() - startLiters);
+    float remaining = delivered < targetLiters ? targetLiters - delivered : 0;
+
+    // flowRate rata-rata 500ms terakhir; volume dibaca langsung dari counter
+    float litersPerMs = data.flowRate / 60000.0f;
+    float closeLiters = litersPerMs * FILL_CLOSE_LEAD_MS;
+
+    if (remaining <= closeLiters) {
+        predicted = true;
+        timerService.cancel(endpointTimer);
+        LOG_I("FILL", "Predicted endpoint: %.2f L in, %.2f L still to come", delivered, remaining);
+        return true;
+    }
+
+    // Tidur sampai titik tutup (re-arm tiap evaluasi mengikuti flow terbaru)
+    if (litersPerMs > 0) {
+        uint32_t msLeft = static_cast<uint32_t>((remaining - closeLiters) / litersPerMs);
+        if (msLeft > 0) timerService.arm(endpointTimer, msLeft);
+    }
+    return false;
+}
+
+void FillController::onFloatEdge() {
+    if (!active || floatEdgePulses) return;
+    floatEdgePulses = sensor->getPulseCount() - startPulses;
+    if (floatEdgePulses == 0) floatEdgePulses = 1;      // 0 = "belum ada edge"
+    floatEdgeLiters = static_cast<float>(sensor->getLiters() - startLiters);
+    floatEdgeMs = static_cast<uint32_t>(TimerService::nowMs() - startMs);
+}
+
+bool FillController::getFloatEdgeSample(uint32_t& pulses, float& liters, uint32_t& durationMs) const {
+    if (!edgeSampleValid) return false;
+    pulses = floatEdgePulses;
+    liters = floatEdgeLiters;
+    durationMs = floatEdgeMs;
+    return true;
+}
+
+void FillController::finish(bool completed) {
+    if (!active) return;
+    active = false;
+    timerService.cancel(endpointTimer);
+
+    float delivered = static_cast<float>(sensor->getLiters() - startLiters);
+    edgeSampleValid = completed && fromEmpty && floatEdgePulses != 0;
+
+    // ===== LEARNING: volume kosong → float edge =====
+    // Fill volume recipe tidak mengubah model (endpoint bukan float)
+    if (completed && fromEmpty && (targetLearned || targetLiters <= 0)) {
+        if (floatEdgePulses) {
+            if (learnedLiters <= 0) {
+                learnedLiters = floatEdgeLiters;
+            } else if (floatEdgeLiters >= learnedLiters * FILL_EDGE_MIN_RATIO) {
+                learnedLiters += FILL_LEARN_ALPHA * (floatEdgeLiters - learnedLiters);
+            }
+        } else if (predicted) {
+            // Tanpa edge model tidak bisa turun sendiri: naikkan pelan sampai float terlihat lagi
+            learnedLiters *= FILL_CREEP_RATIO;
+        }
+    }
+
+    if (!completed) {
+        LOG_I("FILL", "Fill aborted after %.1f L", delivered);
+    }
+
+    // Ideal: level float (edge) untuk fill float, target untuk fill prediktif.
+    // Fill yang dibatalkan tetap masuk neraca tangki setelah settle.
+    lock();
+    settlePending = true;
+    closeCompleted = completed;
+    closeStartLiters = startLiters;
+    idealLiters = (!predicted && floatEdgePulses) ? floatEdgeLiters : targetLiters;
+    if (idealLiters <= 0) idealLiters = delivered;
+    closePredictive = predicted;
+    closeDurationMs = static_cast<uint32_t>(TimerService::nowMs() - startMs);
+    unlock();
+
+    timerService.arm(settleTimer, FILL_SETTLE_MS);
+}
+
+float FillController::getLearnedVolumeL() {
+    return learnedLiters;
+}
+
+FillReport FillController::getLastReport() {
+    lock();
+    FillReport copy = report;
+    unlock();
+    return copy;
+}
+
+// ===== TANK BALANCE =====
+
+void FillController::markEmpty() {
+    lock();
+    tankLiters = 0;
+    tankKnown = true;
+    unlock();
+}
+
+void FillController::removeVolume(float liters) {
+    lock();
+    tankLiters = liters < tankLiters ? tankLiters - liters : 0;
+    unlock();
+}
+
+void FillController::settleNow() {
+    timerService.cancel(settleTimer);
+    settle();
+}
+
+float FillController::getTankLiters() {
+    // Settle tertunda diselesaikan dulu supaya volume drain tidak terhitung sebagai fill
+    settleNow();
+
+    lock();
+    float liters = tankKnown ? tankLiters : 0;
+    unlock();
+    return liters;
+}
+
+// ===== SETTLE =====
+
+void FillController::onSettled(void* arg) {
+    static_cast<FillController*>(arg)->settle();     // TimerTask
+}
+
+void FillController::settle() {
+    lock();
+    if (!settlePending) {
+        unlock();
+        return;
+    }
+    settlePending = false;
+
+    float total = static_cast<float>(sensor->getLiters() - closeStartLiters);
+    if (total > 0) tankLiters += total;
+
+    FillReport r = report;
+    if (closeCompleted) {
+        r.volumeL = total;
+        r.targetL = idealLiters;
+        r.overfillL = r.volumeL - r.targetL;
+        r.durationMs = closeDurationMs;
+        r.predictive = closePredictive;
+        report = r;
+    }
+    bool completed = closeCompleted;
+    unlock();
+
+    if (completed) {
+        LOG_I("FILL", "Batch fill %.2f L in %lus (%s), overfill %+.2f L",
+              r.volumeL, (unsigned long)(r.durationMs / 1000),
+              r.predictive ? "predictive" : "float", r.overfillL);
+    }
+}
+
+// ===== PRIVATE =====
+
+void FillController::lock() {
+    if (mutex) {
+        xSemaphoreTake(mutex, portMAX_DELAY);
+    }
+}
+
+void FillController::unlock() {
+    if (mutex) {
+        xSemaphoreGive(mutex);
+    }
+}
@@ -0,0 +1,99 @@
+// FillController.h
+#ifndef FILL_CONTROLLER_H
+#define FILL_CONTROLLER_H
+
+#include <Arduino.h>
+#include "SensorManager.h"
+#include "TimerService.h"
+
+// ===== FILL CONFIG =====
+#define FILL_CLOSE_LEAD_MS        800      // Waktu tutup solenoid inlet + jitter evaluasi
+#define FILL_SETTLE_MS            2000     // Pulse setelah valve tutup dihitung sebagai overfill
+#define FILL_LEARN_ALPHA          0.3f
+#define FILL_EDGE_MIN_RATIO       0.9f     // Float edge < 90% volume belajar = cipratan, abaikan
+#define FILL_CREEP_RATIO          1.005f   // Tutup prediktif tanpa float edge → naikkan target 0.5%
+
+struct FillReport {
+    float volumeL;              // Total masuk (termasuk setelah valve tutup)
+    float targetL;              // Titik ideal: float edge (float) atau target (prediktif/volume)
+    float overfillL;            // volume - target (negatif = kurang)
+    uint32_t durationMs;        // Valve buka → valve tutup
+    bool predictive;            // Ditutup oleh prediksi, bukan float
+};
+
+// ===== FILL CONTROLLER CLASS =====
+// Integrasi volume flow sensor (SensorManager::getLiters, kurva K(flow))
+// selama fill. Target volume dari recipe (FILL <liter>L) atau dipelajari dari
+// fill yang berakhir di float switch (hanya fill dari tangki kosong). Valve
+// ditutup FILL_CLOSE_LEAD_MS sebelum endpoint prediksi; float switch tetap backstop.
+//
+// Juga menyimpan neraca isi tangki (liter masuk - liter keluar) sejak drain
+// terakhir yang selesai, dipakai untuk deteksi akhir drain. Pulse mentah
+// kosong → float disimpan terpisah sebagai titik kalibrasi K.
+class FillController {
+public:
+    FillController(SensorManager* sensors);
+    ~FillController();
+
+    // Timer endpoint mem-post EV_DEADLINE ke queue ini
+    void setEventQueue(QueueHandle_t queue);
+
+    void start(float targetLiters);                   // targetLiters 0 = volume belajar (jika tangki kosong)
+    bool shouldClose(const SensorData& data);         // Endpoint prediksi tercapai
+    void onFloatEdge();                               // Float rising edge (mentah, sebelum debounce)
+    void finish(bool completed);                      // Valve ditutup; laporan final setelah settle
+    void settleNow();                                 // Pump sirkulasi akan jalan: tutup pengukuran settle
+
+    bool isActive() const { return active; }
+    bool isFromEmpty() const { return fromEmpty; }    // Fill terakhir/aktif mulai dari tangki kosong
+    // Fill terakhir: kosong → float edge (pulse mentah untuk kalibrasi K-factor)
+    bool getFloatEdgeSample(uint32_t& pulses, float& liters, uint32_t& durationMs) const;
+    float getLearnedVolumeL();
+    FillReport getLastReport();
+
+    // ===== TANK BALANCE =====
+    void markEmpty();                                 // Drain selesai: isi = 0, neraca diketahui
+    void removeVolume(float liters);                  // Drain parsial / dibatalkan
+    float getTankLiters();                            // 0 = kosong atau belum diketahui
+
+private:
+    SensorManager* sensor;
+
+    bool active;
+    bool fromEmpty;             // Tangki kosong saat start (neraca diketahui & 0)
+    uint32_t startPulses;
+    double startLiters;
+    float targetLiters;         // 0 = tidak ada endpoint prediksi (float saja)
+    bool targetLearned;         // targetLiters dari hasil belajar (bukan recipe)
+    uint32_t floatEdgePulses;   // Pulse mentah start → edge, 0 = belum ada edge
+    float floatEdgeLiters;
+    uint32_t floatEdgeMs;       // Start → edge
+    bool edgeSampleValid;       // Fill selesai dari tangki kosong dengan float edge
+    float learnedLiters;        // Volume kosong → float edge, 0 = belum diketahui
+    bool predicted;             // shouldClose() sudah true
+    uint64_t startMs;
+
+    // Laporan di-finalisasi di TimerTask setelah pulse sisa berhenti
+    bool settlePending;
+    bool closeCompleted;
+    double closeStartLiters;
+    float idealLiters;
+    bool closePredictive;
+    uint32_t closeDurationMs;
+    FillReport report;
+
+    float tankLiters;           // Isi tangki sejak drain selesai terakhir
+    bool tankKnown;             // false sampai drain pertama selesai
+    SemaphoreHandle_t mutex;
+    StaticSemaphore_t mutexBuffer;
+
+    Timer endpointTimer;        // Bangunkan FSM tepat di titik tutup prediksi
+    Timer settleTimer;          // Callback: hitung pulse setelah valve tutup
+
+    static void onSettled(void* arg);
+    void settle();
+    void lock();
+    void unlock();
+};
+
+#endif
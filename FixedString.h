@@ -0,0 +1,134 @@
+// FixedString.h
+#ifndef FIXED_STRING_H
+#define FIXED_STRING_H
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+// ===== FIXED STRING =====
+// Pengganti Arduino String untuk path yang jalan terus (snapshot UI tiap
+// 200 ms, command Nextion, jam): buffer N karakter di dalam object, tidak
+// pernah malloc/free. Copy = memcpy, aman di-copy by value.
+//
+// Append yang melebihi kapasitas dipotong dan ditandai truncated(); isi tetap
+// null-terminated. Ukuran N dipilih supaya input kepanjangan tetap gagal
+// validasi (mis. TimeText 8 untuk "HH:MM"), bukan terpotong jadi valid.
+template <size_t N>
+class FixedString {
+public:
+    FixedString() : len(0), overflow(false) { buf[0] = '\0'; }
+    FixedString(const char* s) : len(0), overflow(false) { buf[0] = '\0'; append(s); }
+
+    FixedString& operator=(const char* s) { clear(); return append(s); }
+    FixedString& operator+=(const char* s) { return append(s); }
+    FixedString& operator+=(char c) { return append(c); }
+
+    void clear() {
+        len = 0;
+        overflow = false;
+        buf[0] = '\0';
+    }
+
+    FixedString& append(const char* s) {
+        return s ? append(s, strlen(s)) : *this;
+    }
+
+    FixedString& append(const char* s, size_t n) {
+        size_t room = N - len;
+        if (n > room) {
+            n = room;
+            overflow = true;
+        }
+        memcpy(buf + len, s, n);
+        len += n;
+        buf[len] = '\0';
+        return *this;
+    }
+
+    FixedString& append(char c) {
+        return append(&c, 1);
+    }
+
+    // snprintf ke sisa buffer (tanpa String(int)/String(float) sementara)
+    __attribute__((format(printf, 2, 3)))
+    FixedString& appendf(const char* fmt, ...) {
+        va_list args;
+        va_start(args, fmt);
+        vappendf(fmt, args);
+        va_end(args);
+        return *this;
+    }
+
+    __attribute__((format(printf, 2, 3)))
+    FixedString& format(const char* fmt, ...) {
+        clear();
+        va_list args;
+        va_start(args, fmt);
+        vappendf(fmt, args);
+        va_end(args);
+        return *this;
+    }
+
+    // Buang whitespace di awal/akhir (pengganti String::trim)
+    FixedString& trim() {
+        size_t start = 0;
+        while (start < len && isspace(static_cast<unsigned char>(buf[start]))) start++;
+        size_t end = len;
+        while (end > start && isspace(static_cast<unsigned char>(buf[end - 1]))) end--;
+        len = end - start;
+        memmove(buf, buf + start, len);
+        buf[len] = '\0';
+        return *this;
+    }
+
+    // ===== ACCESS =====
+    const char* c_str() const { return buf; }
+    size_t length() const { return len; }
+    static size_t capacity() { return N; }
+    bool isEmpty() const { return len == 0; }
+    bool truncated() const { return overflow; }
+    char operator[](size_t index) const { return index < len ? buf[index] : '\0'; }
+
+    // Sisa string mulai index (pengganti substring(index) tanpa copy)
+    const char* from(size_t index) const { return buf + (index < len ? index : len); }
+
+    // ===== COMPARE =====
+    bool equals(const char* s) const { return s && strcmp(buf, s) == 0; }
+    bool startsWith(const char* prefix) const { return strncmp(buf, prefix, strlen(prefix)) == 0; }
+
+    template <size_t M>
+    bool operator==(const FixedString<M>& other) const { return equals(other.c_str()); }
+    template <size_t M>
+    bool operator!=(const FixedString<M>& other) const { return !equals(other.c_str()); }
+    bool operator==(const char* s) const { return equals(s); }
+    bool operator!=(const char* s) const { return !equals(s); }
+
+private:
+    char buf[N + 1];
+    size_t len;
+    bool overflow;
+
+    void vappendf(const char* fmt, va_list args) {
+        int written = vsnprintf(buf + len, N + 1 - len, fmt, args);
+        if (written < 0) {
+            buf[len] = '\0';
+            return;
+        }
+        if (static_cast<size_t>(written) > N - len) {
+            written = static_cast<int>(N - len);
+            overflow = true;
+        }
+        len += written;
+    }
+};
+
+// "HH:MM" dari panel / NVS; 3 karakter ekstra supaya input kepanjangan gagal validasi
+typedef FixedString<8> TimeText;
+
+// Satu command Nextion (tanpa terminator 0xFF)
+#define NEXTION_COMMAND_MAX       48
+typedef FixedString<NEXTION_COMMAND_MAX> NextionCommand;
+
+#endif
@@ -0,0 +1,273 @@
+// FlowCalibration.cpp
+#include "FlowCalibration.h"
+#include "Logger.h"
+
+static const char* NVS_NAMESPACE = "flowcal";
+static const char* NVS_KEY_CAPACITY = "cap";       // dL
+static const char* NVS_KEY_HISTORY = "hist";
+
+// Satu blob per titik: ring + posisi ditulis bersama dalam satu putBytes
+struct FlowCalStored {
+    FlowCalPoint history[FLOWCAL_HISTORY];
+    uint8_t head;
+    uint8_t count;
+};
+
+static const float RECENCY_WEIGHT = 0.7f;           // Titik lama berbobot lebih kecil → drift terlacak
+static const char* SOURCE_NAMES[] = { "fill", "drain" };
+
+static const char* sourceName(uint8_t source) {
+    return source < sizeof(SOURCE_NAMES) / sizeof(SOURCE_NAMES[0]) ? SOURCE_NAMES[source] : "?";
+}
+
+// ===== CONSTRUCTOR / DESTRUCTOR =====
+
+FlowCalibration::FlowCalibration(RTCManager* rtc)
+    : rtcManager(rtc)
+    , capacityLiters(0)
+    , history()
+    , historyHead(0)
+    , historyCount(0)
+    , historyPending(false)
+    , capacityPending(false)
+    , kMean(FLOWCAL_DEFAULT_K)
+    , qMean(0)
+    , slope(0)
+{
+    mutex = xSemaphoreCreateMutexStatic(&mutexBuffer);
+    TimerService::initFlag(retryTimer);
+}
+
+FlowCalibration::~FlowCalibration() {
+    if (mutex) vSemaphoreDelete(mutex);
+}
+
+// ===== PUBLIC API =====
+
+void FlowCalibration::begin() {
+    prefs.begin(NVS_NAMESPACE, false);
+
+    lock();
+    capacityLiters = prefs.getUInt(NVS_KEY_CAPACITY, 0) / 10.0f;
+
+    // History rusak/versi lain → mulai dari K datasheet
+    FlowCalStored stored;
+    if (prefs.getBytesLength(NVS_KEY_HISTORY) == sizeof(stored) &&
+        prefs.getBytes(NVS_KEY_HISTORY, &stored, sizeof(stored)) == sizeof(stored)) {
+        memcpy(history, stored.history, sizeof(history));
+        historyHead = stored.head % FLOWCAL_HISTORY;
+        historyCount = stored.count > FLOWCAL_HISTORY ? FLOWCAL_HISTORY : stored.count;
+    }
+    fit();
+    unlock();
+
+    LOG_I("FLOWCAL", "K %.1f pulses/L (%u points), tank %.1f L",
+          kMean, historyCount, capacityLiters);
+}
+
+// Tulis flash di luar mutex: sensor task (pulsesPerLiterAt tiap 500ms) dan FSM
+// (observe*) tidak pernah menunggu NVS
+void FlowCalibration::flush() {
+    if (TimerService::isArmed(retryTimer)) return;
+
+    lock();
+    bool writeHistory = historyPending;
+    bool writeCapacity = capacityPending;
+    uint32_t capacityDl = static_cast<uint32_t>(capacityLiters * 10.0f + 0.5f);
+    FlowCalStored record;
+    if (writeHistory) {
+        memcpy(record.history, history, sizeof(history));
+        record.head = historyHead;
+        record.count = historyCount;
+    }
+    historyPending = false;
+    capacityPending = false;
+    unlock();
+
+    bool failed = false;
+    if (writeCapacity && prefs.putUInt(NVS_KEY_CAPACITY, capacityDl) != sizeof(capacityDl)) {
+        failed = true;
+        lock();
+        capacityPending = true;
+        unlock();
+    }
+    if (writeHistory && prefs.putBytes(NVS_KEY_HISTORY, &record, sizeof(record)) != sizeof(record)) {
+        failed = true;
+        // Titik baru di antaranya ikut tertulis di percobaan berikutnya
+        lock();
+        historyPending = true;
+        unlock();
+    }
+
+    if (failed) {
+        LOG_E("FLOWCAL", "NVS write failed - retry in %lums", (unsigned long)FLOWCAL_NVS_RETRY_MS);
+        timerService.arm(retryTimer, FLOWCAL_NVS_RETRY_MS);
+    }
+}
+
+void FlowCalibration::setCapacityLiters(float liters) {
+    if (liters > 0 && liters < FLOWCAL_MIN_CAPACITY_L) {
+        LOG_W("FLOWCAL", "Capacity %.1f L too small - ignored", liters);
+        return;
+    }
+
+    lock();
+    capacityLiters = liters;
+    capacityPending = true;
+    unlock();
+
+    LOG_I("FLOWCAL", "Tank capacity %.1f L%s", liters, liters > 0 ? "" : " (auto calibration off)");
+}
+
+float FlowCalibration::getCapacityLiters() {
+    lock();
+    float liters = capacityLiters;
+    unlock();
+    return liters;
+}
+
+void FlowCalibration::observeFill(uint32_t pulses, uint32_t durationMs) {
+    float capacity = getCapacityLiters();
+    if (capacity <= 0 || durationMs == 0) return;
+
+    float flowLpm = capacity * 60000.0f / durationMs;
+    addPoint(pulses / capacity, flowLpm, FlowCalSource::CAL_FILL);
+}
+
+void FlowCalibration::observeDrain(uint32_t pulses, float extraLiters, uint32_t durationMs) {
+    float capacity = getCapacityLiters();
+    if (capacity <= 0 || durationMs == 0) return;
+
+    // Overfill di atas float dari neraca liter saat ini (hanya sebagian kecil volume)
+    float liters = capacity + extraLiters;
+    float flowLpm = liters * 60000.0f / durationMs;
+    addPoint(pulses / liters, flowLpm, FlowCalSource::CAL_DRAIN);
+}
+
+float FlowCalibration::pulsesPerLiter() {
+    lock();
+    float k = kMean;
+    unlock();
+    return k;
+}
+
+float FlowCalibration::pulsesPerLiterAt(float flowLpm) {
+    lock();
+    float k = kMean + slope * (flowLpm - qMean);
+    unlock();
+
+    if (k < FLOWCAL_MIN_K) k = FLOWCAL_MIN_K;
+    if (k > FLOWCAL_MAX_K) k = FLOWCAL_MAX_K;
+    return k;
+}
+
+void FlowCalibration::reset() {
+    lock();
+    historyHead = 0;
+    historyCount = 0;
+    fit();
+    historyPending = true;      // Blob kosong (count 0) menimpa history lama
+    unlock();
+
+    LOG_I("FLOWCAL", "History cleared - K %.1f pulses/L", FLOWCAL_DEFAULT_K);
+}
+
+// ===== DEBUG =====
+
+void FlowCalibration::printHistory() {
+    lock();
+    LOG_I("FLOWCAL", "K %.1f pulses/L @ %.1f L/min, slope %+.2f per L/min, tank %.1f L",
+          kMean, qMean, slope, capacityLiters);
+
+    // Terlama → terbaru
+    for (uint8_t i = 0; i < historyCount; i++) {
+        const FlowCalPoint& p = history[(historyHead + FLOWCAL_HISTORY - historyCount + i) % FLOWCAL_HISTORY];
+        LOG_I("FLOWCAL", "  %lu %-5s K %.1f @ %.1f L/min",
+              (unsigned long)p.unixTime, sourceName(p.source), p.kFactor, p.flowLpm);
+    }
+    unlock();
+}
+
+// ===== PRIVATE =====
+
+void FlowCalibration::addPoint(float kFactor, float flowLpm, FlowCalSource source) {
+    if (kFactor < FLOWCAL_MIN_K || kFactor > FLOWCAL_MAX_K) {
+        LOG_W("FLOWCAL", "%s K %.1f out of range - rejected (capacity wrong?)",
+              sourceName(static_cast<uint8_t>(source)), kFactor);
+        return;
+    }
+
+    FlowCalPoint point;
+    point.unixTime = rtcManager ? rtcManager->getUnixTime() : 0;
+    point.kFactor = kFactor;
+    point.flowLpm = flowLpm;
+    point.source = static_cast<uint8_t>(source);
+
+    lock();
+    float before = kMean;
+    history[historyHead] = point;
+    historyHead = (historyHead + 1) % FLOWCAL_HISTORY;
+    if (historyCount < FLOWCAL_HISTORY) historyCount++;
+    fit();
+    historyPending = true;
+    float after = kMean;
+    unlock();
+
+    LOG_I("FLOWCAL", "%s point K %.1f @ %.1f L/min → K %.1f (was %.1f)",
+          sourceName(point.source), kFactor, flowLpm, after, before);
+}
+
+// Weighted least squares K = kMean + slope·(q - qMean), bobot RECENCY_WEIGHT^umur
+void FlowCalibration::fit() {
+    if (historyCount == 0) {
+        kMean = FLOWCAL_DEFAULT_K;
+        qMean = 0;
+        slope = 0;
+        return;
+    }
+
+    float sumW = 0, sumK = 0, sumQ = 0;
+    float minQ = 1e9f, maxQ = 0;
+    float w = 1.0f;
+    for (uint8_t age = 0; age < historyCount; age++) {
+        const FlowCalPoint& p = history[(historyHead + FLOWCAL_HISTORY - 1 - age) % FLOWCAL_HISTORY];
+        sumW += w;
+        sumK += w * p.kFactor;
+        sumQ += w * p.flowLpm;
+        if (p.flowLpm < minQ) minQ = p.flowLpm;
+        if (p.flowLpm > maxQ) maxQ = p.flowLpm;
+        w *= RECENCY_WEIGHT;
+    }
+    kMean = sumK / sumW;
+    qMean = sumQ / sumW;
+    slope = 0;
+
+    if (historyCount < FLOWCAL_CURVE_MIN_POINTS || maxQ - minQ < FLOWCAL_CURVE_SPREAD_LPM) return;
+
+    float sxy = 0, sxx = 0;
+    w = 1.0f;
+    for (uint8_t age = 0; age < historyCount; age++) {
+        const FlowCalPoint& p = history[(historyHead + FLOWCAL_HISTORY - 1 - age) % FLOWCAL_HISTORY];
+        float dq = p.flowLpm - qMean;
+        sxy += w * dq * (p.kFactor - kMean);
+        sxx += w * dq * dq;
+        w *= RECENCY_WEIGHT;
+    }
+    if (sxx > 0) {
+        slope = sxy / sxx;
+        if (slope > FLOWCAL_MAX_SLOPE) slope = FLOWCAL_MAX_SLOPE;
+        if (slope < -FLOWCAL_MAX_SLOPE) slope = -FLOWCAL_MAX_SLOPE;
+    }
+}
+
+void FlowCalibration::lock() {
+    if (mutex) {
+        xSemaphoreTake(mutex, portMAX_DELAY);
+    }
+}
+
+void FlowCalibration::unlock() {
+    if (mutex) {
+        xSemaphoreGive(mutex);
+    }
+}
@@ -0,0 +1,93 @@
+// FlowCalibration.h
+#ifndef FLOW_CALIBRATION_H
+#define FLOW_CALIBRATION_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "RTCManager.h"
+#include "TimerService.h"
+
+// ===== CALIBRATION CONFIG =====
+#define FLOWCAL_DEFAULT_K         450.0f   // YF-S201 datasheet, pulses/L
+#define FLOWCAL_MIN_K             (FLOWCAL_DEFAULT_K * 0.75f)   // Di luar ini = pengukuran salah
+#define FLOWCAL_MAX_K             (FLOWCAL_DEFAULT_K * 1.25f)
+#define FLOWCAL_HISTORY           8        // Titik kalibrasi terakhir (ring di NVS)
+#define FLOWCAL_CURVE_MIN_POINTS  3
+#define FLOWCAL_CURVE_SPREAD_LPM  2.0f     // Kurva K(flow) hanya jika rentang flow cukup lebar
+#define FLOWCAL_MAX_SLOPE         10.0f    // |dK/dflow| maksimum, pulses/L per L/min
+#define FLOWCAL_MIN_CAPACITY_L    5.0f
+#define FLOWCAL_NVS_RETRY_MS      5000     // Jeda sebelum tulis NVS diulang setelah gagal
+
+struct FlowCalPoint {
+    uint32_t unixTime;          // 0 = RTC tidak ada
+    float kFactor;              // pulses/L terukur
+    float flowLpm;              // Flow rata-rata selama pengukuran
+    uint8_t source;             // FlowCalSource
+};
+
+enum class FlowCalSource : uint8_t {
+    CAL_FILL = 0,               // Kosong → float switch
+    CAL_DRAIN                   // Penuh (float) → kosong
+};
+
+// ===== FLOW CALIBRATION CLASS =====
+// K-factor flow sensor dikalibrasi dalam operasi dari kapasitas tangki yang
+// diketahui (volume kosong sampai float switch, diisi operator). Setiap fill
+// dari kosong ke float dan drain dari penuh ke kosong menghasilkan satu titik
+// (K, flow rata-rata). Model: K(q) = kMean + slope·(q - qMean), fit least
+// squares atas history; slope 0 jika rentang flow history terlalu sempit.
+// History + kapasitas disimpan di NVS (namespace "flowcal"): perubahan hanya
+// ditandai pending, flush() dari loop() yang menulis flash di luar mutex.
+class FlowCalibration {
+public:
+    FlowCalibration(RTCManager* rtc);
+    ~FlowCalibration();
+
+    void begin();
+    void flush();                           // Dipanggil dari loop()
+
+    // ===== CAPACITY =====
+    void setCapacityLiters(float liters);   // 0 = kalibrasi otomatis nonaktif
+    float getCapacityLiters();
+
+    // ===== MEASUREMENT =====
+    // Pulse dari tangki kosong sampai float edge
+    void observeFill(uint32_t pulses, uint32_t durationMs);
+    // Pulse drain dari tangki penuh; extraLiters = volume fill setelah float edge
+    void observeDrain(uint32_t pulses, float extraLiters, uint32_t durationMs);
+
+    // ===== MODEL =====
+    float pulsesPerLiter();                 // K di flow rata-rata (volume / integral)
+    float pulsesPerLiterAt(float flowLpm);  // K dengan koreksi flow
+
+    void reset();                           // Hapus history, kembali ke K datasheet
+
+    // ===== DEBUG =====
+    void printHistory();
+
+private:
+    RTCManager* rtcManager;
+    Preferences prefs;
+    SemaphoreHandle_t mutex;
+    StaticSemaphore_t mutexBuffer;
+
+    float capacityLiters;
+    FlowCalPoint history[FLOWCAL_HISTORY];
+    uint8_t historyHead;        // Slot tulis berikutnya
+    uint8_t historyCount;
+    bool historyPending;        // History berubah, belum di NVS
+    bool capacityPending;
+    Timer retryTimer;           // Armed = tulis terakhir gagal, tunggu sebelum coba lagi
+
+    // Model hasil fit (dibaca dari sensor task tiap 500ms)
+    float kMean;
+    float qMean;
+    float slope;
+
+    void addPoint(float kFactor, float flowLpm, FlowCalSource source);
+    void fit();
+    void lock();
+    void unlock();
+};
+
+#endif
@@ -0,0 +1,83 @@
+// FsmEvent.h
+#ifndef FSM_EVENT_H
+#define FSM_EVENT_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// ===== FSM EVENTS =====
+// Table event = kolom "event" di tabel transisi SystemStateMachine.
+// Wake-up event tidak masuk tabel: membangunkan FSM task untuk menjalankan
+// do-activity state aktif (yang lalu bisa men-dispatch table event).
+// Tambah table event SEBELUM EV_COUNT, wake-up event sebelum EV_ALL_COUNT,
+// dan tambahkan namanya di fsmEventName().
+enum class FsmEvent : uint8_t {
+    // ----- Table events -----
+    EV_UI_CHANGED = 0,      // Input Nextion (button/menu) dievaluasi ulang
+    EV_FILL_COMPLETE,       // Float sensor stabil (tangki penuh)
+    EV_FILL_FLOW_ERROR,     // Valve inlet terbuka tapi tidak ada aliran
+    EV_DRAIN_COMPLETE,      // Aliran drain berhenti
+    EV_ERROR_CLEARED,       // Kondisi error sudah normal kembali
+    EV_COUNT,               // Jumlah table event
+
+    // ----- Wake-up events -----
+    EV_SENSOR_CHANGED = EV_COUNT,   // Input digital berubah / sampel sensor melewati threshold
+    EV_DEADLINE,                    // Timeout/debounce condition handler jatuh tempo
+    EV_HEARTBEAT,                   // Supervisi periodik (tidak ada event lain)
+    EV_RTC_ALARM,                   // Alarm jadwal RTCManager fire / jam di-set ulang
+    EV_ALL_COUNT
+};
+
+// Isi queue FSM
+struct FsmMessage {
+    FsmEvent event;
+    uint32_t postedUs;      // micros() saat di-post, untuk ukur latency
+};
+
+#define FSM_QUEUE_LENGTH 16
+
+inline const char* fsmEventName(FsmEvent event) {
+    static const char* const NAMES[] = {
+        "UI_CHANGED",
+        "FILL_COMPLETE",
+        "FILL_FLOW_ERROR",
+        "DRAIN_COMPLETE",
+        "ERROR_CLEARED",
+        "SENSOR_CHANGED",
+        "DEADLINE",
+        "HEARTBEAT",
+        "RTC_ALARM"
+    };
+    static_assert(sizeof(NAMES) / sizeof(NAMES[0]) == static_cast<size_t>(FsmEvent::EV_ALL_COUNT),
+                  "fsmEventName() tidak sinkron dengan FsmEvent");
+
+    uint8_t index = static_cast<uint8_t>(event);
+    if (index < static_cast<uint8_t>(FsmEvent::EV_ALL_COUNT)) {
+        return NAMES[index];
+    }
+    return "UNKNOWN";
+}
+
+// ===== POSTING HELPERS =====
+// Dipakai modul lain (gateway, sensor, ISR) tanpa perlu include SystemState.h.
+// Tidak pernah blocking: jika queue penuh event dibuang (heartbeat akan
+// mengevaluasi ulang semua input) dan dihitung di fsmDroppedEvents.
+extern std::atomic<uint32_t> fsmDroppedEvents;   // Definisi di SystemState.cpp
+
+inline bool fsmPostEvent(QueueHandle_t queue, FsmEvent event) {
+    if (!queue) return false;
+    FsmMessage msg = { event, static_cast<uint32_t>(micros()) };
+    if (xQueueSend(queue, &msg, 0) == pdTRUE) return true;
+    fsmDroppedEvents.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+inline bool IRAM_ATTR fsmPostEventFromISR(QueueHandle_t queue, FsmEvent event, BaseType_t* woken) {
+    if (!queue) return false;
+    FsmMessage msg = { event, static_cast<uint32_t>(micros()) };
+    if (xQueueSendFromISR(queue, &msg, woken) == pdTRUE) return true;
+    fsmDroppedEvents.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+#endif
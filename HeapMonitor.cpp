@@ -0,0 +1,131 @@
+// HeapMonitor.cpp
+#include "HeapMonitor.h"
+#include "Logger.h"
+#include <esp_heap_caps.h>
+
+// ===== CONSTRUCTOR / DESTRUCTOR =====
+
+HeapMonitor::HeapMonitor()
+    : stats()
+    , samples()
+    , head(0)
+    , warned(false)
+    , dumpIndex(0)
+    , dumpRemaining(0)
+{
+    TimerService::initFlag(warmupTimer);
+    TimerService::initFlag(sampleTimer);
+}
+
+HeapMonitor::~HeapMonitor() {
+    timerService.cancel(warmupTimer);
+    timerService.cancel(sampleTimer);
+}
+
+// ===== PUBLIC API =====
+
+void HeapMonitor::begin() {
+    timerService.arm(warmupTimer, HEAP_WARMUP_MS);
+    LOG_I("HEAP", "Free %lu B, largest block %lu B (baseline in %lus)",
+          (unsigned long)heap_caps_get_free_size(MALLOC_CAP_8BIT),
+          (unsigned long)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT),
+          (unsigned long)(HEAP_WARMUP_MS / 1000));
+}
+
+void HeapMonitor::update() {
+    if (dumpRemaining) dumpChunk();
+
+    if (timerService.consumeExpired(warmupTimer)) {
+        stats.baselineValid = true;
+        stats.baselineFree = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+        stats.baselineLargest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+        stats.baselineMinFree = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+        stats.lowestSampleFree = stats.baselineFree;
+        takeSample();
+        timerService.armPeriodic(sampleTimer, HEAP_SAMPLE_INTERVAL_MS);
+        LOG_I("HEAP", "Baseline: free %lu B, largest %lu B, low-water %lu B",
+              (unsigned long)stats.baselineFree, (unsigned long)stats.baselineLargest,
+              (unsigned long)stats.baselineMinFree);
+        return;
+    }
+
+    if (!timerService.consumeExpired(sampleTimer)) return;
+
+    takeSample();
+
+    if (!isSteady()) {
+        if (!warned) {
+            LOG_W("HEAP", "Heap drift: free %lu/%lu B, largest %lu/%lu B, low-water %lu/%lu B",
+                  (unsigned long)stats.currentFree, (unsigned long)stats.baselineFree,
+                  (unsigned long)stats.currentLargest, (unsigned long)stats.baselineLargest,
+                  (unsigned long)stats.minFreeEver, (unsigned long)stats.baselineMinFree);
+            warned = true;
+        }
+    } else {
+        warned = false;
+    }
+}
+
+HeapStats HeapMonitor::getStats() const {
+    return stats;
+}
+
+bool HeapMonitor::isSteady() const {
+    return stats.baselineValid &&
+           stats.lowestSampleFree >= stats.baselineFree &&
+           stats.currentLargest >= stats.baselineLargest &&
+           stats.minFreeEver >= stats.baselineMinFree;
+}
+
+void HeapMonitor::printTrend() {
+    if (!stats.baselineValid) {
+        LOG_I("HEAP", "Warming up - free %lu B, largest %lu B",
+              (unsigned long)heap_caps_get_free_size(MALLOC_CAP_8BIT),
+              (unsigned long)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+        return;
+    }
+
+    LOG_I("HEAP", "%s: baseline free %lu B / largest %lu B, low-water %lu B (baseline %lu B), %lu samples",
+          isSteady() ? "STEADY" : "DRIFT",
+          (unsigned long)stats.baselineFree, (unsigned long)stats.baselineLargest,
+          (unsigned long)stats.minFreeEver, (unsigned long)stats.baselineMinFree,
+          (unsigned long)stats.sampleCount);
+
+    // Sampel (sampai 96 baris) lewat Logger, dicicil HEAP_DUMP_LINES_PER_UPDATE
+    // per loop() supaya ring tidak penuh dan urutan tetap setelah header
+    uint32_t count = stats.sampleCount < HEAP_TREND_SAMPLES ? stats.sampleCount : HEAP_TREND_SAMPLES;
+    dumpIndex = (head + HEAP_TREND_SAMPLES - count) % HEAP_TREND_SAMPLES;
+    dumpRemaining = count;
+}
+
+// ===== PRIVATE =====
+
+// Urut dari sampel tertua. Sampel baru di tengah dump boleh menimpa slot yang
+// belum tercetak: dump hanya diagnostik.
+void HeapMonitor::dumpChunk() {
+    for (uint8_t i = 0; i < HEAP_DUMP_LINES_PER_UPDATE && dumpRemaining; i++) {
+        const HeapSample& s = samples[dumpIndex];
+        LOG_I("HEAP", "  +%5lum free %lu B (%+ld) largest %lu B (%+ld)",
+              (unsigned long)(s.uptimeS / 60),
+              (unsigned long)s.freeBytes, (long)s.freeBytes - (long)stats.baselineFree,
+              (unsigned long)s.largestBlock, (long)s.largestBlock - (long)stats.baselineLargest);
+        dumpIndex = (dumpIndex + 1) % HEAP_TREND_SAMPLES;
+        dumpRemaining--;
+    }
+}
+
+void HeapMonitor::takeSample() {
+    stats.currentFree = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    stats.currentLargest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    stats.minFreeEver = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    if (stats.currentFree < stats.lowestSampleFree) {
+        stats.lowestSampleFree = stats.currentFree;
+    }
+
+    HeapSample& s = samples[head];
+    s.uptimeS = static_cast<uint32_t>(TimerService::nowMs() / 1000);
+    s.freeBytes = stats.currentFree;
+    s.largestBlock = stats.currentLargest;
+    head = (head + 1) % HEAP_TREND_SAMPLES;
+    stats.sampleCount++;
+}
@@ -0,0 +1,65 @@
+// HeapMonitor.h
+#ifndef HEAP_MONITOR_H
+#define HEAP_MONITOR_H
+
+#include <Arduino.h>
+#include "TimerService.h"
+
+// ===== HEAP MONITOR CONFIG =====
+#define HEAP_SAMPLE_INTERVAL_MS   (15UL * 60 * 1000)   // 96 sampel = tren 24 jam
+#define HEAP_TREND_SAMPLES        96
+#define HEAP_WARMUP_MS            (5UL * 60 * 1000)    // Alokasi init (task, queue, NVS) selesai → baseline
+#define HEAP_DUMP_LINES_PER_UPDATE 8                   // Per loop(): jauh di bawah LOG_RING_SLOTS
+
+struct HeapSample {
+    uint32_t uptimeS;
+    uint32_t freeBytes;
+    uint32_t largestBlock;      // Blok bebas terbesar (fragmentasi)
+};
+
+struct HeapStats {
+    bool baselineValid;         // Warm-up selesai
+    uint32_t baselineFree;
+    uint32_t baselineLargest;
+    uint32_t baselineMinFree;   // Low-water mark saat baseline
+    uint32_t currentFree;
+    uint32_t currentLargest;
+    uint32_t minFreeEver;       // Low-water mark sejak boot (heap_caps_get_minimum_free_size)
+    uint32_t lowestSampleFree;  // Sampel terendah sejak baseline
+    uint32_t sampleCount;
+};
+
+// ===== HEAP MONITOR CLASS =====
+// Bukti steady-state tanpa alokasi: setelah warm-up, free heap dan blok bebas
+// terbesar disampel tiap HEAP_SAMPLE_INTERVAL_MS ke ring buffer. Steady jika
+// free heap tidak turun di bawah baseline, blok terbesar tidak mengecil, dan
+// low-water mark tidak bergerak (tidak ada alokasi sementara yang lebih besar
+// dari puncak saat init). Dipanggil dari loop(), satu task: tanpa mutex.
+class HeapMonitor {
+public:
+    HeapMonitor();
+    ~HeapMonitor();
+
+    void begin();
+    void update();              // Dipanggil dari loop()
+
+    HeapStats getStats() const;
+    bool isSteady() const;
+    void printTrend();          // Console "heap": header sekarang, sampel dicicil update()
+
+private:
+    HeapStats stats;
+    HeapSample samples[HEAP_TREND_SAMPLES];
+    uint8_t head;               // Slot berikutnya
+    bool warned;                // Drift sudah di-log (sekali sampai steady lagi)
+    uint8_t dumpIndex;          // Sampel berikutnya yang di-dump
+    uint8_t dumpRemaining;      // 0 = tidak ada dump berjalan
+
+    Timer warmupTimer;
+    Timer sampleTimer;
+
+    void takeSample();
+    void dumpChunk();
+};
+
+#endif
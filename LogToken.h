@@ -0,0 +1,210 @@
+// LogToken.h
+#ifndef LOG_TOKEN_H
+#define LOG_TOKEN_H
+
+#include <Arduino.h>
+#include <type_traits>
+
+// ===== TOKENIZED LOG FORMAT =====
+// Setiap call site LOG_x(tag, fmt, ...) di-hash saat compile menjadi token 32-bit
+// (FNV-1a atas tag, separator 0x1F, lalu fmt). Token dicari (juga saat compile)
+// di LogTokenTable.h, tabel token terurut yang di-generate tools/logtok.py dari
+// source yang sama; di wire hanya index tabel + argumen mentah yang dikirim.
+// Teks asli dibangun ulang di host oleh tools/logtok.py.
+//
+// Frame di UART (ditulis drain task):
+//   [SYNC 0x1E][LEN][ID varint][TS zigzag varint][TOKEN u32 LE][SIG][ARGS...][CRC16 LE]
+//   LEN   = jumlah byte ID..ARGS
+//   ID    = (code << 1) | ada TS; code 0 = time-sync, 1 = token mentah (call site
+//           belum ada di LogTokenTable.h), 2+ = index tabel + 2
+//   TS    = hanya jika bit ID: ms sejak frame sebelumnya (zigzag: record dari
+//           core lain bisa lebih tua); tanpa TS = selisih 0
+//   TOKEN = hanya untuk code 1
+//   SIG   = 2 bit tipe per argumen, 4 argumen per byte (LSB dulu); tidak ada
+//           untuk format tanpa argumen
+//   ARGS  = unsigned varint / zigzag varint / float32 LE / string (len + bytes)
+//   CRC16 = CRC-16/CCITT-FALSE atas LEN..ARGS
+// Time-sync (tiap LOG_TIME_SYNC_MS): body = millis() absolut (varint) + ID
+// tabel (u32 LE), supaya host bisa menolak tabel yang tidak cocok.
+//
+// Tabel basi hanya membuat call site baru jatuh ke code 1 (frame lebih besar),
+// tidak pernah salah decode. Regenerate setelah mengubah pesan log:
+//   python3 tools/logtok.py table . -o build/log_tokens.json --header LogTokenTable.h
+
+#define LOG_FRAME_SYNC        0x1E
+#define LOG_CODE_TIME_SYNC    0
+#define LOG_CODE_RAW_TOKEN    1
+#define LOG_CODE_FIRST_INDEX  2
+#define LOG_MAX_STRING_ARG    32
+
+#if __has_include("LogTokenTable.h")
+#include "LogTokenTable.h"
+#else
+constexpr uint32_t LOG_TOKEN_TABLE[1] = { 0 };
+#define LOG_TOKEN_TABLE_SIZE  0
+#define LOG_TOKEN_TABLE_ID    0x00000000u
+#endif
+
+enum class LogArgType : uint8_t {
+    ARG_UNSIGNED = 0,
+    ARG_SIGNED   = 1,
+    ARG_FLOAT    = 2,
+    ARG_STRING   = 3
+};
+
+// ===== COMPILE-TIME TOKEN =====
+// Rekursif satu-return supaya tetap valid sebagai constexpr C++11
+constexpr uint32_t logTokenHash(const char* s, uint32_t h) {
+    return *s ? logTokenHash(s + 1, (h ^ static_cast<uint8_t>(*s)) * 16777619u) : h;
+}
+
+constexpr uint32_t logToken(const char* tag, const char* fmt) {
+    return logTokenHash(fmt, (logTokenHash(tag, 2166136261u) ^ 0x1Fu) * 16777619u);
+}
+
+// Binary search di tabel terurut; tidak ketemu = LOG_CODE_RAW_TOKEN
+constexpr uint16_t logTokenCode(uint32_t token, uint16_t lo = 0, uint16_t hi = LOG_TOKEN_TABLE_SIZE) {
+    return lo >= hi ? LOG_CODE_RAW_TOKEN
+         : LOG_TOKEN_TABLE[(lo + hi) / 2] == token ? LOG_CODE_FIRST_INDEX + (lo + hi) / 2
+         : LOG_TOKEN_TABLE[(lo + hi) / 2] < token ? logTokenCode(token, (lo + hi) / 2 + 1, hi)
+         : logTokenCode(token, lo, (lo + hi) / 2);
+}
+
+// integral_constant memaksa hash dan lookup dievaluasi saat compile, bukan saat runtime
+#define LOG_TOKEN(tag, fmt) \
+    (std::integral_constant<uint32_t, logToken(tag, fmt)>::value)
+#define LOG_TOKEN_CODE(tag, fmt) \
+    (std::integral_constant<uint16_t, logTokenCode(logToken(tag, fmt))>::value)
+
+// ===== COMPILE-TIME FORMAT CHECK =====
+// Decoder host memetakan satu konversi ke satu argumen dan tidak mengenal %p/%n.
+// Width/precision '*' menambah argumen tersembunyi → frame tidak bisa di-decode.
+constexpr bool logIsConversion(char c, const char* set = "diouxXeEfgGaAcs%") {
+    return *set ? (c == *set || logIsConversion(c, set + 1)) : false;
+}
+
+// inSpec: sedang di antara '%' dan karakter konversi
+constexpr bool logFormatSupported(const char* s, bool inSpec = false) {
+    return !*s ? !inSpec
+         : !inSpec ? logFormatSupported(s + 1, *s == '%')
+         : (*s == '*' || *s == 'p' || *s == 'n') ? false
+         : logFormatSupported(s + 1, !logIsConversion(*s));
+}
+
+// Hanya untuk pengecekan printf-format oleh compiler; tidak pernah dipanggil
+static inline void logFormatCheck(const char*, ...) __attribute__((format(printf, 1, 2)));
+static inline void logFormatCheck(const char*, ...) {}
+
+// ===== ARGUMENT ENCODER =====
+class LogEncoder {
+public:
+    LogEncoder(uint8_t* buffer, uint16_t capacity)
+        : buf(buffer), cap(capacity), len(0), sigPos(0), argIndex(0), overflow(false) {}
+
+    // Payload record: code varint, lalu token mentah jika tidak ada di tabel
+    void token(uint16_t code, uint32_t value) {
+        varint(code);
+        if (code != LOG_CODE_RAW_TOKEN) return;
+        for (uint8_t i = 0; i < 4; i++) put(static_cast<uint8_t>(value >> (8 * i)));
+    }
+
+    // Sisipkan byte signature kosong untuk argCount argumen
+    void beginArgs(uint8_t argCount) {
+        sigPos = len;
+        for (uint8_t i = 0; i < (argCount + 3) / 4; i++) put(0);
+    }
+
+    void arg(bool v)                { argUnsigned(v ? 1 : 0); }
+    void arg(char v)                { argSigned(v); }
+    void arg(signed char v)         { argSigned(v); }
+    void arg(unsigned char v)       { argUnsigned(v); }
+    void arg(short v)               { argSigned(v); }
+    void arg(unsigned short v)      { argUnsigned(v); }
+    void arg(int v)                 { argSigned(v); }
+    void arg(unsigned int v)        { argUnsigned(v); }
+    void arg(long v)                { argSigned(v); }
+    void arg(unsigned long v)       { argUnsigned(v); }
+    void arg(long long v)           { argSigned(v); }
+    void arg(unsigned long long v)  { argUnsigned(v); }
+    void arg(double v)              { argFloat(static_cast<float>(v)); }
+    void arg(float v)               { argFloat(v); }
+    void arg(char* v)               { argString(v); }
+    void arg(const char* v)         { argString(v); }
+
+    // Tipe lain: enum biasa di-encode sebagai signed. Pointer (%p, juga tidak
+    // lagi diam-diam jatuh ke arg(bool)), enum class, nullptr, String, dsb.
+    // ditolak saat compile - cast eksplisit di call site.
+    template <typename T>
+    void arg(const T& v) {
+        static_assert(std::is_enum<T>::value && std::is_convertible<T, int>::value,
+                      "LOG_x: tipe argumen tidak didukung format tokenized (cast eksplisit)");
+        argSigned(static_cast<int64_t>(v));
+    }
+
+    void args() {}
+
+    template <typename First, typename... Rest>
+    void args(const First& first, const Rest&... rest) {
+        arg(first);
+        args(rest...);
+    }
+
+    uint16_t length() const { return len; }
+    bool overflowed() const { return overflow; }
+
+private:
+    uint8_t* buf;
+    uint16_t cap;
+    uint16_t len;
+    uint16_t sigPos;
+    uint8_t argIndex;
+    bool overflow;
+
+    void put(uint8_t b) {
+        if (len < cap) buf[len++] = b;
+        else overflow = true;
+    }
+
+    void varint(uint64_t v) {
+        while (v >= 0x80) {
+            put(static_cast<uint8_t>(v) | 0x80);
+            v >>= 7;
+        }
+        put(static_cast<uint8_t>(v));
+    }
+
+    void markType(LogArgType type) {
+        uint16_t pos = sigPos + argIndex / 4;
+        if (pos < len) {
+            buf[pos] |= static_cast<uint8_t>(type) << (2 * (argIndex % 4));
+        }
+        argIndex++;
+    }
+
+    void argUnsigned(uint64_t v) {
+        markType(LogArgType::ARG_UNSIGNED);
+        varint(v);
+    }
+
+    void argSigned(int64_t v) {
+        markType(LogArgType::ARG_SIGNED);
+        varint((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+    }
+
+    void argFloat(float v) {
+        markType(LogArgType::ARG_FLOAT);
+        uint32_t bits;
+        memcpy(&bits, &v, sizeof(bits));
+        for (uint8_t i = 0; i < 4; i++) put(static_cast<uint8_t>(bits >> (8 * i)));
+    }
+
+    void argString(const char* s) {
+        markType(LogArgType::ARG_STRING);
+        if (!s) s = "";
+        uint8_t n = strnlen(s, LOG_MAX_STRING_ARG);
+        put(n);
+        for (uint8_t i = 0; i < n; i++) put(static_cast<uint8_t>(s[i]));
+    }
+};
+
+#endif
@@ -0,0 +1,50 @@
+// LogTokenTable.h
+// GENERATED oleh tools/logtok.py - jangan diedit manual.
+// Token terurut: index di sini = index di frame log tokenized.
+#ifndef LOG_TOKEN_TABLE_H
+#define LOG_TOKEN_TABLE_H
+
+#define LOG_TOKEN_TABLE_SIZE  218
+#define LOG_TOKEN_TABLE_ID    0x30beebdcu
+
+constexpr uint32_t LOG_TOKEN_TABLE[218] = {
+    0x0011951bu, 0x009bc4dbu, 0x00ade456u, 0x0316d4f3u, 0x045bef34u, 0x0beaea56u,
+    0x0f8ca8d6u, 0x11741789u, 0x12323a39u, 0x138deff6u, 0x13f19511u, 0x14df70e7u,
+    0x16776992u, 0x17a5dd73u, 0x185f9c09u, 0x1941ed27u, 0x195ed187u, 0x1b5686b0u,
+    0x1d90b15au, 0x1dae157cu, 0x1dfb351eu, 0x1ed167fau, 0x1eeb511cu, 0x1f6f5216u,
+    0x1fffcdd0u, 0x20d8915eu, 0x21247b82u, 0x227865aau, 0x234677d1u, 0x24b8cb6bu,
+    0x24f35bafu, 0x255e1d15u, 0x268c9601u, 0x26e3ca6cu, 0x280d97a3u, 0x2abae997u,
+    0x2ae58f13u, 0x2c43149au, 0x2c4e70b1u, 0x2dccc800u, 0x2dd1037au, 0x2fc2f2deu,
+    0x3189e4a5u, 0x31c02ee3u, 0x3241e2e5u, 0x3243f916u, 0x32c986e7u, 0x357ae4a8u,
+    0x36567c11u, 0x3766de1au, 0x38e152fau, 0x396d7808u, 0x39e2d421u, 0x3a305059u,
+    0x3a7e1bc3u, 0x3d1c4f1cu, 0x3e9bb8efu, 0x3ff6823fu, 0x404fc0e7u, 0x45080862u,
+    0x451dcfc6u, 0x4587373fu, 0x464a7ef5u, 0x46e79bd5u, 0x474ecf6fu, 0x4919cf98u,
+    0x4c778230u, 0x4cf51ddau, 0x4ed88f2bu, 0x4f7a9feau, 0x5030a4cdu, 0x52038076u,
+    0x5267b3ceu, 0x54ec8229u, 0x55a59aa9u, 0x578fa1ceu, 0x58f1b2d0u, 0x592e2021u,
+    0x5d3eb7dbu, 0x5e36dad1u, 0x5e54f374u, 0x5e7ea9ddu, 0x5ffa7311u, 0x6396a7b2u,
+    0x64462a2bu, 0x64dea357u, 0x67656827u, 0x682be3cdu, 0x683b7c37u, 0x68d799a3u,
+    0x691a3564u, 0x6be66977u, 0x6c9da44cu, 0x6df85f28u, 0x6e44b5c7u, 0x6e4bfcfdu,
+    0x6e97b324u, 0x7076ef4bu, 0x70771ecau, 0x713d98e1u, 0x724d64c9u, 0x72b53284u,
+    0x72b6a01du, 0x741c2a10u, 0x77164f17u, 0x77d6c5c1u, 0x782d1d8cu, 0x7c9617adu,
+    0x7cbee9a1u, 0x7db3e375u, 0x7ee6ec27u, 0x7f45db3eu, 0x7f6f5068u, 0x8022c81du,
+    0x81227e54u, 0x819d3ad0u, 0x8202352au, 0x8357701cu, 0x83c4e0f6u, 0x844c85eeu,
+    0x8524aec9u, 0x856d7037u, 0x896a2a80u, 0x89e0acfcu, 0x8b5d1810u, 0x8e48c636u,
+    0x8f271255u, 0x93aac2f1u, 0x992e288au, 0x99317c09u, 0x99960e66u, 0x9afe5eadu,
+    0x9f52f8f8u, 0xa005d9a5u, 0xa01339b6u, 0xa05c7c2eu, 0xa0d8b3e9u, 0xa1f898e8u,
+    0xa3c48646u, 0xa40d7a62u, 0xa653422eu, 0xa715fd1du, 0xaa948653u, 0xaacc83e4u,
+    0xaf51c19bu, 0xb256beacu, 0xb49dbbd2u, 0xb4e4b56bu, 0xb503cfbdu, 0xb62949e3u,
+    0xb6681d74u, 0xb672dba5u, 0xb69d46a7u, 0xb6e00bb9u, 0xb7e426a2u, 0xb82bfe07u,
+    0xb883b359u, 0xb902f9a8u, 0xb95b2605u, 0xba3d6088u, 0xbd3fbb9cu, 0xc0c0ab6fu,
+    0xc1757841u, 0xc1ca0a3cu, 0xc6054164u, 0xc70bfcf4u, 0xc8f02182u, 0xc98264e2u,
+    0xcc905fd5u, 0xce9c0161u, 0xcefc0669u, 0xcf5fc4f0u, 0xd089eee9u, 0xd0909110u,
+    0xd1a6fc85u, 0xd1da7d35u, 0xd20a8658u, 0xd2f8a7edu, 0xd30b1156u, 0xd7b5853fu,
+    0xd91c13c6u, 0xd93fe16eu, 0xdb7186c8u, 0xdc11287fu, 0xdc4b3d07u, 0xdc7b491du,
+    0xdccfa232u, 0xdd92f267u, 0xe08c98b0u, 0xe34433e4u, 0xe48ee46fu, 0xe592b0a5u,
+    0xe887fe9au, 0xe91446b9u, 0xe9517f5cu, 0xe9cd26a1u, 0xebc77540u, 0xebcbf2a7u,
+    0xebe0fbf7u, 0xed139e05u, 0xed8f0c1bu, 0xee514806u, 0xf0a4377cu, 0xf4e859a6u,
+    0xf860706cu, 0xf8e3f119u, 0xf987b967u, 0xf9b990f3u, 0xfb239434u, 0xfbe68952u,
+    0xfc2cc151u, 0xfc4303b0u, 0xfc626c9du, 0xfc729f77u, 0xfcbd9fa9u, 0xff0e3b5fu,
+    0xff30e51eu, 0xff3dd9e7u,
+};
+
+#endif
@@ -0,0 +1,255 @@
+// Logger.cpp
+#include "Logger.h"
+
+static const uint32_t RING_MASK = LOG_RING_SLOTS - 1;
+static_assert((LOG_RING_SLOTS & RING_MASK) == 0, "LOG_RING_SLOTS harus power of two");
+// Header frame menambah TS (≤5 byte) dan paling banyak 1 byte di ID
+static_assert(LOG_RECORD_LEN + 6 <= 255, "LEN frame tokenized hanya 1 byte");
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) - dihitung di drain task, bukan di caller
+static uint16_t crc16Update(uint16_t crc, const uint8_t* data, uint16_t len) {
+    for (uint16_t i = 0; i < len; i++) {
+        crc ^= static_cast<uint16_t>(data[i]) << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint8_t encodeVarint(uint8_t* out, uint32_t value) {
+    uint8_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = static_cast<uint8_t>(value) | 0x80;
+        value >>= 7;
+    }
+    out[n++] = static_cast<uint8_t>(value);
+    return n;
+}
+
+// ===== PUBLIC API =====
+
+void Logger::begin() {
+    if (drainTaskHandle) return;
+
+    drainTaskHandle = xTaskCreateStaticPinnedToCore(
+        drainTask,
+        "LogDrainTask",
+        LOG_TASK_STACK,
+        this,
+        LOG_TASK_PRIORITY,
+        drainTaskStack,
+        &drainTaskBuffer,
+        LOG_TASK_CORE
+    );
+
+    LOG_I("LOG", "Async logger started (%u slots/core, level %d, format %d)",
+          (unsigned)LOG_RING_SLOTS, LOG_LEVEL, LOG_FORMAT);
+}
+
+void Logger::write(uint8_t level, const char* tag, const char* fmt, ...) {
+    Ring& ring = rings[xPortGetCoreID()];
+
+    Slot* slot = reserve(ring);
+    if (!slot) return;  // Ring penuh - sudah dihitung di reserve()
+
+    int prefix = snprintf(slot->data, LOG_RECORD_LEN, "[%s] ", tag);
+    if (prefix < 0) prefix = 0;
+    if (prefix > LOG_RECORD_LEN - 1) prefix = LOG_RECORD_LEN - 1;
+
+    va_list args;
+    va_start(args, fmt);
+    int body = vsnprintf(slot->data + prefix, LOG_RECORD_LEN - prefix, fmt, args);
+    va_end(args);
+    if (body < 0) body = 0;
+
+    int total = prefix + body;
+    bool truncated = (total > LOG_RECORD_LEN - 1);
+    if (truncated) total = LOG_RECORD_LEN - 1;
+
+    commit(ring, *slot, level, total, truncated);
+}
+
+LogStats Logger::getStats(uint8_t core) {
+    LogStats stats = {};
+    if (core >= portNUM_PROCESSORS) return stats;
+
+    Ring& ring = rings[core];
+    stats.written = ring.written.load(std::memory_order_relaxed);
+    stats.dropped = ring.dropped.load(std::memory_order_relaxed);
+    stats.truncated = ring.truncated.load(std::memory_order_relaxed);
+    stats.highWater = ring.highWater.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// ===== DEBUG =====
+
+void Logger::printStats() {
+    for (uint8_t core = 0; core < portNUM_PROCESSORS; core++) {
+        LogStats stats = getStats(core);
+        LOG_I("LOG", "core %u: written=%lu dropped=%lu truncated=%lu highWater=%u/%u",
+              core,
+              (unsigned long)stats.written,
+              (unsigned long)stats.dropped,
+              (unsigned long)stats.truncated,
+              stats.highWater,
+              (unsigned)LOG_RING_SLOTS);
+    }
+}
+
+// ===== RING BUFFER =====
+
+Logger::Slot* Logger::reserve(Ring& ring) {
+    // Multi-producer: task lain di core yang sama bisa preempt di tengah,
+    // jadi slot di-claim dengan CAS, bukan dengan lock.
+    uint32_t head = ring.head.load(std::memory_order_relaxed);
+    uint32_t used;
+
+    do {
+        used = head - ring.tail.load(std::memory_order_acquire);
+        if (used >= LOG_RING_SLOTS) {
+            ring.dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+    } while (!ring.head.compare_exchange_weak(
+        head, head + 1,
+        std::memory_order_acq_rel,
+        std::memory_order_relaxed));
+
+    // High-water mark (best effort, boleh kalah race)
+    uint16_t depth = used + 1;
+    if (depth > ring.highWater.load(std::memory_order_relaxed)) {
+        ring.highWater.store(depth, std::memory_order_relaxed);
+    }
+
+    return &ring.slots[head & RING_MASK];
+}
+
+void Logger::commit(Ring& ring, Slot& slot, uint8_t level, uint16_t length, bool truncated) {
+    if (truncated) {
+        ring.truncated.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    slot.level = level;
+    slot.length = length;
+    slot.timestamp = millis();
+    ring.written.fetch_add(1, std::memory_order_relaxed);
+
+    // Publish: drain task baru boleh membaca slot setelah flag ini
+    slot.ready.store(1, std::memory_order_release);
+}
+
+bool Logger::drainOne(Ring& ring) {
+    uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+    if (tail == ring.head.load(std::memory_order_acquire)) {
+        return false;  // Kosong
+    }
+
+    Slot& slot = ring.slots[tail & RING_MASK];
+    if (!slot.ready.load(std::memory_order_acquire)) {
+        // Sudah di-claim tapi producer belum selesai menulis (ter-preempt)
+        return false;
+    }
+
+    // Hanya drain task yang menyentuh UART - boleh blocking di sini
+#if LOG_FORMAT == LOG_FORMAT_TOKENIZED
+    // Payload = code varint (LogEncoder::token) + sisa body apa adanya
+    const uint8_t* payload = reinterpret_cast<const uint8_t*>(slot.data);
+    if (slot.length > 0) {
+        // Time-sync hanya mendahului frame: log diam = UART diam
+        uint32_t now = millis();
+        if (!timeSyncSent || now - lastTimeSyncMs >= LOG_TIME_SYNC_MS) {
+            emitTimeSync(now);
+        }
+
+        uint16_t code = 0;
+        uint16_t pos = 0;
+        uint8_t b;
+        do {
+            b = payload[pos];
+            code |= static_cast<uint16_t>(b & 0x7F) << (7 * pos);
+            pos++;
+        } while ((b & 0x80) && pos < slot.length);
+        emitFrame(code, slot.timestamp, payload + pos, slot.length - pos);
+    }
+#else
+    Serial.write(reinterpret_cast<const uint8_t*>(slot.data), slot.length);
+    Serial.write('\n');
+#endif
+
+    slot.ready.store(0, std::memory_order_relaxed);
+    ring.tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+void Logger::reportDrops() {
+    for (uint8_t core = 0; core < portNUM_PROCESSORS; core++) {
+        uint32_t dropped = rings[core].dropped.load(std::memory_order_relaxed);
+        if (dropped != reportedDropped[core]) {
+            Serial.printf("[LOG] core %u: %lu records dropped (ring full)\n",
+                          core, (unsigned long)(dropped - reportedDropped[core]));
+            reportedDropped[core] = dropped;
+        }
+    }
+}
+
+// ===== TOKENIZED FRAMING =====
+
+void Logger::emitFrame(uint16_t code, uint32_t timestamp, const uint8_t* body, uint16_t bodyLen) {
+    // Timestamp relatif ke frame sebelumnya (burst di ms yang sama: TS dihilangkan);
+    // zigzag karena record dari core lain bisa lebih tua dari frame yang sudah terkirim
+    int32_t delta = static_cast<int32_t>(timestamp - lastFrameMs);
+    uint32_t zigzag = (static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31);
+    lastFrameMs = timestamp;
+
+    uint8_t header[2 + 3 + 5];
+    uint8_t headerLen = 2;
+    headerLen += encodeVarint(&header[headerLen], (static_cast<uint32_t>(code) << 1) | (delta ? 1 : 0));
+    if (delta) headerLen += encodeVarint(&header[headerLen], zigzag);
+
+    uint16_t length = (headerLen - 2) + bodyLen;
+    if (length > 255) return;  // Dijaga static_assert LOG_RECORD_LEN di atas
+
+    header[0] = LOG_FRAME_SYNC;
+    header[1] = static_cast<uint8_t>(length);
+
+    uint16_t crc = crc16Update(0xFFFF, &header[1], headerLen - 1);
+    crc = crc16Update(crc, body, bodyLen);
+    uint8_t trailer[2] = { static_cast<uint8_t>(crc), static_cast<uint8_t>(crc >> 8) };
+
+    Serial.write(header, headerLen);
+    Serial.write(body, bodyLen);
+    Serial.write(trailer, sizeof(trailer));
+}
+
+void Logger::emitTimeSync(uint32_t nowMs) {
+    lastTimeSyncMs = nowMs;
+    lastFrameMs = nowMs;        // Frame sync sendiri tanpa TS
+    timeSyncSent = true;
+
+    // Code 0: body = millis() absolut (varint) + ID LogTokenTable.h
+    uint8_t body[5 + 4];
+    uint8_t bodyLen = encodeVarint(body, nowMs);
+    for (uint8_t i = 0; i < 4; i++) {
+        body[bodyLen++] = static_cast<uint8_t>(LOG_TOKEN_TABLE_ID >> (8 * i));
+    }
+    emitFrame(LOG_CODE_TIME_SYNC, nowMs, body, bodyLen);
+}
+
+void Logger::drainTask(void* pvParameters) {
+    Logger* self = static_cast<Logger*>(pvParameters);
+
+    for (;;) {
+        bool any;
+        do {
+            any = false;
+            for (uint8_t core = 0; core < portNUM_PROCESSORS; core++) {
+                any |= self->drainOne(self->rings[core]);
+            }
+        } while (any);
+
+        self->reportDrops();
+
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_PERIOD_MS));
+    }
+}
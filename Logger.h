@@ -0,0 +1,163 @@
+// Logger.h
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "LogToken.h"
+
+// ===== LOG LEVELS =====
+#define LOG_LEVEL_NONE   0
+#define LOG_LEVEL_ERROR  1
+#define LOG_LEVEL_WARN   2
+#define LOG_LEVEL_INFO   3
+#define LOG_LEVEL_DEBUG  4
+
+// Level compile-time: call di atas level ini dihapus total oleh preprocessor
+// (argumen tidak dievaluasi). Override lewat build flag -DLOG_LEVEL=...
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// ===== OUTPUT FORMAT =====
+#define LOG_FORMAT_TEXT       0      // "[TAG] pesan" diformat di device
+#define LOG_FORMAT_TOKENIZED  1      // Token + argumen biner, decode di host (LogToken.h)
+
+#ifndef LOG_FORMAT
+#define LOG_FORMAT LOG_FORMAT_TEXT
+#endif
+
+// ===== BUFFER CONFIG =====
+#define LOG_RING_SLOTS        32     // Slot per core (harus power of two)
+#define LOG_RECORD_LEN        112    // Panjang maksimum per record (teks atau payload token)
+#define LOG_DRAIN_PERIOD_MS   20     // Interval drain task saat ring kosong
+#define LOG_TASK_STACK        3072
+#define LOG_TASK_PRIORITY     0      // Paling rendah, setara idle task
+#define LOG_TASK_CORE         0
+#define LOG_TIME_SYNC_MS      5000   // Jarak minimum time-sync frame, hanya sebelum frame log (mode tokenized)
+
+// ===== STATISTICS =====
+struct LogStats {
+    uint32_t written;       // Record berhasil masuk ring
+    uint32_t dropped;       // Record dibuang karena ring penuh
+    uint32_t truncated;     // Record terpotong karena > LOG_RECORD_LEN
+    uint16_t highWater;     // Jumlah slot terisi maksimum
+};
+
+// ===== LOGGER CLASS =====
+// Producer (semua task) hanya menulis ke ring buffer per-core secara lock-free,
+// tidak pernah menunggu UART. Drain task prioritas rendah yang menulis ke Serial.
+// Jika ring penuh, record dibuang dan dihitung - caller tidak pernah blocking.
+//
+// Tidak punya constructor: instance global di-zero-initialize sebelum constructor
+// global lain berjalan, jadi constructor modul lain boleh langsung logging.
+class Logger {
+public:
+    void begin();
+
+    void write(uint8_t level, const char* tag, const char* fmt, ...)
+        __attribute__((format(printf, 4, 5)));
+
+    // Mode tokenized: hanya token + argumen mentah, tanpa formatting di device
+    template <typename... Args>
+    void writeToken(uint8_t level, uint16_t code, uint32_t token, const Args&... args) {
+        Ring& ring = rings[xPortGetCoreID()];
+        Slot* slot = reserve(ring);
+        if (!slot) return;
+
+        LogEncoder encoder(reinterpret_cast<uint8_t*>(slot->data), LOG_RECORD_LEN);
+        encoder.token(code, token);
+        encoder.beginArgs(sizeof...(Args));
+        encoder.args(args...);
+
+        commit(ring, *slot, level, encoder.length(), encoder.overflowed());
+    }
+
+    LogStats getStats(uint8_t core);
+
+    // ===== DEBUG =====
+    void printStats();
+
+private:
+    struct Slot {
+        std::atomic<uint8_t> ready;
+        uint8_t level;
+        uint16_t length;
+        uint32_t timestamp;             // millis() saat record dibuat
+        char data[LOG_RECORD_LEN];      // Teks atau payload token (lihat LOG_FORMAT)
+    };
+
+    struct Ring {
+        std::atomic<uint32_t> head;     // Slot berikutnya untuk producer
+        std::atomic<uint32_t> tail;     // Slot berikutnya untuk drain task
+        std::atomic<uint32_t> written;
+        std::atomic<uint32_t> dropped;
+        std::atomic<uint32_t> truncated;
+        std::atomic<uint16_t> highWater;
+        Slot slots[LOG_RING_SLOTS];
+    };
+
+    Ring rings[portNUM_PROCESSORS];
+    uint32_t reportedDropped[portNUM_PROCESSORS];
+    TaskHandle_t drainTaskHandle;
+    StaticTask_t drainTaskBuffer;
+    StackType_t drainTaskStack[LOG_TASK_STACK];
+
+    // Mode tokenized: basis timestamp frame
+    uint32_t lastTimeSyncMs;
+    uint32_t lastFrameMs;           // TS frame = selisih terhadap frame sebelumnya
+    bool timeSyncSent;
+
+    Slot* reserve(Ring& ring);
+    void commit(Ring& ring, Slot& slot, uint8_t level, uint16_t length, bool truncated);
+    bool drainOne(Ring& ring);
+    void reportDrops();
+
+    void emitFrame(uint16_t code, uint32_t timestamp, const uint8_t* body, uint16_t bodyLen);
+    void emitTimeSync(uint32_t nowMs);
+
+    static void drainTask(void* pvParameters);
+};
+
+extern Logger logger;
+
+// ===== LOGGING MACROS =====
+// Pemakaian: LOG_I("FILLING", "Float sensor STABLE for %lu ms", duration);
+// tag dan fmt harus string literal (di-hash saat compile di mode tokenized).
+#if LOG_FORMAT == LOG_FORMAT_TOKENIZED
+#define LOG_EMIT(level, tag, fmt, ...) do {                              \
+        static_assert(logFormatSupported(fmt),                           \
+                      "LOG_x: %p/%n/'*' tidak didukung tokenized");      \
+        if (0) logFormatCheck(fmt, ##__VA_ARGS__);                       \
+        logger.writeToken(level, LOG_TOKEN_CODE(tag, fmt),               \
+                          LOG_TOKEN(tag, fmt), ##__VA_ARGS__);           \
+    } while (0)
+#else
+#define LOG_EMIT(level, tag, fmt, ...) logger.write(level, tag, fmt, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(tag, fmt, ...) LOG_EMIT(LOG_LEVEL_ERROR, tag, fmt, ##__VA_ARGS__)
+#else
+#define LOG_E(tag, fmt, ...) do { } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(tag, fmt, ...) LOG_EMIT(LOG_LEVEL_WARN, tag, fmt, ##__VA_ARGS__)
+#else
+#define LOG_W(tag, fmt, ...) do { } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(tag, fmt, ...) LOG_EMIT(LOG_LEVEL_INFO, tag, fmt, ##__VA_ARGS__)
+#else
+#define LOG_I(tag, fmt, ...) do { } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(tag, fmt, ...) LOG_EMIT(LOG_LEVEL_DEBUG, tag, fmt, ##__VA_ARGS__)
+#else
+#define LOG_D(tag, fmt, ...) do { } while (0)
+#endif
+
+#endif
@@ -0,0 +1,127 @@
+// Mailbox.h
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#include <Arduino.h>
+#include <atomic>
+
+struct MailboxStats {
+    uint32_t received;
+    uint32_t dropped;           // post() saat penuh
+    uint32_t depth;             // Isi saat ini
+    uint32_t highWater;         // Isi terbanyak sejak boot
+    uint32_t maxLatencyUs;      // post → receive
+    uint32_t avgLatencyUs;
+};
+
+// ===== MAILBOX =====
+// Antrian pesan bertipe, kapasitas tetap N (power of two), lock-free:
+// banyak producer (task mana saja, bukan ISR), satu consumer = task pemilik
+// state. Producer tidak pernah menunggu: penuh → pesan dibuang & dihitung.
+// Slot ber-sequence (ring Vyukov): producer klaim slot dengan CAS, consumer
+// membaca tanpa atomic RMW. Pesan di-copy by value ke slot (tanpa heap).
+template <typename T, uint32_t N>
+class Mailbox {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "Kapasitas mailbox harus power of two");
+
+public:
+    Mailbox()
+        : enqueuePos(0)
+        , dequeuePos(0)
+        , dropped(0)
+        , highWater(0)
+        , received(0)
+        , maxLatencyUs(0)
+        , totalLatencyUs(0)
+    {
+        for (uint32_t i = 0; i < N; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool post(const T& message) {
+        uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & (N - 1)];
+            uint32_t seq = cell->sequence.load(std::memory_order_acquire);
+            int32_t diff = static_cast<int32_t>(seq - pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->message = message;
+        cell->postedUs = micros();
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        uint32_t depth = pendingCount();
+        uint32_t high = highWater.load(std::memory_order_relaxed);
+        while (depth > high && !highWater.compare_exchange_weak(high, depth, std::memory_order_relaxed)) {}
+        return true;
+    }
+
+    // Hanya dari task pemilik (single consumer)
+    bool receive(T& out) {
+        uint32_t pos = dequeuePos.load(std::memory_order_relaxed);
+        Cell& cell = cells[pos & (N - 1)];
+        uint32_t seq = cell.sequence.load(std::memory_order_acquire);
+        if (static_cast<int32_t>(seq - (pos + 1)) < 0) return false;
+
+        out = cell.message;
+        uint32_t latencyUs = micros() - cell.postedUs;
+        cell.sequence.store(pos + N, std::memory_order_release);
+        dequeuePos.store(pos + 1, std::memory_order_relaxed);
+
+        received++;
+        totalLatencyUs += latencyUs;
+        if (latencyUs > maxLatencyUs) maxLatencyUs = latencyUs;
+        return true;
+    }
+
+    // Statistik consumer dibaca tanpa sinkronisasi (debug: boleh selisih satu pesan)
+    MailboxStats getStats() const {
+        MailboxStats stats;
+        stats.received = received;
+        stats.dropped = dropped.load(std::memory_order_relaxed);
+        stats.depth = pendingCount();
+        stats.highWater = highWater.load(std::memory_order_relaxed);
+        stats.maxLatencyUs = maxLatencyUs;
+        stats.avgLatencyUs = received ? static_cast<uint32_t>(totalLatencyUs / received) : 0;
+        return stats;
+    }
+
+    static uint32_t capacity() { return N; }
+
+private:
+    struct Cell {
+        std::atomic<uint32_t> sequence;
+        uint32_t postedUs;
+        T message;
+    };
+
+    Cell cells[N];
+    std::atomic<uint32_t> enqueuePos;
+    std::atomic<uint32_t> dequeuePos;
+    std::atomic<uint32_t> dropped;
+    std::atomic<uint32_t> highWater;
+
+    // Milik consumer
+    uint32_t received;
+    uint32_t maxLatencyUs;
+    uint64_t totalLatencyUs;
+
+    // dequeuePos dibaca dulu: enqueuePos (monoton) tidak pernah di belakangnya
+    uint32_t pendingCount() const {
+        uint32_t dequeued = dequeuePos.load(std::memory_order_relaxed);
+        int32_t count = static_cast<int32_t>(enqueuePos.load(std::memory_order_relaxed) - dequeued);
+        return count > 0 ? static_cast<uint32_t>(count) : 0;
+    }
+};
+
+#endif
@@ -1,9 +1,12 @@
 #include "NextionGateWay.h"
+#include "SystemVariables.h"
+#include "EventBus.h"
+#include "Logger.h"
 
 // ===== CONSTRUCTOR / DESTRUCTOR =====
 
 NextionGateWay::NextionGateWay() {
-    mutex = xSemaphoreCreateMutex();
+    mutex = xSemaphoreCreateMutexStatic(&mutexBuffer);
 }
 
 NextionGateWay::~NextionGateWay() {
@@ -17,35 +20,85 @@ void NextionGateWay::begin() {
 }
 
 void NextionGateWay::readTask() {
+    flushTx();
+    
     while (NEXTION.available()) {
-        buffer[bufferIndex++] = NEXTION.read();
+        uint8_t c = NEXTION.read();
+        buffer[bufferIndex++] = c;
         lastReceiveTime = millis();
+        terminatorCount = (c == 0xFF) ? terminatorCount + 1 : 0;
 
-        if (bufferIndex >= BUFFER_SIZE) {
+        // Frame Nextion diakhiri FF FF FF: proses langsung, tidak menunggu RX diam
+        if (terminatorCount >= 3 || bufferIndex >= BUFFER_SIZE) {
             processBuffer();
             bufferIndex = 0;
+            terminatorCount = 0;
         }
     }
 
     if (bufferIndex > 0 && millis() - lastReceiveTime > RECEIVE_TIMEOUT) {
         processBuffer();
         bufferIndex = 0;
+        terminatorCount = 0;
+    }
+}
+
+void NextionGateWay::send(const char* cmd) {
+    NextionCommand message(cmd);
+    if (message.truncated()) {
+        LOG_W("NextionGateWay", "Command too long - dropped: %s", cmd);
+        return;
+    }
+    if (!txMailbox.post(message)) {
+        LOG_W("NextionGateWay", "TX mailbox full - dropped: %s", cmd);
     }
 }
 
-void NextionGateWay::send(const String &cmd) {
-    NEXTION.print(cmd);
-    NEXTION.write(0xFF);
-    NEXTION.write(0xFF);
-    NEXTION.write(0xFF);
+MailboxStats NextionGateWay::getTxStats() const {
+    return txMailbox.getStats();
 }
 
 NextionData NextionGateWay::getData() {
-    NextionData copy;
+    return snapshot.read();
+}
+
+uint32_t NextionGateWay::getData(NextionData& out) {
+    return snapshot.read(out);
+}
+
+uint32_t NextionGateWay::getVersion() {
+    return snapshot.version();
+}
+
+void NextionGateWay::setEventQueue(QueueHandle_t queue) {
+    eventQueue = queue;
+}
+
+void NextionGateWay::setEventBus(EventBus* bus) {
+    eventBus = bus;
+}
+
+void NextionGateWay::seedSettings(const SystemVariables& settings) {
     lock();
-    copy = data;
+    data.setAuto = settings.setAuto;
+    data.daysValue = settings.daysValue;
+    data.autoTemp = settings.autoTemp;
+    data.countValue = settings.countValue;
+    data.coolingValue = settings.coolingValue;
+    publishData();
     unlock();
-    return copy;
+}
+
+void NextionGateWay::restoreButtons(bool filling, bool cooling, bool draining, bool autoOn, bool circulation) {
+    lock();
+    data.fillingStatus = filling;
+    data.coolingStatus = cooling;
+    data.drainingStatus = draining;
+    data.autoStatus = autoOn;
+    data.circulationStatus = circulation;
+    publishData();
+    unlock();
+    LOG_I("NextionGateWay", "Button status restored from checkpoint");
 }
 
 // ===== FIX: Clear status methods =====
@@ -53,19 +106,31 @@ NextionData NextionGateWay::getData() {
 void NextionGateWay::clearFillingStatus() {
     lock();
     data.fillingStatus = false;
+    publishData();
     unlock();
-    Serial.println("[NextionGateWay] fillingStatus CLEARED");
+    LOG_I("NextionGateWay", "fillingStatus CLEARED");
 }
 
 void NextionGateWay::clearDrainingStatus() {
     lock();
     data.drainingStatus = false;
+    publishData();
     unlock();
-    Serial.println("[NextionGateWay] drainingStatus CLEARED");
+    LOG_I("NextionGateWay", "drainingStatus CLEARED");
 }
 
 // ===== INTERNAL =====
 
+void NextionGateWay::flushTx() {
+    NextionCommand cmd;
+    while (txMailbox.receive(cmd)) {
+        NEXTION.print(cmd.c_str());
+        NEXTION.write(0xFF);
+        NEXTION.write(0xFF);
+        NEXTION.write(0xFF);
+    }
+}
+
 void NextionGateWay::processBuffer() {
     // ===== CEK COOLING_ON + RAW BYTE =====
     static const char COOLING_KEYWORD[] = "COOLING_ON";
@@ -79,10 +144,10 @@ void NextionGateWay::processBuffer() {
             if (value >= 1 && value <= 100) {
                 lock();
                 data.coolingValue = value;
+                publishData();
                 unlock();
                 
-                Serial.print("[RX] COOLING_ON with value = ");
-                Serial.println(value);
+                LOG_I("RX", "COOLING_ON with value = %u", value);
                 
                 foundCoolingValue = true;
             }
@@ -91,29 +156,35 @@ void NextionGateWay::processBuffer() {
     }
     
     // ===== EXTRACT MESSAGE STRING =====
-    String msg = extractMessage();
+    NextionMessage msg;
+    extractMessage(msg);
+    bool recognized = false;
     if (msg.length()) {
-        handleMessage(msg);  // ← Ini akan process "COOLING_ON" untuk state change
+        recognized = handleMessage(msg);  // ← Ini akan process "COOLING_ON" untuk state change
+    }
+    
+    // Bangunkan FSM sekarang, tidak menunggu polling berikutnya
+    if (recognized || foundCoolingValue) {
+        fsmPostEvent(eventQueue, FsmEvent::EV_UI_CHANGED);
     }
 }
 
-String NextionGateWay::extractMessage() {
-    String msg;
+void NextionGateWay::extractMessage(NextionMessage &msg) {
+    msg.clear();
     for (uint16_t i = 0; i < bufferIndex; i++) {
         uint8_t c = buffer[i];
         if (c == 0xFF) break;
         if (c >= 32 && c <= 126) msg += char(c);
     }
     msg.trim();
-    return msg;
 }
 
-void NextionGateWay::handleMessage(const String &msg) {
+bool NextionGateWay::handleMessage(const NextionMessage &msg) {
+    bool recognized = true;
+    
     lock();
 
-    Serial.print("[RX] '");
-    Serial.print(msg);
-    Serial.println("'");
+    LOG_D("RX", "'%s'", msg.c_str());
 
     // ===== SIMPLE TOGGLES =====
     if (msg == "COOLING_ON")             data.coolingStatus = true;
@@ -150,13 +221,27 @@ void NextionGateWay::handleMessage(const String &msg) {
     else if (msg == "EXIT_BYPASS_MENU")  data.inBypassMenu = false;
 
     // ===== VALUES =====
-    else if (msg.startsWith("settime="))   data.setTime    = msg.substring(8);
-    else if (msg.startsWith("setAuto="))   data.setAuto    = msg.substring(8);
-    else if (msg.startsWith("count"))      data.countValue = msg.substring(5).toInt();
-    else if (msg.startsWith("days:"))      data.daysValue  = msg.substring(5).toInt();
-    else if (msg.startsWith("autotemp"))   data.autoTemp   = msg.substring(8).toInt();
+    else if (msg.startsWith("settime="))   data.setTime    = msg.from(8);
+    else if (msg.startsWith("setAuto="))   data.setAuto    = msg.from(8);
+    else if (msg.startsWith("count"))      data.countValue = atoi(msg.from(5));
+    else if (msg.startsWith("days:"))      data.daysValue  = atoi(msg.from(5));
+    else if (msg.startsWith("autotemp"))   data.autoTemp   = atoi(msg.from(8));
+
+    else recognized = false;
 
+    if (recognized) {
+        publishData();
+    }
     unlock();
+    return recognized;
+}
+
+// Dipanggil dengan mutex writer dipegang: snapshot + topic ui. Mutex yang sama
+// menserialisasi semua publisher ui (RX task, FSM task, setup), dan hanya
+// writer yang menunggunya - reader snapshot tidak ikut tertahan.
+void NextionGateWay::publishData() {
+    snapshot.publish(data);
+    if (eventBus) eventBus->ui.publish(data);
 }
 
 // ===== MUTEX =====
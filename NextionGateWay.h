@@ -2,6 +2,13 @@
 #define NEXTION_GATEWAY_H
 
 #include <Arduino.h>
+#include "FsmEvent.h"
+#include "FixedString.h"
+#include "SeqLock.h"
+#include "Mailbox.h"
+
+struct SystemVariables;
+struct EventBus;
 
 // ===== SERIAL CONFIG =====
 #define NEXTION Serial2
@@ -10,7 +17,10 @@
 
 // ===== BUFFER CONFIG =====
 #define BUFFER_SIZE 100
-#define RECEIVE_TIMEOUT 50
+#define RECEIVE_TIMEOUT 50          // Fallback: data tanpa terminator FF FF FF
+#define NEXTION_TX_MAILBOX 16       // Command menunggu ditulis RX/TX task
+
+typedef FixedString<BUFFER_SIZE> NextionMessage;
 
 // ===== DATA MODEL =====
 struct NextionData {
@@ -29,8 +39,9 @@ struct NextionData {
     bool bypassOzone = false;
     bool bypassHydro = false;
 
-    String setTime;
-    String setAuto;
+    // Fixed buffer: snapshot di-copy tiap 200 ms tanpa malloc/free
+    TimeText setTime;
+    TimeText setAuto;
 
     uint16_t countValue = 0;
     uint16_t daysValue = 0;
@@ -46,9 +57,30 @@ public:
 
     void begin();
     void readTask();
-    void send(const String &cmd);
+    
+    // Task mana saja: command masuk mailbox TX, UART hanya ditulis NextionTask
+    // (tidak ada penulis UART yang saling menyela, pengirim tidak menunggu 9600 baud)
+    void send(const char* cmd);
+    MailboxStats getTxStats() const;
 
+    // Snapshot seqlock: reader tidak menunggu RX task; versi naik tiap perubahan
     NextionData getData();
+    uint32_t getData(NextionData& out);
+    uint32_t getVersion();
+    
+    // EV_UI_CHANGED di-post ke queue ini setiap ada command yang dikenali
+    void setEventQueue(QueueHandle_t queue);
+    
+    // Setiap perubahan data (command panel, seed, restore, clear*) juga
+    // di-publish ke topic ui
+    void setEventBus(EventBus* bus);
+    
+    // Nilai setting awal = tersimpan di NVS, supaya snapshot pertama tidak
+    // menimpa setting dengan 0 sebelum panel mengirim nilainya
+    void seedSettings(const SystemVariables& settings);
+    
+    // Resume setelah reset: status tombol dari checkpoint (snapshot kosong saat boot)
+    void restoreButtons(bool filling, bool cooling, bool draining, bool autoOn, bool circulation);
     
     // ===== FIX: Method untuk clear fillingStatus =====
     void clearFillingStatus();
@@ -58,13 +90,22 @@ private:
     uint8_t buffer[BUFFER_SIZE];
     uint16_t bufferIndex = 0;
     unsigned long lastReceiveTime = 0;
+    uint8_t terminatorCount = 0;    // 0xFF berurutan di akhir buffer
 
-    NextionData data;
-    SemaphoreHandle_t mutex;
+    NextionData data;               // Milik writer (RX task, clear*/restore dari FSM)
+    SeqLock<NextionData> snapshot;
+    SemaphoreHandle_t mutex;        // Hanya antar writer
+    StaticSemaphore_t mutexBuffer;
+    QueueHandle_t eventQueue = nullptr;
+    EventBus* eventBus = nullptr;
 
+    Mailbox<NextionCommand, NEXTION_TX_MAILBOX> txMailbox;
+    
+    void flushTx();
     void processBuffer();
-    String extractMessage();
-    void handleMessage(const String &msg);
+    void extractMessage(NextionMessage &msg);
+    bool handleMessage(const NextionMessage &msg);  // true jika command dikenali
+    void publishData();
 
     void lock();
     void unlock();
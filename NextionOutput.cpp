@@ -1,10 +1,14 @@
 // NextionOutput.cpp
 #include "NextionOutput.h"
+#include "SystemVariables.h"
+#include "NextionGateWay.h"
+#include "Logger.h"
 
 // ===== CONSTRUCTOR / DESTRUCTOR =====
 
-NextionOutput::NextionOutput() {
-    // Constructor kosong, inisialisasi di begin()
+NextionOutput::NextionOutput()
+    : gateway(nullptr)
+{
 }
 
 NextionOutput::~NextionOutput() {
@@ -14,12 +18,31 @@ NextionOutput::~NextionOutput() {
 // ===== PUBLIC METHODS =====
 
 void NextionOutput::begin() {
-    Serial.println("[NextionOutput] Initialized");
+    LOG_I("NextionOutput", "Initialized");
+}
+
+void NextionOutput::setGateway(NextionGateWay* nextionGateway) {
+    gateway = nextionGateway;
 }
 
 void NextionOutput::updateCoolingDuration(uint16_t minutes) {
-    String cmd = "nCoolDurMan.val=" + String(minutes);
-    sendCommand(cmd);
+    NextionCommand cmd;
+    cmd.format("nCoolDurMan.val=%u", minutes);
+    sendCommand(cmd.c_str());
+}
+
+void NextionOutput::updateCoolingEta(bool valid, uint16_t minutes, uint16_t marginMinutes) {
+    // tCoolEta: "--" selama estimator belum konvergen, "25±4 min" setelahnya
+    NextionCommand cmd("tCoolEta.txt=\"");
+    if (valid) {
+        cmd.appendf("%u", minutes);
+        if (marginMinutes > 0) cmd.appendf("\xB1%u", marginMinutes);   // ± (font ISO-8859-1)
+        cmd += " min";
+    } else {
+        cmd += "--";
+    }
+    cmd += '"';
+    sendCommand(cmd.c_str());
 }
 
 void NextionOutput::setErrorBlink(bool enable) {
@@ -27,12 +50,12 @@ void NextionOutput::setErrorBlink(bool enable) {
         // Enable error blinking animation
         sendCommand("blinkingEF.val=1");
         sendCommand("tBlinkEF.en=1");
-        Serial.println("[NextionOutput] Error blink ENABLED");
+        LOG_I("NextionOutput", "Error blink ENABLED");
     } else {
         // Disable error blinking animation
         sendCommand("blinkingEF.val=0");
         sendCommand("tBlinkEF.en=0");
-        Serial.println("[NextionOutput] Error blink DISABLED");
+        LOG_I("NextionOutput", "Error blink DISABLED");
     }
 }
 
@@ -46,7 +69,7 @@ void NextionOutput::forceFillingOff() {
     // Note: This will trigger Nextion button logic, but we handle it in FSM
     sendCommand("activeProcess.val=0");
     
-    Serial.println("[NextionOutput] Force FILLING OFF (auto-complete)");
+    LOG_I("NextionOutput", "Force FILLING OFF (auto-complete)");
 }
 
 void NextionOutput::forceDrainingOff() {
@@ -59,19 +82,28 @@ void NextionOutput::forceDrainingOff() {
     // Note: This will trigger Nextion button logic, but we handle it in FSM
     sendCommand("activeProcess.val=0");
     
-    Serial.println("[NextionOutput] Force DRAINING OFF (auto-complete)");
+    LOG_I("NextionOutput", "Force DRAINING OFF (auto-complete)");
 }
 
-// ===== PRIVATE HELPERS =====
+void NextionOutput::restoreSettings(const SystemVariables& settings) {
+    // Global variable HMI, sumber field di halaman setting (nama = prefix pesan RX)
+    NextionCommand cmd;
+    if (settings.setAuto.length() > 0) {
+        sendCommand(cmd.format("setAuto.txt=\"%s\"", settings.setAuto.c_str()).c_str());
+    }
+    sendCommand(cmd.format("days.val=%u", settings.daysValue).c_str());
+    sendCommand(cmd.format("autotemp.val=%u", settings.autoTemp).c_str());
+    sendCommand(cmd.format("count.val=%u", settings.countValue).c_str());
+    sendCommand(cmd.format("cooling.val=%u", settings.coolingValue).c_str());
 
-void NextionOutput::sendCommand(const String& cmd) {
-    Serial2.print(cmd);
-    sendFF();
+    LOG_I("NextionOutput", "Settings restored to panel");
 }
 
-void NextionOutput::sendFF() {
-    // Nextion protocol: setiap command harus diakhiri 3x 0xFF
-    Serial2.write(0xFF);
-    Serial2.write(0xFF);
-    Serial2.write(0xFF);
+// ===== PRIVATE HELPERS =====
+
+void NextionOutput::sendCommand(const char* cmd) {
+    // Antri ke NextionTask; FSM tidak menulis UART (dan tidak menunggu baud rate)
+    if (gateway) {
+        gateway->send(cmd);
+    }
 }
\ No newline at end of file
@@ -3,6 +3,10 @@
 #define NEXTION_OUTPUT_H
 
 #include <Arduino.h>
+#include "FixedString.h"
+
+struct SystemVariables;
+class NextionGateWay;
 
 // ===== NEXTION OUTPUT CLASS =====
 // Handle pengiriman data ke Nextion display
@@ -12,9 +16,15 @@ public:
     ~NextionOutput();
     
     void begin();
+    void setGateway(NextionGateWay* gateway);  // Semua command lewat mailbox TX gateway
     
     // ===== COOLING DISPLAY =====
     void updateCoolingDuration(uint16_t minutes);
+    void updateCoolingEta(bool valid, uint16_t minutes, uint16_t marginMinutes);
+    
+    // ===== SETTINGS =====
+    // Isi ulang variable setting di HMI dari nilai tersimpan (saat boot)
+    void restoreSettings(const SystemVariables& settings);
     
     // ===== ERROR ANIMATION =====
     void setErrorBlink(bool enable);
@@ -27,9 +37,10 @@ public:
     // void setDrainingAnimation(bool enable);
     
 private:
+    NextionGateWay* gateway;
+    
     // Helper untuk kirim command ke Nextion
-    void sendCommand(const String& cmd);
-    void sendFF();  // Nextion protocol terminator
+    void sendCommand(const char* cmd);
 };
 
 #endif
\ No newline at end of file
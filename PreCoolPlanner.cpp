@@ -0,0 +1,153 @@
+// PreCoolPlanner.cpp
+#include "PreCoolPlanner.h"
+#include "Logger.h"
+
+static const char* NVS_NAMESPACE = "precool";
+static const char* NVS_KEY_MODEL = "model";
+
+static const float FALLBACK_WATER_TEMP = 28.0f;    // Tanpa sensor & tanpa riwayat: air tropis
+static const float MIN_COOL_DELTA_C = 1.0f;        // Pull-down lebih kecil tidak representatif
+
+// ===== CONSTRUCTOR =====
+
+PreCoolPlanner::PreCoolPlanner()
+    : fillMinutes(PLAN_DEFAULT_FILL_MIN)
+    , coolRate(PLAN_DEFAULT_COOL_RATE)
+    , inletTemp(0)
+    , inletTempKnown(false)
+    , pendingBlob()
+    , savePending(false)
+{
+    portMUX_INITIALIZE(&pendingMux);
+    TimerService::initFlag(retryTimer);
+}
+
+// ===== PUBLIC API =====
+
+void PreCoolPlanner::begin() {
+    prefs.begin(NVS_NAMESPACE, false);
+
+    PlanModelBlob blob;
+    if (prefs.getBytesLength(NVS_KEY_MODEL) == sizeof(blob) &&
+        prefs.getBytes(NVS_KEY_MODEL, &blob, sizeof(blob)) == sizeof(blob) &&
+        blob.fillMinutes > 0 && blob.coolRate > 0) {
+        fillMinutes = blob.fillMinutes;
+        coolRate = blob.coolRate;
+        inletTemp = blob.inletTemp;
+        inletTempKnown = blob.inletTempKnown != 0;
+    }
+
+    printModel();
+}
+
+// Sekali per step batch: jauh di bawah batas endurance NVS. Jalan di loop
+// task, jadi FSM tidak pernah menunggu flash.
+void PreCoolPlanner::flush() {
+    if (TimerService::isArmed(retryTimer)) return;
+
+    PlanModelBlob blob;
+    portENTER_CRITICAL(&pendingMux);
+    bool pending = savePending;
+    blob = pendingBlob;
+    savePending = false;
+    portEXIT_CRITICAL(&pendingMux);
+    if (!pending) return;
+
+    if (prefs.putBytes(NVS_KEY_MODEL, &blob, sizeof(blob)) != sizeof(blob)) {
+        LOG_W("PLAN", "Model save failed - retry in %lums", (unsigned long)PLAN_NVS_RETRY_MS);
+        portENTER_CRITICAL(&pendingMux);
+        savePending = true;     // pendingBlob mungkin sudah lebih baru, tetap dipakai
+        portEXIT_CRITICAL(&pendingMux);
+        timerService.arm(retryTimer, PLAN_NVS_RETRY_MS);
+    }
+}
+
+// ===== PLANNING =====
+
+uint32_t PreCoolPlanner::leadSeconds(const RecipeProgram& program, uint8_t autoTarget,
+                                     uint16_t countValue, float waterTemp) const {
+    float minutes = PLAN_MARGIN_MIN;
+    RecipeStep step;
+
+    for (uint8_t i = 0; recipeDecode(program, i, step); i++) {
+        uint16_t duration = (step.mode & RECIPE_MODE_SETTING) ? countValue : step.arg;
+
+        switch (step.op) {
+            case RecipeOp::OP_FILL:
+                minutes += fillMinutes;
+                break;
+
+            case RecipeOp::OP_HOLD:
+            case RecipeOp::OP_CIRCULATE:
+                minutes += duration / 60.0f;
+                break;
+
+            case RecipeOp::OP_COOL: {
+                uint8_t target = (step.mode & RECIPE_MODE_SETTING) ? autoTarget : step.arg;
+                if (waterTemp > target) {
+                    minutes += (waterTemp - target) / coolRate;
+                }
+                // Air siap di akhir COOL pertama
+                uint32_t lead = static_cast<uint32_t>(minutes * 60.0f);
+                return lead > PLAN_MAX_LEAD_S ? PLAN_MAX_LEAD_S : lead;
+            }
+
+            default:
+                // DRAIN sebelum COOL (mis. bilas): anggap secepat fill
+                minutes += fillMinutes;
+                break;
+        }
+    }
+
+    // Recipe tanpa COOL: tidak ada pre-cool, mulai tepat waktu
+    return 0;
+}
+
+float PreCoolPlanner::estimateWaterTemp(float sensorTemp, bool sensorValid) const {
+    if (inletTempKnown) return inletTemp;
+    return sensorValid ? sensorTemp : FALLBACK_WATER_TEMP;
+}
+
+// ===== LEARNING =====
+
+void PreCoolPlanner::learnFill(uint32_t durationMs, float waterTemp) {
+    float minutes = durationMs / 60000.0f;
+    fillMinutes += PLAN_LEARN_ALPHA * (minutes - fillMinutes);
+
+    if (inletTempKnown) {
+        inletTemp += PLAN_LEARN_ALPHA * (waterTemp - inletTemp);
+    } else {
+        inletTemp = waterTemp;
+        inletTempKnown = true;
+    }
+    markDirty();
+}
+
+void PreCoolPlanner::learnCool(float startTemp, float endTemp, uint32_t durationMs) {
+    float delta = startTemp - endTemp;
+    float minutes = durationMs / 60000.0f;
+    if (delta < MIN_COOL_DELTA_C || minutes <= 0) return;
+
+    coolRate += PLAN_LEARN_ALPHA * (delta / minutes - coolRate);
+    markDirty();
+}
+
+void PreCoolPlanner::markDirty() {
+    PlanModelBlob blob;
+    blob.fillMinutes = fillMinutes;
+    blob.coolRate = coolRate;
+    blob.inletTemp = inletTemp;
+    blob.inletTempKnown = inletTempKnown ? 1 : 0;
+
+    portENTER_CRITICAL(&pendingMux);
+    pendingBlob = blob;
+    savePending = true;
+    portEXIT_CRITICAL(&pendingMux);
+}
+
+// ===== DEBUG =====
+
+void PreCoolPlanner::printModel() {
+    LOG_I("PLAN", "Fill %.1f min, pull-down %.3f°C/min, inlet %s%.1f°C",
+          fillMinutes, coolRate, inletTempKnown ? "" : "(unknown) ", inletTemp);
+}
@@ -0,0 +1,71 @@
+// PreCoolPlanner.h
+#ifndef PRE_COOL_PLANNER_H
+#define PRE_COOL_PLANNER_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "Recipe.h"
+#include "TimerService.h"
+
+// ===== PLANNER CONFIG =====
+#define PLAN_DEFAULT_FILL_MIN     10.0f    // Sebelum ada fill yang selesai
+#define PLAN_DEFAULT_COOL_RATE    0.10f    // °C/menit rata-rata pull-down
+#define PLAN_LEARN_ALPHA          0.3f     // EWMA per batch
+#define PLAN_MARGIN_MIN           10       // Cadangan: lebih baik siap sedikit lebih awal
+#define PLAN_MAX_LEAD_S           (24UL * 3600)
+#define PLAN_NVS_RETRY_MS         5000     // Jeda sebelum tulis model diulang setelah gagal
+
+// Layout blob NVS; ukuran berbeda = versi lain → pakai default
+struct PlanModelBlob {
+    float fillMinutes;
+    float coolRate;
+    float inletTemp;
+    uint8_t inletTempKnown;
+};
+
+// ===== PRE-COOL PLANNER =====
+// Menghitung lead time recipe sampai step COOL pertama selesai, supaya air
+// sudah di target tepat pada jam setAuto. Parameter dipelajari dari batch
+// sebelumnya: durasi fill, laju pull-down rata-rata, dan suhu air masuk.
+// Model disimpan di NVS (namespace "precool") setiap kali belajar, supaya
+// reboot tidak kembali ke default. learn*() jalan di FSM task dan hanya
+// menyalin model ke slot pending; flush() dari loop() yang menulis flash.
+class PreCoolPlanner {
+public:
+    PreCoolPlanner();
+
+    void begin();
+    void flush();                           // Dipanggil dari loop()
+
+    // Detik dari start batch sampai air siap (step COOL pertama selesai)
+    uint32_t leadSeconds(const RecipeProgram& program, uint8_t autoTarget,
+                         uint16_t countValue, float waterTemp) const;
+
+    // Suhu air setelah fill: hasil belajar, atau sensor jika belum ada data
+    float estimateWaterTemp(float sensorTemp, bool sensorValid) const;
+
+    // ===== LEARNING (dipanggil AutoCycle setelah step selesai tanpa fault) =====
+    void learnFill(uint32_t durationMs, float waterTemp);
+    void learnCool(float startTemp, float endTemp, uint32_t durationMs);
+
+    // ===== DEBUG =====
+    void printModel();
+
+private:
+    Preferences prefs;
+
+    float fillMinutes;
+    float coolRate;             // °C/menit
+    float inletTemp;            // °C air setelah fill
+    bool inletTempKnown;
+
+    // Salinan model untuk loop(); mux karena ditulis FSM task, dibaca loop task
+    portMUX_TYPE pendingMux;
+    PlanModelBlob pendingBlob;
+    bool savePending;
+    Timer retryTimer;           // Armed = tulis terakhir gagal, tunggu sebelum coba lagi
+
+    void markDirty();
+};
+
+#endif
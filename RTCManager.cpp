@@ -1,8 +1,37 @@
   #include "RTCManager.h"
   #include "NextionGateWay.h"
+  #include "Logger.h"
   // Extern untuk akses ke NextionGateWay
 
 
+  // Static instance untuk ISR
+  RTCManager* RTCManager::instance = nullptr;
+
+  // ===== ISR =====
+
+  // Falling edge SQW = register detik DS3231 baru saja naik
+  void IRAM_ATTR RTCManager::sqwISR() {
+      if (!instance) return;
+      portENTER_CRITICAL_ISR(&instance->clockMux);
+      uint32_t now = instance->clockUnix + 1;
+      instance->clockUnix = now;
+      instance->sqwTicks = instance->sqwTicks + 1;
+      portEXIT_CRITICAL_ISR(&instance->clockMux);
+      
+      // Jam di display hanya berubah per menit: bangunkan task jam sekali per menit.
+      // Alarm jatuh tempo: task yang menandai slot & post event (bukan dari ISR).
+      TaskHandle_t task = instance->notifyTask;
+      uint32_t alarm = instance->nextAlarmUnix;
+      uint32_t bits = 0;
+      if (now % 60 == 0) bits |= RTC_NOTIFY_MINUTE;
+      if (alarm != 0 && now >= alarm) bits |= RTC_NOTIFY_ALARM;
+      if (task && bits) {
+          BaseType_t woken = pdFALSE;
+          xTaskNotifyFromISR(task, bits, eSetBits, &woken);
+          if (woken) portYIELD_FROM_ISR();
+      }
+  }
+
   // ===== CONSTRUCTOR / DESTRUCTOR =====
 
   RTCManager::RTCManager()
@@ -10,8 +39,21 @@
       , timeWasSet(false)
       , lastDateTime(DateTime(2025, 1, 1, 0, 0, 0))
       , nextionPtr(nullptr)
+      , clockUnix(0)
+      , sqwTicks(0)
+      , sqwAlive(false)
+      , lastSyncUnix(0)
+      , lastSeenTicks(0)
+      , lastTickSeenMs(0)
+      , notifyTask(nullptr)
+      , alarms()
+      , firedMask(0)
+      , nextAlarmUnix(0)
+      , eventQueue(nullptr)
   {
-      mutex = xSemaphoreCreateMutex();
+      mutex = xSemaphoreCreateMutexStatic(&mutexBuffer);
+      portMUX_INITIALIZE(&clockMux);
+      instance = this;
   }
 
   RTCManager::~RTCManager() {
@@ -22,6 +64,14 @@
     nextionPtr = nxt;
   }
 
+  void RTCManager::setNotifyTask(TaskHandle_t task) {
+      notifyTask = task;
+  }
+
+  void RTCManager::setEventQueue(QueueHandle_t queue) {
+      eventQueue = queue;
+  }
+
 
   // ===== PUBLIC API =====
 
@@ -29,7 +79,7 @@
       lock();
       
       if (!rtc.begin()) {
-          Serial.println("[RTC] ERROR: RTC not found!");
+          LOG_E("RTC", "ERROR: RTC not found!");
           rtcInitialized = false;
           unlock();
           return;
@@ -39,28 +89,63 @@
       
       // Cek apakah RTC kehilangan power
       if (rtc.lostPower()) {
-          Serial.println("[RTC] WARNING: RTC lost power, setting default time");
+          LOG_W("RTC", "WARNING: RTC lost power, setting default time");
           rtc.adjust(DateTime(2025, 1, 1, 0, 0, 0));
           timeWasSet = false;
       } else {
-          Serial.println("[RTC] RTC initialized successfully");
+          LOG_I("RTC", "RTC initialized successfully");
           timeWasSet = true;
           lastDateTime = rtc.now();
       }
       
+      // SQW 1 Hz → jam software
+      rtc.writeSqwPinMode(DS3231_SquareWave1Hz);
+      
       unlock();
       
+      syncFromChip();
+      pinMode(PIN_RTC_SQW, INPUT_PULLUP);
+      attachInterrupt(digitalPinToInterrupt(PIN_RTC_SQW), sqwISR, FALLING);
+      sqwAlive = true;                  // Dikoreksi update() jika tick tidak pernah datang
+      lastTickSeenMs = millis();
+      
       printTime();
   }
 
+  void RTCManager::update() {
+      if (!rtcInitialized) return;
+      
+      // ===== SQW WATCHDOG =====
+      uint32_t ticks = sqwTicks;
+      if (ticks != lastSeenTicks) {
+          lastSeenTicks = ticks;
+          lastTickSeenMs = millis();
+          if (!sqwAlive) {
+              LOG_I("RTC", "SQW ticks back - software clock resumed");
+              syncFromChip();
+              sqwAlive = true;
+          }
+      } else if (sqwAlive && millis() - lastTickSeenMs > RTC_SQW_TIMEOUT_MS) {
+          LOG_W("RTC", "No SQW ticks - falling back to I2C reads");
+          sqwAlive = false;
+      }
+      
+      // ===== PERIODIC RESYNC =====
+      if (sqwAlive && clockUnix - lastSyncUnix >= RTC_RESYNC_INTERVAL_S) {
+          syncFromChip();
+      }
+      
+      // Alarm dari ISR, atau polling jika SQW mati / jam baru di-resync
+      serviceAlarms();
+  }
+
   // ===== SET TIME =====
 
-  bool RTCManager::setTime(const String &timeStr) {
+  bool RTCManager::setTime(const char* timeStr) {
       uint8_t hour, minute;
       
       if (!parseTimeString(timeStr, hour, minute)) {
-          Serial.print("[RTC] ERROR: Invalid time format: ");
-          Serial.println(timeStr);
+          LOG_E("RTC", "ERROR: Invalid time format: %s", timeStr);
           return false;
       }
       
@@ -69,12 +154,12 @@
 
   bool RTCManager::setTime(uint8_t hour, uint8_t minute) {
       if (!rtcInitialized) {
-          Serial.println("[RTC] ERROR: RTC not initialized");
+          LOG_E("RTC", "ERROR: RTC not initialized");
           return false;
       }
       
       if (hour > 23 || minute > 59) {
-          Serial.println("[RTC] ERROR: Invalid time values");
+          LOG_E("RTC", "ERROR: Invalid time values");
           return false;
       }
       
@@ -90,79 +175,81 @@
       
       unlock();
       
-      Serial.print("[RTC] Time set to: ");
-      Serial.print(hour);
-      Serial.print(":");
-      if (minute < 10) Serial.print("0");
-      Serial.println(minute);
+      // Tulis detik me-reset divider chip: jam software mulai dari nilai yang sama
+      portENTER_CRITICAL(&clockMux);
+      clockUnix = newTime.unixtime();
+      portEXIT_CRITICAL(&clockMux);
+      lastSyncUnix = newTime.unixtime();
+      
+      LOG_I("RTC", "Time set to: %u:%02u", hour, minute);
+      
+      // Alarm absolut: yang terlewati oleh lompatan jam langsung fire, dan
+      // pemilik slot dibangunkan untuk merencanakan ulang terhadap jam baru
+      serviceAlarms();
+      fsmPostEvent(eventQueue, FsmEvent::EV_RTC_ALARM);
       
       return true;
   }
 
   // ===== GET TIME =====
 
-  String RTCManager::getTimeString() {
+  TimeText RTCManager::getTimeString() {
       if (!rtcInitialized) {
-          return "--:--";
+          return TimeText("--:--");
       }
       
-      lock();
-      DateTime now = rtc.now();
-      lastDateTime = now;
-      unlock();
+      uint8_t hour, minute, second;
+      getTime(hour, minute, second);
       
-      char buffer[6];
-      snprintf(buffer, sizeof(buffer), "%02d:%02d", now.hour(), now.minute());
-      return String(buffer);
+      TimeText text;
+      text.format("%02d:%02d", hour, minute);
+      return text;
   }
 
-  String RTCManager::getTimeStringFull() {
+  TimeText RTCManager::getTimeStringFull() {
       if (!rtcInitialized) {
-          return "--:--:--";
+          return TimeText("--:--:--");
       }
       
-      lock();
-      DateTime now = rtc.now();
-      lastDateTime = now;
-      unlock();
+      uint8_t hour, minute, second;
+      getTime(hour, minute, second);
       
-      char buffer[9];
-      snprintf(buffer, sizeof(buffer), "%02d:%02d:%02d", 
-              now.hour(), now.minute(), now.second());
-      return String(buffer);
+      TimeText text;
+      text.format("%02d:%02d:%02d", hour, minute, second);
+      return text;
   }
 
   uint8_t RTCManager::getHour() {
       if (!rtcInitialized) return 0;
-      
-      lock();
-      DateTime now = rtc.now();
-      uint8_t hour = now.hour();
-      unlock();
-      
-      return hour;
+      return (snapshot() / 3600) % 24;
   }
 
   uint8_t RTCManager::getMinute() {
       if (!rtcInitialized) return 0;
-      
-      lock();
-      DateTime now = rtc.now();
-      uint8_t minute = now.minute();
-      unlock();
-      
-      return minute;
+      return (snapshot() / 60) % 60;
   }
 
   uint8_t RTCManager::getSecond() {
       if (!rtcInitialized) return 0;
+      return snapshot() % 60;
+  }
+
+  uint32_t RTCManager::getUnixTime() {
+      if (!rtcInitialized) return 0;
+      return snapshot();
+  }
+
+  void RTCManager::getTime(uint8_t &hour, uint8_t &minute, uint8_t &second) {
+      if (!rtcInitialized) {
+          hour = minute = second = 0;
+          return;
+      }
       
-      lock();
-      DateTime now = rtc.now();
-      uint8_t second = now.second();
-      unlock();
-      
-      return second;
+      // Semua field dari satu nilai: tidak pernah robek di batas menit/jam
+      uint32_t now = snapshot();
+      hour = (now / 3600) % 24;
+      minute = (now / 60) % 60;
+      second = now % 60;
   }
 
   // ===== STATUS =====
@@ -175,23 +262,70 @@
       return timeWasSet;
   }
 
+  // ===== SCHEDULED ALARMS =====
+
+  void RTCManager::setAlarm(RtcAlarm id, uint32_t unixTime) {
+      uint8_t slot = static_cast<uint8_t>(id);
+      if (slot >= static_cast<uint8_t>(RtcAlarm::ALARM_COUNT)) return;
+      
+      lock();
+      bool changed = (alarms[slot] != unixTime);
+      alarms[slot] = unixTime;
+      if (changed) firedMask &= ~(1U << slot);
+      unlock();
+      
+      if (changed) {
+          LOG_D("RTC", "Alarm %u at %lu", slot, (unsigned long)unixTime);
+          serviceAlarms();
+      }
+  }
+
+  void RTCManager::cancelAlarm(RtcAlarm id) {
+      setAlarm(id, 0);
+  }
+
+  bool RTCManager::consumeAlarm(RtcAlarm id) {
+      uint8_t slot = static_cast<uint8_t>(id);
+      if (slot >= static_cast<uint8_t>(RtcAlarm::ALARM_COUNT)) return false;
+      
+      lock();
+      bool fired = firedMask & (1U << slot);
+      firedMask &= ~(1U << slot);
+      unlock();
+      return fired;
+  }
+
+  uint32_t RTCManager::getAlarm(RtcAlarm id) {
+      uint8_t slot = static_cast<uint8_t>(id);
+      if (slot >= static_cast<uint8_t>(RtcAlarm::ALARM_COUNT)) return 0;
+      
+      lock();
+      uint32_t unixTime = alarms[slot];
+      unlock();
+      return unixTime;
+  }
+
+  uint32_t RTCManager::getNextAlarm() {
+      return nextAlarmUnix;
+  }
+
   // ===== NEXTION SYNC =====
 
-void RTCManager::sendToNextion(const String &componentName) {
+void RTCManager::sendToNextion(const char* componentName) {
     if (!rtcInitialized) {
-        Serial.println("[RTC] ERROR: Cannot send to Nextion, RTC not initialized");
+        LOG_E("RTC", "ERROR: Cannot send to Nextion, RTC not initialized");
         return;
     }
     
     if (!nextionPtr) {  // ← TAMBAHKAN pengecekan
-        Serial.println("[RTC] ERROR: Nextion not set");
+        LOG_E("RTC", "ERROR: Nextion not set");
         return;
     }
     
-    String timeStr = getTimeString();
-    String cmd = componentName + ".txt=\"" + timeStr + "\"";
+    NextionCommand cmd;
+    cmd.format("%s.txt=\"%s\"", componentName, getTimeString().c_str());
     
-    nextionPtr->send(cmd);  // ← UBAH dari nextion.send() ke nextionPtr->send()
+    nextionPtr->send(cmd.c_str());  // ← UBAH dari nextion.send() ke nextionPtr->send()
     
 
 }
@@ -221,34 +355,109 @@ void RTCManager::sendToNextion(const String &componentName) {
       Serial.print("║ Status: ");
       Serial.println(timeWasSet ? "SET            ║" : "NOT SET        ║");
       
+      uint32_t next = nextAlarmUnix;
+      if (next) {
+          DateTime alarm(next);
+          char line[48];
+          snprintf(line, sizeof(line), "║ Next alarm: %02d-%02d %02d:%02d:%02d         ║",
+                  alarm.month(), alarm.day(), alarm.hour(), alarm.minute(), alarm.second());
+          Serial.println(line);
+      }
+      
       Serial.println("╚════════════════════════════════════╝");
   }
 
   // ===== PRIVATE METHODS =====
 
-  bool RTCManager::parseTimeString(const String &timeStr, uint8_t &hour, uint8_t &minute) {
+  // Satu load 32-bit aligned = atomik; I2C hanya jika SQW tidak jalan
+  uint32_t RTCManager::snapshot() {
+      if (sqwAlive) {
+          return clockUnix;
+      }
+      
+      lock();
+      uint32_t now = rtc.now().unixtime();
+      unlock();
+      return now;
+  }
+
+  bool RTCManager::syncFromChip() {
+      // Edge SQW di antara baca I2C dan tulis → nilai chip sudah basi, ulangi
+      for (uint8_t attempt = 0; attempt < 3; attempt++) {
+          uint32_t ticks = sqwTicks;
+          
+          lock();
+          uint32_t chip = rtc.now().unixtime();
+          unlock();
+          
+          portENTER_CRITICAL(&clockMux);
+          bool raced = (sqwTicks != ticks);
+          int32_t correction = static_cast<int32_t>(chip - clockUnix);
+          if (!raced) clockUnix = chip;
+          portEXIT_CRITICAL(&clockMux);
+          
+          if (!raced) {
+              if (lastSyncUnix != 0 && correction != 0) {
+                  LOG_W("RTC", "Software clock corrected by %lds", (long)correction);
+              }
+              lastSyncUnix = chip;
+              return true;
+          }
+      }
+      
+      LOG_W("RTC", "Resync raced SQW edge 3 times - skipped");
+      return false;
+  }
+
+  // Tandai slot jatuh tempo, hitung ulang alarm terdekat untuk ISR
+  void RTCManager::serviceAlarms() {
+      if (!rtcInitialized) return;
+      
+      uint32_t now = snapshot();
+      uint32_t next = 0;
+      uint8_t fired = 0;
+      
+      lock();
+      for (uint8_t slot = 0; slot < static_cast<uint8_t>(RtcAlarm::ALARM_COUNT); slot++) {
+          if (alarms[slot] == 0) continue;
+          if (now >= alarms[slot]) {
+              alarms[slot] = 0;
+              fired |= (1U << slot);
+          } else if (next == 0 || alarms[slot] < next) {
+              next = alarms[slot];
+          }
+      }
+      firedMask |= fired;
+      nextAlarmUnix = next;
+      unlock();
+      
+      if (fired) {
+          LOG_I("RTC", "Alarm fired (slots 0x%02x)", fired);
+          fsmPostEvent(eventQueue, FsmEvent::EV_RTC_ALARM);
+      }
+  }
+
+  bool RTCManager::parseTimeString(const char* timeStr, uint8_t &hour, uint8_t &minute) {
       // Format expected: "HH:MM"
-      if (timeStr.length() != 5) {
+      if (!timeStr || strlen(timeStr) != 5) {
           return false;
       }
       
-      if (timeStr.charAt(2) != ':') {
+      if (timeStr[2] != ':') {
           return false;
       }
       
-      // Parse hour
-      String hourStr = timeStr.substring(0, 2);
-      String minStr = timeStr.substring(3, 5);
-      
       // Validate digits
+      const char* hourStr = timeStr;
+      const char* minStr = timeStr + 3;
       for (int i = 0; i < 2; i++) {
           if (!isDigit(hourStr[i]) || !isDigit(minStr[i])) {
               return false;
           }
       }
       
-      hour = hourStr.toInt();
-      minute = minStr.toInt();
+      hour = (hourStr[0] - '0') * 10 + (hourStr[1] - '0');
+      minute = (minStr[0] - '0') * 10 + (minStr[1] - '0');
       
       // Validate range
       if (hour > 23 || minute > 59) {
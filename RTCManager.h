@@ -3,35 +3,76 @@
 
 #include <Arduino.h>
 #include <RTClib.h>  // Library Adafruit RTClib untuk DS3231/DS1307
+#include "FsmEvent.h"
+#include "FixedString.h"
 
 class NextionGateWay;
 
+// ===== SOFTWARE CLOCK CONFIG =====
+#define PIN_RTC_SQW               19       // DS3231 SQW/INT (open drain, pull-up internal)
+#define RTC_RESYNC_INTERVAL_S     3600     // Baca ulang chip tiap jam (edge hilang/noise)
+#define RTC_SQW_TIMEOUT_MS        3000     // Tanpa tick selama ini → SQW dianggap mati
+
+// Bit notifikasi ke task jam (xTaskNotify eSetBits)
+#define RTC_NOTIFY_MINUTE         (1UL << 0)   // ISR: detik :00, menit berganti
+#define RTC_NOTIFY_ALARM          (1UL << 2)   // ISR: alarm jadwal jatuh tempo (bit 1 = STORAGE_NOTIFY_SETTIME)
+#define RTC_TASK_CHECK_MS         10000    // Bangun minimal sekali per ini (watchdog SQW, resync)
+#define RTC_TASK_WAKE_MARGIN_MS   50       // Tanpa SQW: bangun sedikit setelah batas menit/alarm
+
+// ===== SCHEDULED ALARMS =====
+// Slot alarm jadwal, waktu unix absolut (bukan millis: ikut setTime & resync)
+enum class RtcAlarm : uint8_t {
+    ALARM_AUTO_START = 0,       // Start batch auto = jam siap - lead pre-cool
+    ALARM_COUNT
+};
+
 // ===== RTC MANAGER CLASS =====
+// Jam software: SQW 1 Hz DS3231 → ISR menaikkan detik unix (satu word 32-bit).
+// Getter membaca satu snapshot word itu: koheren, tanpa I2C, tanpa mutex.
+// Chip hanya dibaca saat begin, setTime, resync berkala, dan fallback jika
+// SQW tidak ada.
+//
+// Alarm jadwal dibandingkan ISR yang sama dengan detik unix (pin SQW/INT DS3231
+// dipakai 1 Hz, jadi alarm hardware chip tidak bisa men-trigger INT). Alarm
+// jatuh tempo → EV_RTC_ALARM ke FSM; pemilik slot memanggil consumeAlarm().
 class RTCManager {
 public:
     RTCManager();
     ~RTCManager();
     
     void begin();
+    void update();  // Resync berkala + deteksi SQW mati (dari rtcTask)
     void setNextionGateway(NextionGateWay* nxt);
+    void setNotifyTask(TaskHandle_t task);  // Dapat RTC_NOTIFY_MINUTE / RTC_NOTIFY_ALARM
+    void setEventQueue(QueueHandle_t queue);  // Alarm jatuh tempo → EV_RTC_ALARM
 
     // ===== SET TIME =====
-    bool setTime(const String &timeStr);  // Format "HH:MM"
+    bool setTime(const char* timeStr);    // Format "HH:MM"
     bool setTime(uint8_t hour, uint8_t minute);
     
     // ===== GET TIME =====
-    String getTimeString();     // Return "HH:MM"
-    String getTimeStringFull(); // Return "HH:MM:SS"
+    TimeText getTimeString();     // Return "HH:MM"
+    TimeText getTimeStringFull(); // Return "HH:MM:SS"
     uint8_t getHour();
     uint8_t getMinute();
     uint8_t getSecond();
+    uint32_t getUnixTime();     // Detik sejak 1970 (0 jika RTC tidak ada)
+    void getTime(uint8_t &hour, uint8_t &minute, uint8_t &second);  // Satu snapshot
     
     // ===== STATUS =====
     bool isRTCValid();
     bool isTimeSet();
+    bool isSqwAlive() const { return sqwAlive; }  // false → tidak ada notifikasi menit
+    
+    // ===== SCHEDULED ALARMS =====
+    void setAlarm(RtcAlarm id, uint32_t unixTime);  // Ganti waktu slot (sudah lewat → langsung fire)
+    void cancelAlarm(RtcAlarm id);
+    bool consumeAlarm(RtcAlarm id);                  // true sekali setelah slot fire
+    uint32_t getAlarm(RtcAlarm id);                  // 0 = tidak aktif
+    uint32_t getNextAlarm();                         // Alarm terdekat semua slot, 0 = tidak ada
     
     // ===== NEXTION SYNC =====
-    void sendToNextion(const String &componentName = "tClock");
+    void sendToNextion(const char* componentName = "tClock");
     
     // ===== DEBUG =====
     void printTime();
@@ -39,6 +80,7 @@ public:
 private:
     RTC_DS3231 rtc;  // Ganti dengan RTC_DS1307 jika pakai DS1307
     SemaphoreHandle_t mutex;
+    StaticSemaphore_t mutexBuffer;
     
     bool rtcInitialized;
     bool timeWasSet;
@@ -47,7 +89,28 @@ private:
 
     NextionGateWay* nextionPtr; 
     
-    bool parseTimeString(const String &timeStr, uint8_t &hour, uint8_t &minute);
+    // ===== SOFTWARE CLOCK =====
+    volatile uint32_t clockUnix;        // Ditulis ISR/sync (di dalam clockMux), dibaca tanpa lock
+    volatile uint32_t sqwTicks;         // Jumlah edge SQW sejak boot
+    volatile bool sqwAlive;
+    portMUX_TYPE clockMux;
+    uint32_t lastSyncUnix;
+    uint32_t lastSeenTicks;
+    unsigned long lastTickSeenMs;
+    TaskHandle_t volatile notifyTask;
+    
+    // ===== ALARMS =====
+    uint32_t alarms[static_cast<uint8_t>(RtcAlarm::ALARM_COUNT)];  // Unix, 0 = tidak aktif (di mutex)
+    uint8_t firedMask;                  // Slot yang fire dan belum di-consume
+    volatile uint32_t nextAlarmUnix;    // Alarm terdekat, dibandingkan ISR tiap detik
+    QueueHandle_t eventQueue;
+    static RTCManager* instance;        // For ISR
+    static void IRAM_ATTR sqwISR();
+    
+    bool syncFromChip();
+    void serviceAlarms();
+    uint32_t snapshot();
+    bool parseTimeString(const char* timeStr, uint8_t &hour, uint8_t &minute);
     
     void lock();
     void unlock();
@@ -0,0 +1,400 @@
+// Recipe.cpp
+#include "Recipe.h"
+#include "Logger.h"
+
+static const char* OP_NAMES[static_cast<uint8_t>(RecipeOp::OP_COUNT)] = {
+    "END",
+    "FILL",
+    "COOL",
+    "HOLD",
+    "CIRC",
+    "DRAIN",
+    "TDS"
+};
+
+static const char* NVS_NAMESPACE = "recipe";
+static const char* NVS_KEY_SOURCE = "src";
+
+// ===== PARSE HELPERS =====
+
+// Bilangan bulat desimal murni, tanpa tanda
+static bool parseUInt(const char* token, uint32_t maxValue, uint32_t& value) {
+    if (*token == '\0') return false;
+
+    value = 0;
+    for (const char* p = token; *p; p++) {
+        if (!isdigit(static_cast<unsigned char>(*p))) return false;
+        value = value * 10 + (*p - '0');
+        if (value > maxValue) return false;
+    }
+    return true;
+}
+
+// "25L" / "25.5L" → desiliter
+static bool parseVolume(const char* token, uint16_t& deciliters) {
+    uint32_t value = 0;
+    bool decimal = false;
+    uint8_t fraction = 0;
+    const char* p = token;
+
+    if (!isdigit(static_cast<unsigned char>(*p))) return false;
+
+    for (; *p && *p != 'L'; p++) {
+        if (*p == '.' && !decimal) {
+            decimal = true;
+        } else if (isdigit(static_cast<unsigned char>(*p)) && (!decimal || fraction == 0)) {
+            if (decimal) fraction = 1;
+            value = value * 10 + (*p - '0');
+            if (value > RECIPE_MAX_VOLUME_DL) return false;
+        } else {
+            return false;
+        }
+    }
+
+    if (*p != 'L' || *(p + 1) != '\0') return false;
+    if (!fraction) value *= 10;
+    if (value == 0 || value > RECIPE_MAX_VOLUME_DL) return false;
+
+    deciliters = static_cast<uint16_t>(value);
+    return true;
+}
+
+static void emitStep(RecipeProgram& program, const RecipeStep& step) {
+    uint8_t* code = &program.code[program.length];
+    code[0] = (static_cast<uint8_t>(step.op) << 4) | (step.mode & 0x0F);
+    code[1] = step.arg & 0xFF;
+    code[2] = step.arg >> 8;
+    code[3] = step.timeoutS & 0xFF;
+    code[4] = step.timeoutS >> 8;
+    program.length += RECIPE_STEP_BYTES;
+    program.stepCount++;
+}
+
+// Satu statement yang sudah di-uppercase → RecipeStep
+static bool parseStatement(char* statement, RecipeStep& step, const char*& message) {
+    char* save = nullptr;
+    char* opToken = strtok_r(statement, " \t\r", &save);
+    char* args[3] = { nullptr, nullptr, nullptr };
+    uint8_t argCount = 0;
+    bool hasTimeout = false;
+    uint32_t timeout = 0;
+
+    for (char* token = strtok_r(nullptr, " \t\r", &save); token; token = strtok_r(nullptr, " \t\r", &save)) {
+        if (strncmp(token, "T=", 2) == 0) {
+            if (hasTimeout || !parseUInt(token + 2, 0xFFFF, timeout) || timeout == 0) {
+                message = "invalid timeout";
+                return false;
+            }
+            hasTimeout = true;
+        } else if (argCount < 3) {
+            args[argCount++] = token;
+        } else {
+            message = "too many arguments";
+            return false;
+        }
+    }
+
+    step.mode = 0;
+    step.arg = 0;
+    step.timeoutS = 0;
+
+    uint32_t value = 0;
+
+    if (strcmp(opToken, "FILL") == 0 || strcmp(opToken, "DRAIN") == 0) {
+        bool isFill = (opToken[0] == 'F');
+        step.op = isFill ? RecipeOp::OP_FILL : RecipeOp::OP_DRAIN;
+        step.timeoutS = hasTimeout ? timeout : (isFill ? RECIPE_FILL_TIMEOUT_S : RECIPE_DRAIN_TIMEOUT_S);
+
+        if (argCount != 1) {
+            message = isFill ? "FILL needs FLOAT or <liter>L" : "DRAIN needs FLOW or <liter>L";
+            return false;
+        }
+        if (strcmp(args[0], isFill ? "FLOAT" : "FLOW") == 0) {
+            step.mode = isFill ? RECIPE_MODE_FLOAT : RECIPE_MODE_NO_FLOW;
+        } else if (parseVolume(args[0], step.arg)) {
+            step.mode = RECIPE_MODE_VOLUME;
+        } else {
+            message = "invalid volume";
+            return false;
+        }
+        return true;
+    }
+
+    if (strcmp(opToken, "COOL") == 0) {
+        step.op = RecipeOp::OP_COOL;
+        step.timeoutS = hasTimeout ? timeout : RECIPE_COOL_TIMEOUT_S;
+
+        if (argCount != 1) {
+            message = "COOL needs <°C> or AUTO";
+            return false;
+        }
+        if (strcmp(args[0], "AUTO") == 0) {
+            step.mode = RECIPE_MODE_SETTING;
+        } else if (parseUInt(args[0], RECIPE_MAX_TEMP_C, value)) {
+            step.arg = value;
+        } else {
+            message = "invalid temperature";
+            return false;
+        }
+        return true;
+    }
+
+    if (strcmp(opToken, "TDS") == 0) {
+        step.op = RecipeOp::OP_REFRESH;
+        step.timeoutS = hasTimeout ? timeout : RECIPE_REFRESH_TIMEOUT_S;
+
+        if (argCount != 1 || !parseUInt(args[0], RECIPE_MAX_TDS_PPM, value) || value == 0) {
+            message = "TDS needs <ppm> limit";
+            return false;
+        }
+        step.arg = value;
+        return true;
+    }
+
+    // HOLD / CIRC: durasi sudah membatasi step, T= tidak berlaku
+    if (hasTimeout) {
+        message = "T= not allowed on HOLD/CIRC";
+        return false;
+    }
+
+    const char* duration = nullptr;
+
+    if (strcmp(opToken, "HOLD") == 0) {
+        step.op = RecipeOp::OP_HOLD;
+        if (argCount != 1) {
+            message = "HOLD needs <seconds> or COUNT";
+            return false;
+        }
+        duration = args[0];
+    }
+    else if (strcmp(opToken, "CIRC") == 0) {
+        step.op = RecipeOp::OP_CIRCULATE;
+        if (argCount != 2) {
+            message = "CIRC needs UV|OZONE|UV+OZONE and <seconds> or COUNT";
+            return false;
+        }
+        if (strcmp(args[0], "UV") == 0) {
+            step.mode = RECIPE_CIRC_UV;
+        } else if (strcmp(args[0], "OZONE") == 0) {
+            step.mode = RECIPE_CIRC_OZONE;
+        } else if (strcmp(args[0], "UV+OZONE") == 0 || strcmp(args[0], "OZONE+UV") == 0) {
+            step.mode = RECIPE_CIRC_UV | RECIPE_CIRC_OZONE;
+        } else {
+            message = "invalid CIRC treatment";
+            return false;
+        }
+        duration = args[1];
+    }
+    else {
+        message = "unknown step";
+        return false;
+    }
+
+    if (strcmp(duration, "COUNT") == 0) {
+        step.mode |= RECIPE_MODE_SETTING;
+    } else if (parseUInt(duration, 0xFFFF, value) && value > 0) {
+        step.arg = value;
+    } else {
+        message = "invalid duration";
+        return false;
+    }
+    return true;
+}
+
+// ===== COMPILER / DECODER =====
+
+bool recipeCompile(const char* source, RecipeProgram& program, RecipeError& error) {
+    char buffer[RECIPE_MAX_SOURCE];
+    memset(&program, 0, sizeof(program));
+    error.step = 0;
+    error.message = nullptr;
+
+    if (!source || strlen(source) >= sizeof(buffer)) {
+        error.message = "recipe too long";
+        return false;
+    }
+
+    strcpy(buffer, source);
+    for (char* p = buffer; *p; p++) {
+        *p = toupper(static_cast<unsigned char>(*p));
+    }
+
+    bool hasWater = false;      // Validasi: COOL/HOLD/CIRC butuh tangki berisi
+    char* save = nullptr;
+
+    for (char* statement = strtok_r(buffer, ";\n", &save); statement; statement = strtok_r(nullptr, ";\n", &save)) {
+        // Statement kosong (mis. ";;" atau baris kosong) dilewati
+        if (strspn(statement, " \t\r") == strlen(statement)) continue;
+
+        error.step = program.stepCount + 1;
+        if (program.stepCount >= RECIPE_MAX_STEPS) {
+            error.message = "too many steps";
+            return false;
+        }
+
+        RecipeStep step;
+        if (!parseStatement(statement, step, error.message)) {
+            return false;
+        }
+
+        switch (step.op) {
+            case RecipeOp::OP_FILL:
+                hasWater = true;
+                break;
+
+            case RecipeOp::OP_DRAIN:
+                // Drain volume = parsial, tangki masih berisi
+                if (!hasWater) {
+                    error.message = "DRAIN on empty tank";
+                    return false;
+                }
+                if (step.mode == RECIPE_MODE_NO_FLOW) hasWater = false;
+                break;
+
+            default:
+                if (!hasWater) {
+                    error.message = "step needs a filled tank";
+                    return false;
+                }
+                break;
+        }
+
+        emitStep(program, step);
+    }
+
+    error.step = 0;
+    if (program.stepCount == 0) {
+        error.message = "empty recipe";
+        return false;
+    }
+    if (hasWater) {
+        // Batch tanpa operator tidak boleh meninggalkan tangki penuh
+        error.message = "recipe must end with DRAIN FLOW";
+        return false;
+    }
+
+    program.code[program.length++] = static_cast<uint8_t>(RecipeOp::OP_END);
+    return true;
+}
+
+bool recipeDecode(const RecipeProgram& program, uint8_t index, RecipeStep& step) {
+    uint16_t pc = static_cast<uint16_t>(index) * RECIPE_STEP_BYTES;
+    if (index >= program.stepCount || pc + RECIPE_STEP_BYTES > program.length) {
+        step.op = RecipeOp::OP_END;
+        return false;
+    }
+
+    const uint8_t* code = &program.code[pc];
+    step.op = static_cast<RecipeOp>(code[0] >> 4);
+    step.mode = code[0] & 0x0F;
+    step.arg = code[1] | (code[2] << 8);
+    step.timeoutS = code[3] | (code[4] << 8);
+
+    return step.op > RecipeOp::OP_END && step.op < RecipeOp::OP_COUNT;
+}
+
+const char* recipeOpName(RecipeOp op) {
+    uint8_t index = static_cast<uint8_t>(op);
+    return index < static_cast<uint8_t>(RecipeOp::OP_COUNT) ? OP_NAMES[index] : "UNKNOWN";
+}
+
+// ===== CONSTRUCTOR / DESTRUCTOR =====
+
+RecipeStore::RecipeStore() {
+    mutex = xSemaphoreCreateMutexStatic(&mutexBuffer);
+    memset(&program, 0, sizeof(program));
+    source[0] = '\0';
+}
+
+RecipeStore::~RecipeStore() {
+    if (mutex) vSemaphoreDelete(mutex);
+}
+
+// ===== PUBLIC API =====
+
+void RecipeStore::begin() {
+    char stored[RECIPE_MAX_SOURCE];
+    RecipeError error;
+    bool valid = false;
+
+    prefs.begin(NVS_NAMESPACE, false);
+    if (prefs.isKey(NVS_KEY_SOURCE) && prefs.getString(NVS_KEY_SOURCE, stored, sizeof(stored)) > 0) {
+        lock();
+        valid = recipeCompile(stored, program, error);
+        if (valid) strcpy(source, stored);
+        unlock();
+
+        if (!valid) {
+            LOG_E("RECIPE", "Stored recipe invalid (step %u: %s) - using default", error.step, error.message);
+        }
+    }
+
+    if (!valid) {
+        lock();
+        recipeCompile(RECIPE_DEFAULT_SOURCE, program, error);
+        strcpy(source, RECIPE_DEFAULT_SOURCE);
+        unlock();
+    }
+
+    LOG_I("RECIPE", "Recipe loaded (%u steps, %u bytes)", program.stepCount, program.length);
+}
+
+bool RecipeStore::load(const char* newSource, RecipeError& error) {
+    RecipeProgram compiled;
+    if (!recipeCompile(newSource, compiled, error)) {
+        LOG_W("RECIPE", "Recipe rejected (step %u: %s)", error.step, error.message);
+        return false;
+    }
+
+    lock();
+    program = compiled;
+    strcpy(source, newSource);
+    prefs.putString(NVS_KEY_SOURCE, source);
+    unlock();
+
+    LOG_I("RECIPE", "Recipe stored (%u steps, %u bytes)", compiled.stepCount, compiled.length);
+    return true;
+}
+
+void RecipeStore::resetToDefault() {
+    RecipeError error;
+
+    lock();
+    recipeCompile(RECIPE_DEFAULT_SOURCE, program, error);
+    strcpy(source, RECIPE_DEFAULT_SOURCE);
+    prefs.remove(NVS_KEY_SOURCE);
+    unlock();
+
+    LOG_I("RECIPE", "Recipe reset to default");
+}
+
+RecipeProgram RecipeStore::getProgram() {
+    lock();
+    RecipeProgram copy = program;
+    unlock();
+    return copy;
+}
+
+// ===== DEBUG =====
+
+void RecipeStore::printRecipe() {
+    RecipeProgram copy = getProgram();
+    RecipeStep step;
+
+    LOG_I("RECIPE", "%u steps, %u bytes", copy.stepCount, copy.length);
+    for (uint8_t i = 0; i < copy.stepCount; i++) {
+        if (!recipeDecode(copy, i, step)) break;
+        LOG_I("RECIPE", "  %2u %-5s mode=0x%X arg=%u timeout=%us",
+              i + 1, recipeOpName(step.op), step.mode, step.arg, step.timeoutS);
+    }
+}
+
+// ===== PRIVATE: MUTEX =====
+
+void RecipeStore::lock() {
+    if (mutex) xSemaphoreTake(mutex, portMAX_DELAY);
+}
+
+void RecipeStore::unlock() {
+    if (mutex) xSemaphoreGive(mutex);
+}
@@ -0,0 +1,110 @@
+// Recipe.h
+#ifndef RECIPE_H
+#define RECIPE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+// ===== RECIPE SOURCE =====
+// Satu batch = urutan step teks, dipisah ';' atau newline (case-insensitive):
+//
+//   FILL  FLOAT | <liter>L          [T=<detik>]   isi sampai float / volume
+//   COOL  <°C>  | AUTO              [T=<detik>]   dinginkan (AUTO = autoTemp)
+//   HOLD  <detik> | COUNT                         tahan suhu (COUNT = countValue)
+//   CIRC  UV | OZONE | UV+OZONE  <detik> | COUNT  treatment sampai dosis tercapai (detik = batas atas)
+//   DRAIN FLOW  | <liter>L          [T=<detik>]   kuras sampai aliran berhenti / volume
+//   TDS   <ppm>                     [T=<detik>]   TDS > limit: drain + isi ulang parsial
+//
+// Disimpan sebagai teks di NVS, divalidasi dan di-compile ke bytecode saat load.
+
+// ===== BYTECODE =====
+// Satu instruksi = 5 byte: [op << 4 | mode] [arg lo] [arg hi] [timeout lo] [timeout hi]
+enum class RecipeOp : uint8_t {
+    OP_END = 0,
+    OP_FILL,            // arg = volume (dL) jika MODE_VOLUME
+    OP_COOL,            // arg = target °C, kecuali MODE_SETTING
+    OP_HOLD,            // arg = durasi (detik), kecuali MODE_SETTING
+    OP_CIRCULATE,       // arg = durasi maks (detik), mode = CIRC_UV/CIRC_OZONE (+ MODE_SETTING)
+    OP_DRAIN,           // arg = volume (dL) jika MODE_VOLUME
+    OP_REFRESH,         // arg = limit TDS (ppm)
+    OP_COUNT
+};
+
+#define RECIPE_MODE_FLOAT        0x0    // FILL: sampai float sensor
+#define RECIPE_MODE_NO_FLOW      0x0    // DRAIN: sampai aliran berhenti
+#define RECIPE_MODE_VOLUME       0x1    // FILL/DRAIN: sampai volume flow sensor
+#define RECIPE_CIRC_UV           0x1
+#define RECIPE_CIRC_OZONE        0x2
+#define RECIPE_MODE_SETTING      0x4    // arg diambil dari SystemStorage saat step mulai
+
+#define RECIPE_MAX_STEPS         16
+#define RECIPE_STEP_BYTES        5
+#define RECIPE_MAX_CODE          (RECIPE_MAX_STEPS * RECIPE_STEP_BYTES + 1)   // + OP_END
+#define RECIPE_MAX_SOURCE        256
+#define RECIPE_MAX_TEMP_C        30
+#define RECIPE_MAX_VOLUME_DL     6000   // 600 L
+#define RECIPE_MAX_TDS_PPM       5000
+
+// Timeout default jika T= tidak ditulis (HOLD/CIRC dibatasi durasinya sendiri)
+#define RECIPE_FILL_TIMEOUT_S    1800   // 30 menit
+#define RECIPE_COOL_TIMEOUT_S    28800  // 8 jam
+#define RECIPE_DRAIN_TIMEOUT_S   1800   // 30 menit
+#define RECIPE_REFRESH_TIMEOUT_S 3600   // Drain + fill parsial
+
+// Perilaku AUTO bawaan: fill → cool ke autoTemp → hold countValue → drain
+#define RECIPE_DEFAULT_SOURCE    "FILL FLOAT; COOL AUTO; HOLD COUNT; DRAIN FLOW"
+
+struct RecipeStep {
+    RecipeOp op;
+    uint8_t mode;
+    uint16_t arg;
+    uint16_t timeoutS;          // 0 = tanpa timeout
+};
+
+struct RecipeProgram {
+    uint8_t code[RECIPE_MAX_CODE];
+    uint8_t length;             // Byte terpakai (termasuk OP_END)
+    uint8_t stepCount;
+};
+
+struct RecipeError {
+    uint8_t step;               // Step ke-berapa (1-based), 0 = seluruh recipe
+    const char* message;
+};
+
+// ===== COMPILER / DECODER =====
+bool recipeCompile(const char* source, RecipeProgram& program, RecipeError& error);
+bool recipeDecode(const RecipeProgram& program, uint8_t index, RecipeStep& step);
+const char* recipeOpName(RecipeOp op);
+
+// ===== RECIPE STORE CLASS =====
+// Recipe aktif di NVS (namespace "recipe"). Recipe yang gagal compile tidak
+// pernah disimpan; NVS kosong/rusak → kembali ke RECIPE_DEFAULT_SOURCE.
+class RecipeStore {
+public:
+    RecipeStore();
+    ~RecipeStore();
+
+    void begin();
+
+    bool load(const char* source, RecipeError& error);   // Compile, lalu simpan jika valid
+    void resetToDefault();
+
+    RecipeProgram getProgram();  // Copy - batch yang sedang jalan tidak ikut berubah
+
+    // ===== DEBUG =====
+    void printRecipe();
+
+private:
+    Preferences prefs;
+    SemaphoreHandle_t mutex;
+    StaticSemaphore_t mutexBuffer;
+
+    RecipeProgram program;
+    char source[RECIPE_MAX_SOURCE];
+
+    void lock();
+    void unlock();
+};
+
+#endif
@@ -0,0 +1,508 @@
+// RecipeRunner.cpp
+#include "RecipeRunner.h"
+#include "Logger.h"
+
+// ===== CONSTRUCTOR / DESTRUCTOR =====
+
+RecipeRunner::RecipeRunner(
+    StateConditionHandler* condHandler,
+    ActuatorControl* actuators,
+    SensorManager* sensors,
+    SystemStorage* storage
+)
+    : conditionHandler(condHandler)
+    , actuator(actuators)
+    , sensor(sensors)
+    , systemStorage(storage)
+    , program()
+    , step()
+    , stepIndex(0)
+    , status(RecipeStatus::RECIPE_IDLE)
+    , faultReason(nullptr)
+    , circulationEnabled(false)
+    , coolingActive(false)
+    , coolingTarget(0)
+    , volumeStartLiters(0)
+    , stepStartMs(0)
+    , stepDurationMs()
+    , dose(actuators, sensors)
+    , quality()
+    , refreshPhase(RefreshPhase::REFRESH_DONE)
+    , refreshLiters(0)
+    , refreshTankLiters(0)
+    , refreshTdsBefore(0)
+    , refreshStartMs(0)
+{
+    TimerService::initFlag(timeoutTimer);
+    TimerService::initFlag(durationTimer);
+}
+
+RecipeRunner::~RecipeRunner() {
+    timerService.cancel(timeoutTimer);
+    timerService.cancel(durationTimer);
+}
+
+void RecipeRunner::setEventQueue(QueueHandle_t queue) {
+    TimerService::initEvent(timeoutTimer, queue, FsmEvent::EV_DEADLINE);
+    TimerService::initEvent(durationTimer, queue, FsmEvent::EV_DEADLINE);
+    dose.setEventQueue(queue);
+}
+
+// ===== PUBLIC API =====
+
+void RecipeRunner::start(const RecipeProgram& recipe) {
+    if (status == RecipeStatus::RECIPE_RUNNING) {
+        stop();
+    }
+
+    program = recipe;
+    memset(stepDurationMs, 0, sizeof(stepDurationMs));
+    coolingActive = false;
+    faultReason = nullptr;
+
+    LOG_I("RECIPE", "Recipe started (%u steps)", program.stepCount);
+    enterStep(0, false);
+}
+
+void RecipeRunner::resume(const RecipeProgram& recipe, uint8_t index, uint32_t elapsedMs, float movedLiters) {
+    if (status == RecipeStatus::RECIPE_RUNNING) {
+        stop();
+    }
+
+    program = recipe;
+    memset(stepDurationMs, 0, sizeof(stepDurationMs));
+    coolingActive = false;
+    faultReason = nullptr;
+    refreshPhase = RefreshPhase::REFRESH_DONE;    // Fase TDS tidak di-checkpoint: mulai dari cek TDS
+
+    // Modular: benar walau jam boot masih lebih kecil dari elapsed
+    stepStartMs = TimerService::nowMs() - elapsedMs;
+    volumeStartLiters = sensor->getData().totalLiters - movedLiters;
+
+    // HOLD menjaga suhu dari step COOL sebelumnya: compressor dijalankan lagi
+    RecipeStep current, previous;
+    if (index > 0 && recipeDecode(program, index, current) && current.op == RecipeOp::OP_HOLD &&
+        recipeDecode(program, index - 1, previous) && previous.op == RecipeOp::OP_COOL) {
+        coolingTarget = coolTargetFor(previous);
+        conditionHandler->startCooling(coolingTarget);
+        coolingActive = true;
+    }
+
+    LOG_I("RECIPE", "Recipe resumed at step %u/%u (%lus in, %.1f L moved)",
+          index + 1, program.stepCount, (unsigned long)(elapsedMs / 1000), movedLiters);
+    enterStep(index, true);
+}
+
+RecipeStatus RecipeRunner::update() {
+    if (status != RecipeStatus::RECIPE_RUNNING) {
+        return status;
+    }
+
+    if (timerService.hasExpired(timeoutTimer)) {
+        fault("step timeout");
+        return status;
+    }
+
+    switch (step.op) {
+        case RecipeOp::OP_FILL:      updateFill();      break;
+        case RecipeOp::OP_COOL:      updateCool();      break;
+        case RecipeOp::OP_HOLD:      updateHold();      break;
+        case RecipeOp::OP_CIRCULATE: updateCirculate(); break;
+        case RecipeOp::OP_DRAIN:     updateDrain();     break;
+        case RecipeOp::OP_REFRESH:   updateRefresh();   break;
+        default: break;
+    }
+
+    return status;
+}
+
+void RecipeRunner::retryStep() {
+    if (status != RecipeStatus::RECIPE_FAULT) return;
+
+    LOG_I("RECIPE", "Retrying step %u (%s)", stepIndex + 1, recipeOpName(step.op));
+    enterStep(stepIndex, true);
+}
+
+void RecipeRunner::stop() {
+    if (status == RecipeStatus::RECIPE_RUNNING) {
+        leaveStep(RecipeOp::OP_END);
+    }
+    if (coolingActive) {
+        conditionHandler->stopCooling();
+        coolingActive = false;
+    }
+    timerService.cancel(timeoutTimer);
+    timerService.cancel(durationTimer);
+    status = RecipeStatus::RECIPE_IDLE;
+}
+
+void RecipeRunner::setCirculation(bool enable) {
+    circulationEnabled = enable;
+
+    if (status != RecipeStatus::RECIPE_RUNNING || step.op != RecipeOp::OP_HOLD) return;
+
+    if (enable && !dose.isActive()) {
+        startHoldOzone(timerService.remainingMs(durationTimer));
+    } else if (!enable) {
+        dose.stop();
+    }
+}
+
+DoseStatus RecipeRunner::getDoseStatus() const {
+    return dose.getStatus();
+}
+
+RecipeStatus RecipeRunner::getStatus() const {
+    return status;
+}
+
+uint8_t RecipeRunner::getStepIndex() const {
+    return stepIndex;
+}
+
+uint8_t RecipeRunner::getStepCount() const {
+    return program.stepCount;
+}
+
+RecipeOp RecipeRunner::getCurrentOp() const {
+    return status == RecipeStatus::RECIPE_IDLE ? RecipeOp::OP_END : step.op;
+}
+
+const char* RecipeRunner::getFaultReason() const {
+    return faultReason ? faultReason : "";
+}
+
+uint32_t RecipeRunner::getStepDurationMs(uint8_t index) const {
+    return index < RECIPE_MAX_STEPS ? stepDurationMs[index] : 0;
+}
+
+uint32_t RecipeRunner::getStepElapsedMs() const {
+    return status == RecipeStatus::RECIPE_IDLE ? 0 : static_cast<uint32_t>(TimerService::nowMs() - stepStartMs);
+}
+
+float RecipeRunner::getStepLiters() {
+    return status == RecipeStatus::RECIPE_IDLE ? 0 : volumeMovedLiters();
+}
+
+// ===== STEP HANDLING =====
+
+void RecipeRunner::enterStep(uint8_t index, bool resume) {
+    stepIndex = index;
+
+    if (!recipeDecode(program, index, step)) {
+        // OP_END: compressor terakhir dimatikan, batch selesai
+        if (coolingActive) {
+            conditionHandler->stopCooling();
+            coolingActive = false;
+        }
+        status = RecipeStatus::RECIPE_COMPLETE;
+        LOG_I("RECIPE", "Recipe complete");
+        return;
+    }
+
+    status = RecipeStatus::RECIPE_RUNNING;
+    faultReason = nullptr;
+
+    // Retry melanjutkan durasi/volume step, bukan mulai dari nol
+    if (!resume) {
+        stepStartMs = TimerService::nowMs();
+        volumeStartLiters = sensor->getData().totalLiters;
+    }
+
+    if (step.timeoutS) {
+        timerService.arm(timeoutTimer, static_cast<uint32_t>(step.timeoutS) * 1000UL);
+    }
+
+    uint32_t durationS = (step.mode & RECIPE_MODE_SETTING) ? systemStorage->getCountValue() : step.arg;
+
+    switch (step.op) {
+        case RecipeOp::OP_FILL: {
+            LOG_I("RECIPE", "Step %u FILL %s", index + 1,
+                  step.mode == RECIPE_MODE_VOLUME ? "volume" : "float");
+            // Volume: sisa dari step ini (retry melanjutkan), endpoint diprediksi handler
+            float targetLiters = 0;
+            if (step.mode == RECIPE_MODE_VOLUME) {
+                targetLiters = step.arg / 10.0f - volumeMovedLiters();
+                if (targetLiters < 0.1f) targetLiters = 0.1f;
+            }
+            conditionHandler->startFilling(targetLiters);
+            break;
+        }
+
+        case RecipeOp::OP_COOL:
+            coolingTarget = coolTargetFor(step);
+            LOG_I("RECIPE", "Step %u COOL to %u°C", index + 1, coolingTarget);
+            conditionHandler->startCooling(coolingTarget);
+            coolingActive = true;
+            break;
+
+        case RecipeOp::OP_HOLD:
+            // Cooling dari step COOL sebelumnya tetap jalan selama hold
+            LOG_I("RECIPE", "Step %u HOLD %lus", index + 1, (unsigned long)durationS);
+            timerService.arm(durationTimer, resume ? remainingMs(durationS * 1000UL) : durationS * 1000UL);
+            if (circulationEnabled) {
+                startHoldOzone(resume ? remainingMs(durationS * 1000UL) : durationS * 1000UL);
+            }
+            break;
+
+        case RecipeOp::OP_CIRCULATE:
+            LOG_I("RECIPE", "Step %u CIRC%s%s %lus", index + 1,
+                  (step.mode & RECIPE_CIRC_UV) ? " UV" : "",
+                  (step.mode & RECIPE_CIRC_OZONE) ? " OZONE" : "",
+                  (unsigned long)durationS);
+            // Durasi = batas atas; step selesai begitu dosis tercapai
+            timerService.arm(durationTimer, resume ? remainingMs(durationS * 1000UL) : durationS * 1000UL);
+            dose.start(conditionHandler->getTankLiters(),
+                       step.mode & RECIPE_CIRC_UV, step.mode & RECIPE_CIRC_OZONE, true,
+                       durationS * 1000UL);
+            break;
+
+        case RecipeOp::OP_DRAIN:
+            LOG_I("RECIPE", "Step %u DRAIN %s", index + 1,
+                  step.mode == RECIPE_MODE_VOLUME ? "volume" : "until no flow");
+            conditionHandler->startDraining();
+            break;
+
+        case RecipeOp::OP_REFRESH:
+            // Retry setelah inlet error: isi sisa volume yang sudah dibuang
+            if (resume && refreshPhase == RefreshPhase::REFRESH_FILL) {
+                float remaining = refreshLiters - volumeMovedLiters();
+                conditionHandler->startFilling(remaining < 0.1f ? 0.1f : remaining);
+                break;
+            }
+            startRefresh();
+            break;
+
+        default:
+            break;
+    }
+}
+
+void RecipeRunner::leaveStep(RecipeOp nextOp) {
+    timerService.cancel(timeoutTimer);
+    timerService.cancel(durationTimer);
+
+    switch (step.op) {
+        case RecipeOp::OP_FILL:
+            conditionHandler->stopFilling();
+            break;
+
+        case RecipeOp::OP_COOL:
+        case RecipeOp::OP_HOLD:
+            if (step.op == RecipeOp::OP_HOLD) {
+                dose.stop();
+            }
+            // COOL → HOLD: compressor/pump tetap jalan
+            if (nextOp != RecipeOp::OP_HOLD && coolingActive) {
+                conditionHandler->stopCooling();
+                coolingActive = false;
+            }
+            break;
+
+        case RecipeOp::OP_CIRCULATE:
+            dose.stop();
+            break;
+
+        case RecipeOp::OP_DRAIN:
+            conditionHandler->stopDraining();
+            break;
+
+        case RecipeOp::OP_REFRESH:
+            // Phase dibiarkan: retry melanjutkan isi ulang
+            if (refreshPhase == RefreshPhase::REFRESH_DRAIN) {
+                conditionHandler->stopDraining();
+            } else if (refreshPhase == RefreshPhase::REFRESH_FILL) {
+                conditionHandler->stopFilling();
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    stepDurationMs[stepIndex] = static_cast<uint32_t>(TimerService::nowMs() - stepStartMs);
+}
+
+void RecipeRunner::advance() {
+    RecipeStep next;
+    recipeDecode(program, stepIndex + 1, next);
+
+    leaveStep(next.op);
+    LOG_I("RECIPE", "Step %u %s done in %lus", stepIndex + 1, recipeOpName(step.op),
+          (unsigned long)(stepDurationMs[stepIndex] / 1000));
+
+    enterStep(stepIndex + 1, false);
+}
+
+// AUTO: target dari autoTemp; fallback ke setting cooling manual jika belum diisi
+uint8_t RecipeRunner::coolTargetFor(const RecipeStep& cool) {
+    if (!(cool.mode & RECIPE_MODE_SETTING)) return cool.arg;
+
+    SystemVariables settings = systemStorage->getVariables();
+    return settings.autoTemp != 0 ? settings.autoTemp : settings.coolingValue;
+}
+
+// Sisa durasi step yang dilanjutkan (retry / resume setelah reset)
+uint32_t RecipeRunner::remainingMs(uint32_t durationMs) const {
+    uint32_t elapsed = static_cast<uint32_t>(TimerService::nowMs() - stepStartMs);
+    return elapsed < durationMs ? durationMs - elapsed : 0;
+}
+
+void RecipeRunner::fault(const char* reason) {
+    leaveStep(RecipeOp::OP_END);
+    faultReason = reason;
+    status = RecipeStatus::RECIPE_FAULT;
+    LOG_W("RECIPE", "Step %u %s failed: %s", stepIndex + 1, recipeOpName(step.op), reason);
+}
+
+// ===== STEP UPDATES =====
+
+void RecipeRunner::updateFill() {
+    FillingStatus fillStatus = conditionHandler->checkFillingCondition();
+
+    if (fillStatus == FillingStatus::FILLING_ERROR) {
+        fault("no inlet flow");
+        return;
+    }
+
+    // COMPLETE = endpoint volume (prediktif) atau float sensor sebagai backstop
+    if (fillStatus == FillingStatus::FILLING_COMPLETE) {
+        // Tangki berisi air baru saja → TDS = air masuk (untuk neraca step TDS)
+        SensorData data = sensor->getData();
+        if (conditionHandler->isFillFromEmpty() && data.tdsValid) {
+            quality.learnInlet(data.tdsValue);
+        }
+        advance();
+    }
+}
+
+void RecipeRunner::updateCool() {
+    SensorData data = sensor->getData();
+    if (!data.tempValid) {
+        fault("temperature sensor invalid");
+        return;
+    }
+
+    conditionHandler->updateCooling();
+
+    if (data.temperature <= coolingTarget) {
+        advance();
+    }
+}
+
+void RecipeRunner::updateHold() {
+    // Jaga suhu selama hold
+    if (coolingActive) {
+        conditionHandler->updateCooling();
+    }
+
+    // Ozone berhenti sendiri saat dosis tercapai, hold tetap sampai durasi habis
+    if (dose.isActive()) {
+        dose.update(sensor->getData());
+    }
+
+    if (timerService.hasExpired(durationTimer)) {
+        advance();
+    }
+}
+
+void RecipeRunner::updateCirculate() {
+    if (dose.update(sensor->getData())) {
+        advance();
+    } else if (timerService.hasExpired(durationTimer)) {
+        LOG_W("RECIPE", "Step %u CIRC: max time reached before dose", stepIndex + 1);
+        advance();
+    }
+}
+
+void RecipeRunner::startHoldOzone(uint32_t budgetMs) {
+    // Pump milik cooling selama hold; dose hanya mengatur ozone
+    dose.start(conditionHandler->getTankLiters(), false, true, false, budgetMs);
+}
+
+void RecipeRunner::updateDrain() {
+    // Tangki kosong sebelum volume tercapai juga dianggap selesai
+    if (conditionHandler->checkDrainingCondition() == DrainingStatus::DRAINING_COMPLETE ||
+        (step.mode == RECIPE_MODE_VOLUME && volumeMovedLiters() * 10.0f >= step.arg)) {
+        advance();
+    }
+}
+
+void RecipeRunner::startRefresh() {
+    SensorData data = sensor->getData();
+    refreshPhase = RefreshPhase::REFRESH_DONE;
+    refreshTankLiters = conditionHandler->getTankLiters();
+    refreshTdsBefore = data.tdsValue;
+    refreshStartMs = TimerService::nowMs();
+
+    // Tanpa data kualitas/volume batch tetap jalan
+    if (!data.tdsValid) {
+        LOG_W("RECIPE", "Step %u TDS: sensor invalid - skipped", stepIndex + 1);
+        return;
+    }
+    if (refreshTankLiters <= 0) {
+        LOG_W("RECIPE", "Step %u TDS: tank volume unknown - skipped", stepIndex + 1);
+        return;
+    }
+
+    refreshLiters = quality.planExchange(refreshTankLiters, data.tdsValue, step.arg);
+    if (refreshLiters <= 0) {
+        LOG_I("RECIPE", "Step %u TDS %d ppm <= %u ppm - no exchange", stepIndex + 1, data.tdsValue, step.arg);
+        return;
+    }
+
+    LOG_I("RECIPE", "Step %u TDS %d ppm > %u ppm: exchange %.1f of %.1f L (inlet %.0f ppm)",
+          stepIndex + 1, data.tdsValue, step.arg, refreshLiters, refreshTankLiters, quality.getInletTds());
+    volumeStartLiters = data.totalLiters;
+    refreshPhase = RefreshPhase::REFRESH_DRAIN;
+    conditionHandler->startDraining();
+}
+
+void RecipeRunner::updateRefresh() {
+    switch (refreshPhase) {
+        case RefreshPhase::REFRESH_DRAIN: {
+            // Tangki kosong lebih dulu (volume tangki terlalu besar) juga mengakhiri drain
+            bool empty = conditionHandler->checkDrainingCondition() == DrainingStatus::DRAINING_COMPLETE;
+            float drained = volumeMovedLiters();
+            if (!empty && drained < refreshLiters) return;
+
+            conditionHandler->stopDraining();
+            refreshLiters = drained;
+            if (refreshLiters < 0.1f) {
+                // Tidak ada yang keluar: isi ulang 0 L berarti fill sampai float
+                LOG_W("RECIPE", "Step %u TDS: nothing drained - refill skipped", stepIndex + 1);
+                refreshPhase = RefreshPhase::REFRESH_DONE;
+                advance();
+                return;
+            }
+            refreshPhase = RefreshPhase::REFRESH_FILL;
+            volumeStartLiters = sensor->getData().totalLiters;
+            conditionHandler->startFilling(refreshLiters);
+            return;
+        }
+
+        case RefreshPhase::REFRESH_FILL: {
+            FillingStatus fillStatus = conditionHandler->checkFillingCondition();
+            if (fillStatus == FillingStatus::FILLING_ERROR) {
+                fault("no inlet flow");
+                return;
+            }
+            if (fillStatus != FillingStatus::FILLING_COMPLETE) return;
+
+            quality.logSaving(refreshTankLiters, refreshLiters,
+                              static_cast<uint32_t>(TimerService::nowMs() - refreshStartMs),
+                              refreshTdsBefore,
+                              quality.predictTds(refreshTankLiters, refreshTdsBefore, refreshLiters));
+            advance();
+            return;
+        }
+
+        default:
+            advance();
+            return;
+    }
+}
+
+float RecipeRunner::volumeMovedLiters() {
+    return static_cast<float>(sensor->getData().totalLiters - volumeStartLiters);
+}
@@ -0,0 +1,112 @@
+// RecipeRunner.h
+#ifndef RECIPE_RUNNER_H
+#define RECIPE_RUNNER_H
+
+#include <Arduino.h>
+#include "Recipe.h"
+#include "StateConditionHandler.h"
+#include "SystemVariables.h"
+#include "TimerService.h"
+#include "DoseController.h"
+#include "WaterQuality.h"
+
+enum class RecipeStatus : uint8_t {
+    RECIPE_IDLE = 0,
+    RECIPE_RUNNING,
+    RECIPE_COMPLETE,            // OP_END tercapai
+    RECIPE_FAULT                // Step gagal - actuator step sudah OFF, tunggu retryStep()/stop()
+};
+
+enum class RefreshPhase : uint8_t {
+    REFRESH_DONE = 0,           // Tidak perlu / selesai
+    REFRESH_DRAIN,              // Buang sebagian
+    REFRESH_FILL                // Isi ulang sebanyak yang keluar
+};
+
+// ===== RECIPE INTERPRETER =====
+// Menjalankan RecipeProgram step demi step dari FSM task memakai condition
+// handler yang sama dengan mode manual. Tidak pernah alokasi: program di-copy
+// ke member, step di-decode ke struct lokal.
+class RecipeRunner {
+public:
+    RecipeRunner(
+        StateConditionHandler* condHandler,
+        ActuatorControl* actuators,
+        SensorManager* sensors,
+        SystemStorage* storage
+    );
+    ~RecipeRunner();
+
+    // Timer timeout/durasi step mem-post EV_DEADLINE ke queue ini
+    void setEventQueue(QueueHandle_t queue);
+
+    void start(const RecipeProgram& recipe);
+    // Setelah reset: lanjut di step index dengan waktu & volume step yang sudah berjalan
+    void resume(const RecipeProgram& recipe, uint8_t index, uint32_t elapsedMs, float movedLiters);
+    RecipeStatus update();
+    void retryStep();                       // Ulangi step yang FAULT (volume tetap dihitung dari awal step)
+    void stop();
+    void setCirculation(bool enable);       // Dosis ozone selama HOLD (AUTO_CIRCULATION)
+    DoseStatus getDoseStatus() const;
+
+    RecipeStatus getStatus() const;
+    uint8_t getStepIndex() const;
+    uint8_t getStepCount() const;
+    RecipeOp getCurrentOp() const;
+    const char* getFaultReason() const;
+    uint32_t getStepDurationMs(uint8_t index) const;
+    uint32_t getStepElapsedMs() const;      // Step aktif (checkpoint)
+    float getStepLiters();                  // Volume dipindah step aktif (checkpoint)
+
+private:
+    // Dependencies
+    StateConditionHandler* conditionHandler;
+    ActuatorControl* actuator;
+    SensorManager* sensor;
+    SystemStorage* systemStorage;
+
+    RecipeProgram program;
+    RecipeStep step;                        // Step aktif (hasil decode)
+    uint8_t stepIndex;
+    RecipeStatus status;
+    const char* faultReason;
+
+    bool circulationEnabled;
+    bool coolingActive;                     // Compressor dikelola condition handler
+    uint8_t coolingTarget;
+    double volumeStartLiters;               // totalLiters saat step FILL/DRAIN volume mulai
+    uint64_t stepStartMs;
+    uint32_t stepDurationMs[RECIPE_MAX_STEPS];
+    DoseController dose;                    // CIRC & ozone HOLD: selesai saat dosis tercapai
+
+    // ===== TDS REFRESH =====
+    WaterQuality quality;
+    RefreshPhase refreshPhase;
+    float refreshLiters;                    // Rencana drain → aktual keluar (= volume isi ulang)
+    float refreshTankLiters;
+    int refreshTdsBefore;
+    uint64_t refreshStartMs;
+
+    Timer timeoutTimer;
+    Timer durationTimer;
+
+    void enterStep(uint8_t index, bool resume);
+    void leaveStep(RecipeOp nextOp);
+    void advance();
+    void fault(const char* reason);
+    uint8_t coolTargetFor(const RecipeStep& cool);
+    uint32_t remainingMs(uint32_t durationMs) const;
+
+    void updateFill();
+    void updateCool();
+    void updateHold();
+    void updateCirculate();
+    void updateDrain();
+    void updateRefresh();
+    void startRefresh();
+    void startHoldOzone(uint32_t budgetMs);
+
+    float volumeMovedLiters();
+};
+
+#endif
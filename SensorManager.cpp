@@ -1,4 +1,8 @@
 #include "SensorManager.h"
+#include "Logger.h"
+#include "FlowCalibration.h"
+#include "EventBus.h"
+#include <new>
 
 // Pin definitions (sesuaikan dengan HardwareConfig.h Anda)
 #define PIN_TEMP_SENSOR   32
@@ -21,14 +25,33 @@ void IRAM_ATTR SensorManager::flowISR() {
     }
 }
 
+// ===== ISR untuk Float Sensor & Flow Switch =====
+// Cukup satu event pending: FSM membaca ulang kedua pin saat memprosesnya
+void IRAM_ATTR SensorManager::inputISR() {
+    if (!instance || !instance->eventQueue || instance->inputEventPending) return;
+    
+    instance->inputEventPending = true;
+    BaseType_t woken = pdFALSE;
+    fsmPostEventFromISR(instance->eventQueue, FsmEvent::EV_SENSOR_CHANGED, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+
 // ===== CONSTRUCTOR / DESTRUCTOR =====
 
 SensorManager::SensorManager()
     : pulseCount(0)
     , lastPulseCount(0)
+    , flowLiters(0)
+    , flowK(FLOW_CALIBRATION)
     , lastFlowReadMs(0)
+    , flowCal(nullptr)
+    , eventQueue(nullptr)
+    , eventBus(nullptr)
+    , inputEventPending(false)
+    , eventTemperature(-99.0f)
 {
-    mutex = xSemaphoreCreateMutex();
+    mutex = xSemaphoreCreateMutexStatic(&mutexBuffer);
+    portMUX_INITIALIZE(&flowMux);
     instance = this;  // Set static instance
     
     // Init data
@@ -36,19 +59,27 @@ SensorManager::SensorManager()
     data.tempValid = false;
     data.flowRate = 0.0f;
     data.totalPulses = 0;
+    data.totalLiters = 0;
     data.floatSensor = false;
     data.flowSwitch = false;
     data.tdsValue = -1;
     data.tdsValid = false;
     data.lastUpdate = 0;
+    sample = data;
+    snapshot.publish(data);
+    
+    TimerService::initFlag(tempReadTimer);
+    TimerService::initFlag(flowReadTimer);
     
     oneWire = nullptr;
     ds18b20 = nullptr;
 }
 
 SensorManager::~SensorManager() {
-    if (ds18b20) delete ds18b20;
-    if (oneWire) delete oneWire;
+    timerService.cancel(tempReadTimer);
+    timerService.cancel(flowReadTimer);
+    if (ds18b20) ds18b20->~DallasTemperature();
+    if (oneWire) oneWire->~OneWire();
     if (mutex) vSemaphoreDelete(mutex);
 }
 
@@ -56,11 +87,15 @@ SensorManager::~SensorManager() {
 
 void SensorManager::begin() {
     // ===== TEMPERATURE SENSOR (DS18B20) =====
-    oneWire = new OneWire(PIN_TEMP_SENSOR);
-    ds18b20 = new DallasTemperature(oneWire);
+    if (!oneWire) {
+        oneWire = new (oneWireStorage) OneWire(PIN_TEMP_SENSOR);
+        ds18b20 = new (ds18b20Storage) DallasTemperature(oneWire);
+    }
     ds18b20->begin();
     ds18b20->setResolution(12);
+    ds18b20->setWaitForConversion(false);  // Konversi 750ms jalan di background
     ds18b20->requestTemperatures();
+    timerService.armPeriodic(tempReadTimer, 1000);
     
     // ===== FLOW SENSOR (YF-S201) =====
     pinMode(PIN_FLOW_SENSOR, INPUT_PULLUP);
@@ -69,167 +104,240 @@ void SensorManager::begin() {
         flowISR,
         RISING
     );
+    portENTER_CRITICAL(&flowMux);
     pulseCount = 0;
     lastPulseCount = 0;
-    lastFlowReadMs = millis();
+    flowLiters = 0;
+    flowK = flowCal ? flowCal->pulsesPerLiter() : FLOW_CALIBRATION;
+    portEXIT_CRITICAL(&flowMux);
+    lastFlowReadMs = TimerService::nowMs();
+    timerService.armPeriodic(flowReadTimer, 500);
     
     // ===== DIGITAL INPUTS =====
     pinMode(PIN_FLOAT_SENSOR, INPUT_PULLUP);
     pinMode(PIN_FLOW_SWITCH, INPUT_PULLUP);  // External pull-up
+    attachInterrupt(digitalPinToInterrupt(PIN_FLOAT_SENSOR), inputISR, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(PIN_FLOW_SWITCH), inputISR, CHANGE);
     
     // ===== TDS SENSOR (Analog) =====
     pinMode(PIN_TDS_SENSOR, INPUT);
     
-    Serial.println("[SENSOR] All sensors initialized");
+    LOG_I("SENSOR", "All sensors initialized");
 }
 
 void SensorManager::update() {
-    lock();
-    
+    // Hardware I/O (OneWire, ADC) di luar mutex - reader tidak ikut menunggu
     updateTemperature();
     updateFlow();
     updateTDS();
-    updateDigitalInputs();
     
+    lock();
+    
+    SensorData before = data;
+    sample.floatSensor = data.floatSensor;  // Input digital dimiliki updateDigitalInputs()
+    sample.flowSwitch = data.flowSwitch;
+    data = sample;
+    updateDigitalInputs();
     data.lastUpdate = millis();
     
+    bool changed = isSignificantChange(before, data);
+    snapshot.publish(data);
+    SensorData published = data;
+    
     unlock();
+    
+    // Handler subscriber jalan di luar mutex: refreshDigitalInputs() (FSM task)
+    // tidak pernah menunggu display
+    if (eventBus) eventBus->sensors.publish(published);
+    
+    if (changed) {
+        fsmPostEvent(eventQueue, FsmEvent::EV_SENSOR_CHANGED);
+    }
 }
 
-// ===== GETTERS =====
+// ===== EVENTS =====
 
-SensorData SensorManager::getData() {
-    SensorData copy;
+void SensorManager::setEventQueue(QueueHandle_t queue) {
+    eventQueue = queue;
+}
+
+void SensorManager::setEventBus(EventBus* bus) {
+    eventBus = bus;
+}
+
+void SensorManager::setCalibration(FlowCalibration* calibration) {
+    flowCal = calibration;
+}
+
+void SensorManager::refreshDigitalInputs() {
+    // Clear dulu - edge yang datang setelah ini akan di-post lagi oleh ISR
+    inputEventPending = false;
+    
     lock();
-    copy = data;
+    updateDigitalInputs();
+    snapshot.publish(data);  // Topic sensors ikut di update() berikutnya (satu publisher: sensor task)
     unlock();
-    return copy;
+}
+
+// ===== GETTERS =====
+
+SensorData SensorManager::getData() {
+    return snapshot.read();
+}
+
+uint32_t SensorManager::getData(SensorData& out) {
+    return snapshot.read(out);
+}
+
+uint32_t SensorManager::getVersion() {
+    return snapshot.version();
 }
 
 float SensorManager::getTemperature() {
-    lock();
-    float temp = data.temperature;
-    unlock();
-    return temp;
+    return snapshot.read().temperature;
 }
 
 float SensorManager::getFlowRate() {
-    lock();
-    float flow = data.flowRate;
-    unlock();
-    return flow;
+    return snapshot.read().flowRate;
 }
 
 bool SensorManager::getFloatSensor() {
-    lock();
-    bool state = data.floatSensor;
-    unlock();
-    return state;
+    return snapshot.read().floatSensor;
 }
 
 bool SensorManager::getFlowSwitch() {
-    lock();
-    bool state = data.flowSwitch;
-    unlock();
-    return state;
+    return snapshot.read().flowSwitch;
 }
 
 int SensorManager::getTDS() {
-    lock();
-    int tds = data.tdsValue;
-    unlock();
-    return tds;
+    return snapshot.read().tdsValue;
+}
+
+double SensorManager::getLiters() {
+    portENTER_CRITICAL(&flowMux);
+    double liters = flowLiters + (pulseCount - lastPulseCount) / flowK;
+    portEXIT_CRITICAL(&flowMux);
+    return liters;
+}
+
+uint32_t SensorManager::getPulseCount() {
+    return pulseCount;  // 32-bit aligned: baca atomik di ESP32
 }
 
 // ===== DEBUG =====
 
       void SensorManager::printSensorData() {
-          lock();
+          // Snapshot: Serial lambat tidak menahan sensor task
+          SensorData current = snapshot.read();
           
           Serial.println("╔════════════════════════════════════╗");
           Serial.println("║      SENSOR DATA                   ║");
           Serial.println("╠════════════════════════════════════╣");
           
           Serial.print("║ Temperature  : ");
-          if (data.tempValid) {
-              Serial.print(data.temperature, 1);
+          if (current.tempValid) {
+              Serial.print(current.temperature, 1);
               Serial.println(" °C     ║");
           } else {
               Serial.println("INVALID       ║");
           }
           
           Serial.print("║ Flow Rate    : ");
-          Serial.print(data.flowRate, 2);
+          Serial.print(current.flowRate, 2);
           Serial.println(" L/min  ║");
           
           Serial.print("║ Total Pulses : ");
-          Serial.print(data.totalPulses);
+          Serial.print(current.totalPulses);
           Serial.println("           ║");
           
           Serial.print("║ Float Sensor : ");
-          Serial.println(data.floatSensor ? "DETECTED  ║" : "EMPTY     ║");
+          Serial.println(current.floatSensor ? "DETECTED  ║" : "EMPTY     ║");
           
           Serial.print("║ Flow Switch  : ");
-          Serial.println(data.flowSwitch ? "FLOW      ║" : "NO FLOW   ║");
+          Serial.println(current.flowSwitch ? "FLOW      ║" : "NO FLOW   ║");
           
           Serial.print("║ TDS          : ");
-          if (data.tdsValid) {
-              Serial.print(data.tdsValue);
+          if (current.tdsValid) {
+              Serial.print(current.tdsValue);
               Serial.println(" ppm       ║");
           } else {
               Serial.println("INVALID       ║");
           }
           
           Serial.println("╚════════════════════════════════════╝");
-          
-          unlock();
       }
 
 // ===== PRIVATE UPDATE METHODS =====
 
+bool SensorManager::isSignificantChange(const SensorData& before, const SensorData& after) {
+    if (before.floatSensor != after.floatSensor) return true;
+    if (before.flowSwitch != after.flowSwitch) return true;
+    if (before.tempValid != after.tempValid) return true;
+    
+    if (after.tempValid && fabsf(after.temperature - eventTemperature) >= TEMP_EVENT_DELTA) {
+        eventTemperature = after.temperature;
+        return true;
+    }
+    
+    return (before.flowRate > FLOW_EVENT_THRESHOLD) != (after.flowRate > FLOW_EVENT_THRESHOLD);
+}
+
       void SensorManager::updateTemperature() {
-          static unsigned long lastTempReadMs = 0;
-          
-          if (millis() - lastTempReadMs >= 1000) {  // Update setiap 1 detik
-              ds18b20->requestTemperatures();
+          if (timerService.consumeExpired(tempReadTimer)) {  // Update setiap 1 detik
+              // Ambil hasil konversi sebelumnya (sudah >750ms), lalu mulai konversi berikutnya
               float temp = ds18b20->getTempCByIndex(0);
+              ds18b20->requestTemperatures();
               
               // Validasi (DS18B20 return -127 atau 85 jika error)
               if (temp == -127.0f || temp == 85.0f) {
-                  data.temperature = -99.0f;
-                  data.tempValid = false;
+                  sample.temperature = -99.0f;
+                  sample.tempValid = false;
               } else {
-                  data.temperature = temp;
-                  data.tempValid = true;
+                  sample.temperature = temp;
+                  sample.tempValid = true;
               }
-              
-              lastTempReadMs = millis();
           }
       }
 
       void SensorManager::updateFlow() {
-          unsigned long now = millis();
-          unsigned long elapsedMs = now - lastFlowReadMs;
-          
-          if (elapsedMs >= 500) {  // Update setiap 500ms
-              noInterrupts();
-              uint32_t pulses = pulseCount - lastPulseCount;
-              lastPulseCount = pulseCount;
-              data.totalPulses = pulseCount;
-              interrupts();
+          if (timerService.consumeExpired(flowReadTimer)) {  // Update setiap 500ms
+              uint64_t now = TimerService::nowMs();
+              uint32_t elapsedMs = static_cast<uint32_t>(now - lastFlowReadMs);
+              
+              // Baca saja dulu: K kalibrasi (mutex) dihitung di luar critical section,
+              // getLiters() tetap melihat pulse interval ini sebagai "belum disampel"
+              uint32_t counted = pulseCount;
+              uint32_t pulses = counted - lastPulseCount;
               
+              float k = flowCal ? flowCal->pulsesPerLiter() : FLOW_CALIBRATION;
+              float liters = pulses / k;
               if (pulses == 0 || elapsedMs == 0) {
-                  data.flowRate = 0.0f;
+                  sample.flowRate = 0.0f;
               } else {
-                  float liters = pulses / FLOW_CALIBRATION;
-                  data.flowRate = (liters * 60000.0f) / elapsedMs;  // Convert to L/min
+                  sample.flowRate = (liters * 60000.0f) / elapsedMs;  // Convert to L/min
+                  
+                  // Koreksi K per flow: estimasi pertama cukup dekat untuk memilih titik kurva.
+                  // Volume ikut kurva yang sama (bukan hanya flow rate yang tampil).
+                  if (flowCal) {
+                      k = flowCal->pulsesPerLiterAt(sample.flowRate);
+                      liters = pulses / k;
+                      sample.flowRate = (liters * 60000.0f) / elapsedMs;
+                  }
                   
                   // Cap maximum flow rate
-                  if (data.flowRate > FLOW_MAX_RATE) {
-                      data.flowRate = FLOW_MAX_RATE;
+                  if (sample.flowRate > FLOW_MAX_RATE) {
+                      sample.flowRate = FLOW_MAX_RATE;
                   }
               }
               
+              portENTER_CRITICAL(&flowMux);
+              lastPulseCount = counted;
+              flowLiters += liters;
+              flowK = k;
+              sample.totalPulses = counted;
+              sample.totalLiters = flowLiters;
+              portEXIT_CRITICAL(&flowMux);
+              
               lastFlowReadMs = now;
           }
       }
@@ -254,7 +362,7 @@ void SensorManager::updateTDS() {
 
     // Buffer belum penuh → jangan hitung dulu
     if (!bufFull) {
-        data.tdsValid = false;
+        sample.tdsValid = false;
         return;
     }
 
@@ -284,15 +392,15 @@ void SensorManager::updateTDS() {
 
     // Validasi dasar
     if (voltage < 0.1f || voltage > 4.9f) {
-        data.tdsValue = -1;
-        data.tdsValid = false;
+        sample.tdsValue = -1;
+        sample.tdsValid = false;
         return;
     }
 
     // === Temperature compensation ===
     float compensation = 1.0f;
-    if (data.tempValid && data.temperature > -10.0f && data.temperature < 80.0f) {
-        compensation = 1.0f + 0.02f * (data.temperature - 25.0f);
+    if (sample.tempValid && sample.temperature > -10.0f && sample.temperature < 80.0f) {
+        compensation = 1.0f + 0.02f * (sample.temperature - 25.0f);
     }
 
     float compensatedVoltage = voltage / compensation;
@@ -317,11 +425,11 @@ void SensorManager::updateTDS() {
 
     // === Anti-jitter: hanya update jika perubahan > threshold ===
     constexpr float CHANGE_THRESHOLD = 7.0f;  // ppm
-    if (abs(filteredTDS - data.tdsValue) >= CHANGE_THRESHOLD || !data.tdsValid) {
-        data.tdsValue = static_cast<int>(filteredTDS);
+    if (abs(filteredTDS - sample.tdsValue) >= CHANGE_THRESHOLD || !sample.tdsValid) {
+        sample.tdsValue = static_cast<int>(filteredTDS);
     }
     
-    data.tdsValid = true;
+    sample.tdsValid = true;
   }
 
 
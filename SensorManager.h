@@ -4,6 +4,12 @@
 #include <Arduino.h>
 #include <OneWire.h>
 #include <DallasTemperature.h>
+#include "FsmEvent.h"
+#include "TimerService.h"
+#include "SeqLock.h"
+
+class FlowCalibration;
+struct EventBus;
 
 // ===== SENSOR DATA STRUCT =====
 struct SensorData {
@@ -13,7 +19,8 @@ struct SensorData {
     
     // Flow
     float flowRate;           // L/min
-    uint32_t totalPulses;     // Total pulse count
+    uint32_t totalPulses;     // Total pulse count (mentah, untuk kalibrasi K)
+    double totalLiters;       // Volume terintegrasi per sampel dengan K(flow)
     
     // Water Level & Switch
     bool floatSensor;         // true = water detected
@@ -36,35 +43,76 @@ public:
     void begin();
     void update();  // Call dari task berkala
     
+    // ===== EVENTS =====
+    // EV_SENSOR_CHANGED di-post saat input digital berubah (langsung dari ISR)
+    // atau sampel melewati threshold - FSM tidak perlu polling
+    void setEventQueue(QueueHandle_t queue);
+    
+    // Setiap sampel update() juga di-fan-out ke topic sensors (dari sensor task)
+    void setEventBus(EventBus* bus);
+    
+    // K-factor hasil kalibrasi; nullptr = FLOW_CALIBRATION datasheet
+    void setCalibration(FlowCalibration* calibration);
+    void refreshDigitalInputs();  // Baca ulang float/flow switch sekarang (dari FSM task)
+    
     // ===== GETTERS =====
+    // Snapshot seqlock: koheren, tidak pernah menunggu sensor task
     SensorData getData();
+    uint32_t getData(SensorData& out);      // Return versi snapshot
+    uint32_t getVersion();                  // Naik tiap sampel / perubahan input
     
     float getTemperature();
     float getFlowRate();
     bool getFloatSensor();
     bool getFlowSwitch();
     int getTDS();
+    // Volume: selisih getLiters() / totalLiters. Kurva K(flow) diterapkan per
+    // sampel flow, jadi fill (tekanan inlet) dan drain (gravitasi) sama-sama benar.
+    double getLiters();                     // totalLiters + pulse sejak sampel terakhir (tanpa menunggu 500ms)
+    uint32_t getPulseCount();               // Pulse mentah ISR, hanya untuk titik kalibrasi K
     
     // ===== DEBUG =====
     void printSensorData();
     
 private:
-    SemaphoreHandle_t mutex;
-    SensorData data;
+    SemaphoreHandle_t mutex;  // Hanya antar writer (update vs refreshDigitalInputs)
+    StaticSemaphore_t mutexBuffer;
+    SensorData data;          // Milik writer, di-publish ke snapshot
+    SensorData sample;        // Working copy milik update() - diisi tanpa lock
+    SeqLock<SensorData> snapshot;
     
-    // Temperature (DS18B20)
+    // Temperature (DS18B20): driver di-construct di begin() ke storage statis
+    // (constructor OneWire menyentuh GPIO, belum aman di global constructor)
+    alignas(OneWire) uint8_t oneWireStorage[sizeof(OneWire)];
+    alignas(DallasTemperature) uint8_t ds18b20Storage[sizeof(DallasTemperature)];
     OneWire* oneWire;
     DallasTemperature* ds18b20;
+    Timer tempReadTimer;      // Periodic 1 s (konversi 12-bit butuh 750 ms)
     
     // Flow sensor (YF-S201)
     volatile uint32_t pulseCount;
     uint32_t lastPulseCount;
-    unsigned long lastFlowReadMs;
+    double flowLiters;        // Volume sampai lastPulseCount
+    float flowK;              // K(flow) sampel terakhir: pulse yang belum disampel → liter
+    portMUX_TYPE flowMux;     // lastPulseCount / flowLiters / flowK dibaca FSM task
+    uint64_t lastFlowReadMs;  // TimerService::nowMs() - basis hitung L/min
+    Timer flowReadTimer;      // Periodic 500 ms
+    FlowCalibration* flowCal;
     static const float FLOW_CALIBRATION;
     static const float FLOW_MAX_RATE;
     static void IRAM_ATTR flowISR();
     static SensorManager* instance;  // For ISR
     
+    // Event
+    QueueHandle_t eventQueue;
+    EventBus* eventBus;
+    volatile bool inputEventPending;
+    float eventTemperature;   // Temperature saat event terakhir di-post
+    static constexpr float TEMP_EVENT_DELTA = 0.1f;       // °C
+    static constexpr float FLOW_EVENT_THRESHOLD = 0.1f;   // L/min (= threshold drain)
+    static void IRAM_ATTR inputISR();
+    bool isSignificantChange(const SensorData& before, const SensorData& after);
+    
     // Private methods
     void updateTemperature();
     void updateFlow();
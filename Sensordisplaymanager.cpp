@@ -1,16 +1,17 @@
 #include "SensorDisplayManager.h"
+#include "EventBus.h"
+#include "Logger.h"
 
 // ===== CONSTRUCTOR / DESTRUCTOR =====
 
 SensorDisplayManager::SensorDisplayManager()
-    : sensorPtr(nullptr)
-    , nextionPtr(nullptr)
+    : nextionPtr(nullptr)
     , lastTemp(-99)
     , lastTDS(-1)
     , lastFlow(-1.0f)
     , lastSyncMs(0)
 {
-    mutex = xSemaphoreCreateMutex();
+    mutex = xSemaphoreCreateMutexStatic(&mutexBuffer);
 }
 
 SensorDisplayManager::~SensorDisplayManager() {
@@ -19,81 +20,69 @@ SensorDisplayManager::~SensorDisplayManager() {
 
 // ===== PUBLIC API =====
 
-void SensorDisplayManager::begin(SensorManager* sensor, NextionGateWay* nextion) {
-    if (!sensor || !nextion) {
-        Serial.println("[SENSOR_DISPLAY] ERROR: Invalid pointers");
+void SensorDisplayManager::begin(EventBus* bus, NextionGateWay* nextion) {
+    if (!bus || !nextion) {
+        LOG_E("SENSOR_DISPLAY", "ERROR: Invalid pointers");
         return;
     }
     
     lock();
-    sensorPtr = sensor;
     nextionPtr = nextion;
-    lastSyncMs = millis();
     unlock();
     
-    Serial.println("[SENSOR_DISPLAY] Initialized successfully");
+    // Threshold lewat filter, rate limit UART, force update tiap FORCE_SYNC_MS
+    bus->sensors.subscribe("display", onSensorData, this,
+                           isSyncNeeded, SYNC_MIN_INTERVAL_MS, FORCE_SYNC_MS);
+    
+    LOG_I("SENSOR_DISPLAY", "Initialized successfully");
 }
 
-void SensorDisplayManager::syncToNextion() {
-    if (!sensorPtr || !nextionPtr) {
-        Serial.println("[SENSOR_DISPLAY] ERROR: Not initialized");
+void SensorDisplayManager::syncToNextion(const SensorData& data) {
+    if (!nextionPtr) {
+        LOG_E("SENSOR_DISPLAY", "ERROR: Not initialized");
         return;
     }
     
-    // Get current sensor data
-    SensorData current = sensorPtr->getData();
-    
     // Validate sensor data
-    if (!isSensorDataValid()) {
-        Serial.println("[SENSOR_DISPLAY] WARNING: Invalid sensor data");
+    if (!isSensorDataValid(data)) {
+        LOG_W("SENSOR_DISPLAY", "WARNING: Invalid sensor data");
         return;
     }
     
     lock();
+    lastTemp = (int)data.temperature;
+    lastTDS = data.tdsValue;
+    lastFlow = data.flowRate;
+    lastSyncMs = TimerService::nowMs();
+    unlock();
     
-    // Check if any sensor changed or force sync time exceeded
-    bool needsUpdate = false;
-    
-    if (isTemperatureChanged(current.temperature)) {
-        needsUpdate = true;
-        lastTemp = (int)current.temperature;
-    }
-    
-    if (isTDSChanged(current.tdsValue)) {
-        needsUpdate = true;
-        lastTDS = current.tdsValue;
-    }
-    
-    if (isFlowChanged(current.flowRate)) {
-        needsUpdate = true;
-        lastFlow = current.flowRate;
-    }
-    
-    // Force update every 5 seconds
-    if (isForceSync()) {
-        needsUpdate = true;
-        lastTemp = (int)current.temperature;
-        lastTDS = current.tdsValue;
-        lastFlow = current.flowRate;
-        lastSyncMs = millis();
-    }
+    sendTemperature(data);
+    sendTDS(data);
+    sendFlow(data);
+}
+
+// ===== BUS CALLBACKS =====
+
+bool SensorDisplayManager::isSyncNeeded(void* context, const SensorData& data) {
+    SensorDisplayManager* self = static_cast<SensorDisplayManager*>(context);
     
-    unlock();
+    self->lock();
+    bool changed = self->isTemperatureChanged(data.temperature) ||
+                   self->isTDSChanged(data.tdsValue) ||
+                   self->isFlowChanged(data.flowRate);
+    self->unlock();
     
-    // Send to Nextion if update needed
-    if (needsUpdate) {
-        sendTemperature();
-        sendTDS();
-        sendFlow();
-    }
+    return changed;
+}
+
+void SensorDisplayManager::onSensorData(void* context, const SensorData& data) {
+    static_cast<SensorDisplayManager*>(context)->syncToNextion(data);
 }
 
 // ===== INDIVIDUAL SENDERS =====
 
-void SensorDisplayManager::sendTemperature() {
-    if (!sensorPtr || !nextionPtr) return;
-    
-    SensorData data = sensorPtr->getData();
+void SensorDisplayManager::sendTemperature(const SensorData& data) {
+    if (!nextionPtr) return;
     
     if (!data.tempValid) {
         nextionPtr->send("nTemp.val=0");  // ← CHANGED
@@ -105,14 +94,13 @@ void SensorDisplayManager::sendTemperature() {
     if (tempInt < -50) tempInt = -50;
     if (tempInt > 100) tempInt = 100;
     
-    String cmd = "nTemp.val=" + String(tempInt);  // ← CHANGED (from .txt to .val)
-    nextionPtr->send(cmd);
+    NextionCommand cmd;
+    cmd.format("nTemp.val=%d", tempInt);  // ← CHANGED (from .txt to .val)
+    nextionPtr->send(cmd.c_str());
 }
 
-void SensorDisplayManager::sendTDS() {
-    if (!sensorPtr || !nextionPtr) return;
-    
-    SensorData data = sensorPtr->getData();
+void SensorDisplayManager::sendTDS(const SensorData& data) {
+    if (!nextionPtr) return;
     
     if (!data.tdsValid) {
         nextionPtr->send("nTDS.val=0");  // ← CHANGED
@@ -124,20 +112,17 @@ void SensorDisplayManager::sendTDS() {
     if (tdsValue < 0) tdsValue = 0;
     if (tdsValue > 9999) tdsValue = 9999;
     
-    String cmd = "nTDS.val=" + String(tdsValue);  // ← CHANGED (from .txt to .val)
-    nextionPtr->send(cmd);
+    NextionCommand cmd;
+    cmd.format("nTDS.val=%d", tdsValue);  // ← CHANGED (from .txt to .val)
+    nextionPtr->send(cmd.c_str());
 }
 
-void SensorDisplayManager::sendFlow() {
-    if (!sensorPtr || !nextionPtr) return;
-    
-    SensorData data = sensorPtr->getData();
-    
-    char buffer[10];
-    snprintf(buffer, sizeof(buffer), "%.2f", data.flowRate);
+void SensorDisplayManager::sendFlow(const SensorData& data) {
+    if (!nextionPtr) return;
     
-    String cmd = "tFlow.txt=\"" + String(buffer) + "\"";  // ← SAMA (text component)
-    nextionPtr->send(cmd);
+    NextionCommand cmd;
+    cmd.format("tFlow.txt=\"%.2f\"", data.flowRate);  // ← SAMA (text component)
+    nextionPtr->send(cmd.c_str());
 }
 
 
@@ -162,7 +147,7 @@ void SensorDisplayManager::printLastSync() {
     Serial.print(lastFlow, 2);
     Serial.println(" L/min   ║");
     
-    unsigned long timeSinceSync = millis() - lastSyncMs;
+    unsigned long timeSinceSync = (unsigned long)(TimerService::nowMs() - lastSyncMs);
     Serial.print("║ Time since sync : ");
     Serial.print(timeSinceSync);
     Serial.println("ms    ║");
@@ -174,9 +159,7 @@ void SensorDisplayManager::printLastSync() {
 
 // ===== PRIVATE METHODS =====
 
-bool SensorDisplayManager::isSensorDataValid() {
-    SensorData data = sensorPtr->getData();
-    
+bool SensorDisplayManager::isSensorDataValid(const SensorData& data) {
     // At least one sensor should be valid or have meaningful data
     if (!data.tempValid && !data.tdsValid && data.flowRate < 0) {
         return false;
@@ -231,11 +214,6 @@ bool SensorDisplayManager::isFlowChanged(float currentFlow) {
     return false;
 }
 
-bool SensorDisplayManager::isForceSync() {
-    unsigned long elapsed = millis() - lastSyncMs;
-    return (elapsed >= FORCE_SYNC_MS);
-}
-
 // ===== MUTEX =====
 
 void SensorDisplayManager::lock() {
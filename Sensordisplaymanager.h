@@ -5,49 +5,57 @@
 #include "SensorManager.h"
 #include "NextionGateWay.h"
 
+struct EventBus;
+
 // ===== SENSOR DISPLAY MANAGER CLASS =====
+// Subscriber topic sensors: threshold di filter, force sync lewat maxSilenceMs.
+// Dipanggil di sensor task dengan referensi sampel - tanpa getData() sendiri.
 class SensorDisplayManager {
 public:
     SensorDisplayManager();
     ~SensorDisplayManager();
     
-    void begin(SensorManager* sensor, NextionGateWay* nextion);
+    void begin(EventBus* bus, NextionGateWay* nextion);
     
-    // Main update method - call dari task
-    void syncToNextion();
+    // Kirim sampel ke Nextion (handler bus)
+    void syncToNextion(const SensorData& data);
     
     // Individual component senders (optional)
-    void sendTemperature();
-    void sendTDS();
-    void sendFlow();
+    void sendTemperature(const SensorData& data);
+    void sendTDS(const SensorData& data);
+    void sendFlow(const SensorData& data);
     
     // Debug
     void printLastSync();
 
 private:
-    SensorManager* sensorPtr;
     NextionGateWay* nextionPtr;
     
     // Last synced data for change detection
     int lastTemp;
     int lastTDS;
     float lastFlow;
-    unsigned long lastSyncMs;
+    uint64_t lastSyncMs;      // TimerService::nowMs() saat sync terakhir
     
     SemaphoreHandle_t mutex;
+    StaticSemaphore_t mutexBuffer;
     
     // Change detection thresholds
     static constexpr int TEMP_THRESHOLD = 1;        // 1°C change
     static constexpr int TDS_THRESHOLD = 10;        // 10 ppm change
     static constexpr float FLOW_THRESHOLD = 0.5f;   // 0.5 L/min change
     static constexpr unsigned long FORCE_SYNC_MS = 5000;  // Force update every 5s
+    static constexpr unsigned long SYNC_MIN_INTERVAL_MS = 500;  // Rate limit UART
+    
+    // Bus callbacks (context = this)
+    static bool isSyncNeeded(void* context, const SensorData& data);
+    static void onSensorData(void* context, const SensorData& data);
     
     // Private methods
-    bool isSensorDataValid();
+    bool isSensorDataValid(const SensorData& data);
     bool isTemperatureChanged(int currentTemp);
     bool isTDSChanged(int currentTDS);
     bool isFlowChanged(float currentFlow);
-    bool isForceSync();
     
     void lock();
     void unlock();
@@ -0,0 +1,67 @@
+// SeqLock.h
+#ifndef SEQ_LOCK_H
+#define SEQ_LOCK_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// ===== SEQLOCK SNAPSHOT =====
+// Publikasi struct (trivially copyable) dari writer ke banyak reader tanpa
+// mutex di sisi reader:
+//   publish(): sequence ganjil → copy → sequence genap (versi baru)
+//   read()   : copy, ulangi jika sequence ganjil atau berubah selama copy
+//
+// Copy writer dijalankan di critical section (portMUX): di core yang sama
+// reader tidak pernah melihat sequence ganjil (tidak bisa preempt writer),
+// dari core lain hanya spin selama memcpy ~1 µs. Spinlock yang sama juga
+// men-serialisasi writer dari beberapa task. Reader tidak pernah memblok writer.
+//
+// Versi (sequence / 2) naik tiap publish: consumer bisa skip kerja jika
+// versinya sama dengan yang terakhir diproses. Versi 0 = belum pernah publish.
+template <typename T>
+class SeqLock {
+public:
+    SeqLock() : sequence(0), value() {
+        portMUX_INITIALIZE(&writeMux);
+    }
+
+    void publish(const T& next) {
+        portENTER_CRITICAL(&writeMux);
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        value = next;
+        sequence.store(seq + 2, std::memory_order_release);
+        portEXIT_CRITICAL(&writeMux);
+    }
+
+    // Snapshot koheren ke out, return versinya
+    uint32_t read(T& out) const {
+        uint32_t before;
+        uint32_t after;
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            out = value;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+        return before >> 1;
+    }
+
+    T read() const {
+        T out;
+        read(out);
+        return out;
+    }
+
+    uint32_t version() const {
+        return sequence.load(std::memory_order_acquire) >> 1;
+    }
+
+private:
+    std::atomic<uint32_t> sequence;
+    T value;
+    portMUX_TYPE writeMux;
+};
+
+#endif
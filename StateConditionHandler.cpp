@@ -1,8 +1,6 @@
 // StateConditionHandler.cpp - UPDATED VERSION
 #include "StateConditionHandler.h"
-
-// ===== CONSTANTS =====
-static const unsigned long COOLING_WAIT_PERIOD = 10 * 60 * 1000; // 10 menit dalam ms
+#include "Logger.h"
 
 // ===== CONSTRUCTOR / DESTRUCTOR =====
 
@@ -14,29 +12,61 @@ StateConditionHandler::StateConditionHandler(
     : sensor(sensors)
     , actuator(actuators)
     , nextion(display)
+    , flowCalibration(nullptr)
     , coolingTarget(0)
-    , coolingStartTime(0)
-    , compressorOffTime(0)
-    , compressorActive(false)
-    , inWaitPeriod(false)
+    , coolingStartMs(0)
+    , compressor(actuators)
+    , coolingEstimator()
+    , shownEta()
+    , coolingTargetReached(false)
     , lastFlowState(false)
-    , lastFloatState(false)
-    , floatTrueStartTime(0)
+    , fillCompleted(false)
+    , fill(sensors)
+    , fullEdgeLiters(0)
     , drainingFlowThreshold(DRAINING_FLOW_THRESHOLD)
-    , drainingLowFlowStartTime(0)
-    , drainingLowFlowDetected(false)
+    , drainStartPulses(0)
+    , drainStartLiters(0)
+    , drainExpectedLiters(0)
+    , drainStartMs(0)
+    , drainCompleted(false)
 {
-    Serial.println("[StateConditionHandler] Initialized");
+    TimerService::initFlag(coolingDisplayTimer);
+    TimerService::initFlag(etaSampleTimer);
+    TimerService::initFlag(floatDebounceTimer);
+    TimerService::initFlag(drainingLowFlowTimer);
+    
+    LOG_I("StateConditionHandler", "Initialized");
 }
 
 StateConditionHandler::~StateConditionHandler() {
-    // Cleanup
+    timerService.cancel(coolingDisplayTimer);
+    timerService.cancel(etaSampleTimer);
+    timerService.cancel(floatDebounceTimer);
+    timerService.cancel(drainingLowFlowTimer);
+}
+
+void StateConditionHandler::setEventQueue(QueueHandle_t queue) {
+    // Semua timeout membangunkan FSM supaya check berikutnya langsung jalan
+    TimerService::initEvent(coolingDisplayTimer, queue, FsmEvent::EV_DEADLINE);
+    TimerService::initEvent(etaSampleTimer, queue, FsmEvent::EV_DEADLINE);
+    TimerService::initEvent(floatDebounceTimer, queue, FsmEvent::EV_DEADLINE);
+    TimerService::initEvent(drainingLowFlowTimer, queue, FsmEvent::EV_DEADLINE);
+    compressor.setEventQueue(queue);
+    fill.setEventQueue(queue);
+}
+
+void StateConditionHandler::setFlowCalibration(FlowCalibration* calibration) {
+    flowCalibration = calibration;
 }
 
 // ===== FILLING METHODS =====
 
-void StateConditionHandler::startFilling() {
-    Serial.println("[FILLING] Starting filling sequence");
+void StateConditionHandler::startFilling(float targetLiters) {
+    LOG_I("FILLING", "Starting filling sequence");
+    
+    // Mulai hitung pulse sebelum valve buka
+    fill.start(targetLiters);
+    fillCompleted = false;
     
     // Open inlet valve
     actuator->setValveInlet(true);
@@ -48,9 +78,8 @@ void StateConditionHandler::startFilling() {
     lastFlowState = sensor->getFlowSwitch();
     
     // Reset float sensor debounce
-    lastFloatState = false;
-    floatTrueStartTime = 0;
-    Serial.println("[FILLING] Float sensor debounce reset");
+    timerService.cancel(floatDebounceTimer);
+    LOG_D("FILLING", "Float sensor debounce reset");
 }
 
 FillingStatus StateConditionHandler::checkFillingCondition() {
@@ -62,53 +91,48 @@ FillingStatus StateConditionHandler::checkFillingCondition() {
     
     if (!valveOpen) {
         // Valve closed - stop processing float sensor
-        if (lastFloatState || floatTrueStartTime != 0) {
-            lastFloatState = false;
-            floatTrueStartTime = 0;
-            Serial.println("[FILLING] Valve closed - Float sensor tracking RESET");
+        if (timerService.isArmed(floatDebounceTimer) || timerService.hasExpired(floatDebounceTimer)) {
+            timerService.cancel(floatDebounceTimer);
+            LOG_D("FILLING", "Valve closed - Float sensor tracking RESET");
         }
         return FillingStatus::FILLING_CONTINUE;
     }
     
+    // ===== PREDICTIVE ENDPOINT =====
+    // Tutup sebelum volume target; float di bawah tetap backstop
+    if (fill.shouldClose(data)) {
+        fillCompleted = true;
+        return FillingStatus::FILLING_COMPLETE;
+    }
+    
     // ===== FLOAT SENSOR DEBOUNCING =====
     if (data.floatSensor) {
         // Float sensor TRUE
-        if (!lastFloatState) {
-            // Baru pertama kali TRUE - mulai tracking
-            floatTrueStartTime = millis();
-            lastFloatState = true;
-            Serial.println("[FILLING] Float sensor rising edge - Starting debounce");
-        } else {
-            // Sudah TRUE sebelumnya - cek durasi
-            unsigned long floatTrueDuration = millis() - floatTrueStartTime;
+        if (timerService.hasExpired(floatDebounceTimer)) {
+            // Sudah stabil selama 2 detik - VALID!
+            LOG_I("FILLING", "Float sensor STABLE for %lums - COMPLETE", FLOAT_DEBOUNCE_MS);
             
-            if (floatTrueDuration >= FLOAT_DEBOUNCE_MS) {
-                // Sudah stabil selama 2 detik - VALID!
-                Serial.print("[FILLING] Float sensor STABLE for ");
-                Serial.print(floatTrueDuration);
-                Serial.println("ms - COMPLETE");
-                
-                // Reset tracking untuk consistency
-                lastFloatState = false;
-                floatTrueStartTime = 0;
-                
-                return FillingStatus::FILLING_COMPLETE;
-            } else {
-                // Masih dalam debounce period
-                Serial.print("[FILLING] Float sensor debouncing... ");
-                Serial.print(floatTrueDuration);
-                Serial.print("/");
-                Serial.print(FLOAT_DEBOUNCE_MS);
-                Serial.println("ms");
-            }
+            // Reset tracking untuk consistency
+            timerService.cancel(floatDebounceTimer);
+            
+            fillCompleted = true;
+            return FillingStatus::FILLING_COMPLETE;
+        } else if (!timerService.isArmed(floatDebounceTimer)) {
+            // Baru pertama kali TRUE - mulai tracking (expire → EV_DEADLINE)
+            timerService.arm(floatDebounceTimer, FLOAT_DEBOUNCE_MS);
+            fill.onFloatEdge();
+            LOG_I("FILLING", "Float sensor rising edge - Starting debounce");
+        } else {
+            // Masih dalam debounce period
+            LOG_D("FILLING", "Float sensor debouncing... %lums left",
+                  (unsigned long)timerService.remainingMs(floatDebounceTimer));
         }
     } else {
         // Float sensor FALSE - reset debounce
-        if (lastFloatState) {
-            Serial.println("[FILLING] Float sensor falling edge - Reset debounce");
+        if (timerService.isArmed(floatDebounceTimer) || timerService.hasExpired(floatDebounceTimer)) {
+            LOG_I("FILLING", "Float sensor falling edge - Reset debounce");
         }
-        lastFloatState = false;
-        floatTrueStartTime = 0;
+        timerService.cancel(floatDebounceTimer);
     }
     
     // ===== FLOW ERROR CHECK =====
@@ -118,7 +142,7 @@ FillingStatus StateConditionHandler::checkFillingCondition() {
     if (valveOpen && !data.flowSwitch) {
         // Valve terbuka tapi tidak ada flow - ERROR
         if (lastFlowState != data.flowSwitch) {
-            Serial.println("[FILLING] Flow switch error - NO FLOW DETECTED");
+            LOG_W("FILLING", "Flow switch error - NO FLOW DETECTED");
             nextion->setErrorBlink(true);
         }
         lastFlowState = data.flowSwitch;
@@ -129,7 +153,7 @@ FillingStatus StateConditionHandler::checkFillingCondition() {
     // Clear error blink jika flow kembali normal
     if (!lastFlowState && data.flowSwitch) {
         nextion->setErrorBlink(false);
-        Serial.println("[FILLING] Flow restored");
+        LOG_I("FILLING", "Flow restored");
     }
     
     lastFlowState = data.flowSwitch;
@@ -137,120 +161,158 @@ FillingStatus StateConditionHandler::checkFillingCondition() {
 }
 
 void StateConditionHandler::stopFilling() {
-    Serial.println("[FILLING] Stopping filling sequence");
+    LOG_I("FILLING", "Stopping filling sequence");
     
     // Close inlet valve
     actuator->setValveInlet(false);
+    fill.finish(fillCompleted);
+    fillCompleted = false;
+    
+    // Kosong → float = kapasitas tangki yang diketahui
+    uint32_t edgePulses, edgeMs;
+    float edgeLiters;
+    fullEdgeLiters = 0;
+    if (fill.getFloatEdgeSample(edgePulses, edgeLiters, edgeMs)) {
+        fullEdgeLiters = edgeLiters;
+        if (flowCalibration) flowCalibration->observeFill(edgePulses, edgeMs);
+    }
     
     // ===== FIX: Reset float sensor tracking completely =====
     // Ini penting untuk mencegah bounce data tertinggal
-    lastFloatState = false;
-    floatTrueStartTime = 0;
-    Serial.println("[FILLING] Float sensor tracking RESET after stop");
+    timerService.cancel(floatDebounceTimer);
+    LOG_D("FILLING", "Float sensor tracking RESET after stop");
     
     // JANGAN clear error blink di sini
     // Biarkan ERROR state atau IDLE state yang handle
 }
 
+FillReport StateConditionHandler::getLastFillReport() {
+    return fill.getLastReport();
+}
+
+float StateConditionHandler::getTankLiters() {
+    float liters = fill.getTankLiters();
+    if (liters > 0) return liters;
+    return flowCalibration ? flowCalibration->getCapacityLiters() : 0;
+}
+
 // ===== COOLING METHODS =====
 
 void StateConditionHandler::startCooling(uint8_t targetTemp) {
-    Serial.print("[COOLING] Starting cooling - Target: ");
-    Serial.print(targetTemp);
-    Serial.println("°C");
+    LOG_I("COOLING", "Starting cooling - Target: %u°C", targetTemp);
     
     coolingTarget = targetTemp;
-    coolingStartTime = millis();
-    compressorOffTime = 0;
-    compressorActive = true;
-    inWaitPeriod = false;
+    coolingStartMs = TimerService::nowMs();
     
-    // Start compressor & pump
-    actuator->setCompressor(true);
+    // Flow sensor ada di loop sirkulasi: sisa pulse fill diukur sebelum pump jalan
+    fill.settleNow();
+    
+    // Pump jalan terus; compressor diputuskan controller (min-off tetap dihormati)
     actuator->setPumpUV(true);
+    compressor.start(targetTemp);
+    compressor.update(sensor->getData());
     
-    // Update display
+    // Update display (lalu setiap menit lewat timer)
     updateCoolingDisplay();
+    timerService.armPeriodic(coolingDisplayTimer, 60000);
+    
+    // ETA mulai dari nol; "--" sampai model cukup data
+    coolingEstimator.reset(targetTemp);
+    coolingTargetReached = false;
+    shownEta.valid = false;
+    nextion->updateCoolingEta(false, 0, 0);
+    timerService.armPeriodic(etaSampleTimer, ETA_SAMPLE_MS);
 }
 
 void StateConditionHandler::updateCooling() {
-    SensorData data = sensor->getData();
-    
-    // Update display setiap call (akan di-throttle oleh Nextion jika terlalu cepat)
-    updateCoolingDisplay();
-    
-    // ===== STATE 1: COMPRESSOR ACTIVE (Cooling down) =====
-    if (compressorActive && !inWaitPeriod) {
-        if (data.temperature <= coolingTarget) {
-            // Target tercapai - matikan compressor
-            Serial.print("[COOLING] Target reached (");
-            Serial.print(data.temperature);
-            Serial.println("°C) - Compressor OFF");
-            
-            actuator->setCompressor(false);
-            compressorActive = false;
-            compressorOffTime = millis();
-            inWaitPeriod = true;
-            
-            // Pump tetap jalan (tidak dimatikan)
-        }
+    // Durasi di Nextion hanya berubah tiap menit
+    if (timerService.consumeExpired(coolingDisplayTimer)) {
+        updateCoolingDisplay();
     }
     
-    // ===== STATE 2: WAITING PERIOD (10 menit) =====
-    else if (inWaitPeriod) {
-        unsigned long elapsedWait = millis() - compressorOffTime;
-        
-        if (elapsedWait >= COOLING_WAIT_PERIOD) {
-            // 10 menit sudah lewat - cek temperature
-            Serial.println("[COOLING] Wait period complete - Checking temperature");
-            
-            if (data.temperature > coolingTarget) {
-                // Temperature naik lagi - restart compressor
-                Serial.print("[COOLING] Temperature rose to ");
-                Serial.print(data.temperature);
-                Serial.println("°C - Restarting compressor");
-                
-                actuator->setCompressor(true);
-                compressorActive = true;
-                inWaitPeriod = false;
-            } else {
-                // Masih di bawah target - reset timer, tunggu lagi
-                Serial.println("[COOLING] Temperature still OK - Continue waiting");
-                compressorOffTime = millis();
-            }
-        }
-    }
+    SensorData data = sensor->getData();
+    compressor.update(data);
+    updateCoolingEta(data);
 }
 
 void StateConditionHandler::stopCooling() {
-    Serial.println("[COOLING] Stopping cooling sequence");
+    LOG_I("COOLING", "Stopping cooling sequence");
     
     // Matikan compressor & pump
-    actuator->setCompressor(false);
+    compressor.stop();
     actuator->setPumpUV(false);
     
-    // Reset state
-    compressorActive = false;
-    inWaitPeriod = false;
+    timerService.cancel(coolingDisplayTimer);
+    timerService.cancel(etaSampleTimer);
+    compressor.printMetrics();
+}
+
+CompressorMetrics StateConditionHandler::getCompressorMetrics() {
+    return compressor.getMetrics();
+}
+
+CoolingEta StateConditionHandler::getCoolingEta() const {
+    return shownEta;
 }
 
 void StateConditionHandler::updateCoolingDisplay() {
-    uint16_t elapsedMinutes = getElapsedMinutes(coolingStartTime);
+    uint16_t elapsedMinutes = getElapsedMinutes(coolingStartMs);
     nextion->updateCoolingDuration(elapsedMinutes);
 }
 
+void StateConditionHandler::updateCoolingEta(const SensorData& data) {
+    if (!timerService.consumeExpired(etaSampleTimer)) return;
+
+    if (data.tempValid && data.temperature <= coolingTarget) {
+        coolingTargetReached = true;
+    }
+
+    CoolingEta eta;
+    if (coolingTargetReached) {
+        // Fase hold: siklus compressor bukan kurva pendinginan, ETA tetap 0
+        eta.valid = true;
+        eta.minutes = 0;
+        eta.marginMinutes = 0;
+        eta.asymptoteC = shownEta.asymptoteC;
+    } else {
+        // Fit hanya dari pendinginan kontinu; OFF (min-off / sensor invalid) memutus deret
+        if (data.tempValid && compressor.isCompressorOn()) {
+            coolingEstimator.addSample(data.temperature);
+        } else {
+            coolingEstimator.breakSequence();
+        }
+        eta = coolingEstimator.getEstimate();
+    }
+
+    // Kirim hanya jika angka yang tampil berubah
+    if (eta.valid != shownEta.valid || eta.minutes != shownEta.minutes ||
+        eta.marginMinutes != shownEta.marginMinutes) {
+        nextion->updateCoolingEta(eta.valid, eta.minutes, eta.marginMinutes);
+    }
+    shownEta = eta;
+}
+
 // ===== DRAINING METHODS =====
 
 void StateConditionHandler::startDraining() {
-    Serial.println("[DRAINING] Starting draining sequence");
+    LOG_I("DRAINING", "Starting draining sequence");
+    
+    // Neraca: isi tangki dari fill sejak drain terakhir
+    drainExpectedLiters = fill.getTankLiters();
+    drainStartPulses = sensor->getPulseCount();
+    drainStartLiters = sensor->getLiters();
+    drainStartMs = TimerService::nowMs();
+    drainCompleted = false;
+    if (drainExpectedLiters > 0) {
+        LOG_I("DRAINING", "Expecting %.1f L out", drainExpectedLiters);
+    }
     
     // Open drain valve
     actuator->setValveDrain(true);
     
     // ===== FIX: Reset draining state tracking =====
-    drainingLowFlowStartTime = 0;
-    drainingLowFlowDetected = false;
-    Serial.println("[DRAINING] Low flow detection reset");
+    timerService.cancel(drainingLowFlowTimer);
+    LOG_D("DRAINING", "Low flow detection reset");
 }
 
 DrainingStatus StateConditionHandler::checkDrainingCondition() {
@@ -261,61 +323,53 @@ DrainingStatus StateConditionHandler::checkDrainingCondition() {
     
     if (!valveOpen) {
         // Valve closed - stop processing
-        drainingLowFlowStartTime = 0;
-        drainingLowFlowDetected = false;
+        timerService.cancel(drainingLowFlowTimer);
         return DrainingStatus::DRAINING_CONTINUE;
     }
     
-    // ===== FIX: LOW FLOW DETECTION (5 detik) =====
+    // ===== VOLUME BALANCE =====
+    // Isi tangki hampir habis menurut neraca → threshold longgar + konfirmasi singkat
+    // Liter (kurva K per flow): fill dan drain mengalir di flow berbeda
+    float drainedLiters = static_cast<float>(sensor->getLiters() - drainStartLiters);
+    bool balanced = drainExpectedLiters > 0 &&
+                    drainedLiters >= drainExpectedLiters * DRAINING_BALANCE_RATIO;
+    float threshold = balanced ? DRAINING_TRICKLE_THRESHOLD : drainingFlowThreshold;
+    unsigned long confirmMs = balanced ? DRAINING_BALANCED_CONFIRM_MS : DRAINING_LOW_FLOW_TIMEOUT_MS;
+    
+    // ===== FIX: LOW FLOW DETECTION (5 detik, 1 detik jika neraca seimbang) =====
     // Check apakah flow rate <= threshold (0.1 L/min)
     
-    if (data.flowRate <= drainingFlowThreshold) {
+    if (data.flowRate <= threshold) {
         // Flow sudah <= threshold
         
-        if (!drainingLowFlowDetected) {
-            // Baru pertama kali <= threshold - mulai tracking
-            drainingLowFlowStartTime = millis();
-            drainingLowFlowDetected = true;
-            Serial.print("[DRAINING] Flow rate <= ");
-            Serial.print(drainingFlowThreshold);
-            Serial.println(" L/min - Starting low flow timeout");
-        } else {
-            // Sudah <= threshold sebelumnya - cek durasi
-            unsigned long lowFlowDuration = millis() - drainingLowFlowStartTime;
+        if (timerService.hasExpired(drainingLowFlowTimer)) {
+            // Sudah <= threshold selama waktu konfirmasi - SELESAI!
+            LOG_I("DRAINING", "Flow rate stable at %.2f L/min for %lums%s - COMPLETE",
+                  data.flowRate, confirmMs, balanced ? " (volume balanced)" : "");
+            
+            // Reset tracking
+            timerService.cancel(drainingLowFlowTimer);
             
-            if (lowFlowDuration >= DRAINING_LOW_FLOW_TIMEOUT_MS) {
-                // Sudah <= threshold selama 5 detik - SELESAI!
-                Serial.print("[DRAINING] Flow rate stable at ");
-                Serial.print(data.flowRate);
-                Serial.print(" L/min for ");
-                Serial.print(lowFlowDuration);
-                Serial.println("ms - COMPLETE");
-                
-                // Reset tracking
-                drainingLowFlowStartTime = 0;
-                drainingLowFlowDetected = false;
-                
-                return DrainingStatus::DRAINING_COMPLETE;
-            } else {
-                // Masih dalam timeout period
-                Serial.print("[DRAINING] Low flow timeout... ");
-                Serial.print(lowFlowDuration);
-                Serial.print("/");
-                Serial.print(DRAINING_LOW_FLOW_TIMEOUT_MS);
-                Serial.print("ms (flowRate: ");
-                Serial.print(data.flowRate);
-                Serial.println(" L/min)");
-            }
+            drainCompleted = true;
+            return DrainingStatus::DRAINING_COMPLETE;
+        } else if (!timerService.isArmed(drainingLowFlowTimer)) {
+            // Baru pertama kali <= threshold - mulai tracking (expire → EV_DEADLINE)
+            timerService.arm(drainingLowFlowTimer, confirmMs);
+            LOG_I("DRAINING", "Flow rate <= %.2f L/min - Starting low flow timeout", threshold);
+        } else if (timerService.remainingMs(drainingLowFlowTimer) > confirmMs) {
+            // Neraca baru seimbang saat timeout 5 detik berjalan → persingkat
+            timerService.arm(drainingLowFlowTimer, confirmMs);
+        } else {
+            // Masih dalam timeout period
+            LOG_D("DRAINING", "Low flow timeout... %lums left (flowRate: %.2f L/min)",
+                  (unsigned long)timerService.remainingMs(drainingLowFlowTimer), data.flowRate);
         }
     } else {
         // Flow naik kembali > threshold - reset timeout
-        if (drainingLowFlowDetected) {
-            Serial.print("[DRAINING] Flow rate increased to ");
-            Serial.print(data.flowRate);
-            Serial.println(" L/min - Reset timeout");
+        if (timerService.isArmed(drainingLowFlowTimer) || timerService.hasExpired(drainingLowFlowTimer)) {
+            LOG_I("DRAINING", "Flow rate increased to %.2f L/min - Reset timeout", data.flowRate);
         }
-        drainingLowFlowDetected = false;
-        drainingLowFlowStartTime = 0;
+        timerService.cancel(drainingLowFlowTimer);
     }
     
     // Continue draining
@@ -323,15 +377,38 @@ DrainingStatus StateConditionHandler::checkDrainingCondition() {
 }
 
 void StateConditionHandler::stopDraining() {
-    Serial.println("[DRAINING] Stopping draining sequence");
+    LOG_I("DRAINING", "Stopping draining sequence");
     
     // Close drain valve
     actuator->setValveDrain(false);
     
+    // Neraca tangki: selesai = kosong; dibatalkan = kurangi yang sudah keluar
+    uint32_t drainedPulses = sensor->getPulseCount() - drainStartPulses;
+    float drainedLiters = static_cast<float>(sensor->getLiters() - drainStartLiters);
+    if (drainCompleted) {
+        unsigned long seconds = static_cast<unsigned long>((TimerService::nowMs() - drainStartMs) / 1000);
+        if (drainExpectedLiters > 0) {
+            LOG_I("DRAINING", "Drained %.1f L in %lus, residual estimate %+.1f L",
+                  drainedLiters, seconds, drainExpectedLiters - drainedLiters);
+        } else {
+            LOG_I("DRAINING", "Drained %.1f L in %lus (tank volume unknown)", drainedLiters, seconds);
+        }
+        
+        // Penuh (float) → kosong: titik kalibrasi di flow drain (pulse mentah)
+        if (flowCalibration && fullEdgeLiters > 0 && drainExpectedLiters >= fullEdgeLiters) {
+            flowCalibration->observeDrain(drainedPulses, drainExpectedLiters - fullEdgeLiters,
+                                          static_cast<uint32_t>(TimerService::nowMs() - drainStartMs));
+        }
+        fill.markEmpty();
+    } else {
+        fill.removeVolume(drainedLiters);
+    }
+    drainCompleted = false;
+    fullEdgeLiters = 0;
+    
     // ===== FIX: Reset draining state tracking =====
-    drainingLowFlowStartTime = 0;
-    drainingLowFlowDetected = false;
-    Serial.println("[DRAINING] Draining state RESET after stop");
+    timerService.cancel(drainingLowFlowTimer);
+    LOG_D("DRAINING", "Draining state RESET after stop");
 }
 
 // ===== ERROR RECOVERY =====
@@ -341,7 +418,7 @@ bool StateConditionHandler::isErrorCleared() {
     
     // Error cleared jika flow switch kembali normal
     if (data.flowSwitch) {
-        Serial.println("[ERROR] Flow restored - Error cleared");
+        LOG_I("ERROR", "Flow restored - Error cleared");
         return true;
     }
     
@@ -350,7 +427,7 @@ bool StateConditionHandler::isErrorCleared() {
 
 // ===== HELPER METHODS =====
 
-uint16_t StateConditionHandler::getElapsedMinutes(unsigned long startTime) {
-    unsigned long elapsed = millis() - startTime;
+uint16_t StateConditionHandler::getElapsedMinutes(uint64_t startMs) {
+    uint64_t elapsed = TimerService::nowMs() - startMs;
     return elapsed / 60000;  // Convert ms to minutes
 }
\ No newline at end of file
@@ -6,12 +6,17 @@
 #include "SensorManager.h"
 #include "ActuatorControl.h"
 #include "NextionOutput.h"
+#include "TimerService.h"
+#include "CompressorController.h"
+#include "CoolingEstimator.h"
+#include "FillController.h"
+#include "FlowCalibration.h"
 
 // ===== CONDITION STATUS ENUMS =====
 
 enum class FillingStatus : uint8_t {
     FILLING_CONTINUE = 0,    // Continue filling
-    FILLING_COMPLETE,        // Float sensor triggered (penuh)
+    FILLING_COMPLETE,        // Float sensor triggered / endpoint volume tercapai
     FILLING_ERROR            // Flow switch error (tidak ada aliran)
 };
 
@@ -30,15 +35,28 @@ public:
     );
     ~StateConditionHandler();
     
+    // Timer debounce/timeout mem-post EV_DEADLINE ke queue ini saat expire
+    void setEventQueue(QueueHandle_t queue);
+    
+    // Titik kalibrasi K-factor dari fill kosong → float dan drain penuh → kosong
+    void setFlowCalibration(FlowCalibration* calibration);
+    
     // ===== FILLING =====
     FillingStatus checkFillingCondition();
-    void startFilling();
+    void startFilling(float targetLiters = 0);  // 0 = float switch (+ volume belajar jika tangki kosong)
     void stopFilling();
+    FillReport getLastFillReport();
+    bool isFillFromEmpty() const { return fill.isFromEmpty(); }
+    float getTankLiters();                      // Neraca fill/drain, fallback kapasitas kalibrasi (0 = tidak diketahui)
     
     // ===== COOLING =====
     void startCooling(uint8_t targetTemp);
     void updateCooling();  // Dipanggil berkala dari FSM update loop
     void stopCooling();
+    CompressorMetrics getCompressorMetrics();
+    bool getCompressorOffAgeMs(uint32_t& ageMs) const { return compressor.getOffAgeMs(ageMs); }
+    void restoreCompressorOffAge(uint32_t ageMs) { compressor.restoreOffAge(ageMs); }
+    CoolingEta getCoolingEta() const;
     
     // ===== DRAINING =====
     DrainingStatus checkDrainingCondition();
@@ -53,31 +71,46 @@ private:
     SensorManager* sensor;
     ActuatorControl* actuator;
     NextionOutput* nextion;
+    FlowCalibration* flowCalibration;
     
     // ===== COOLING STATE =====
     uint8_t coolingTarget;              // Target temperature (°C)
-    unsigned long coolingStartTime;     // Waktu mulai cooling (ms)
-    unsigned long compressorOffTime;    // Waktu saat compressor OFF (ms)
-    bool compressorActive;              // Status compressor
-    bool inWaitPeriod;                  // Sedang dalam periode tunggu 10 menit
+    uint64_t coolingStartMs;            // Waktu mulai cooling (TimerService::nowMs)
+    Timer coolingDisplayTimer;          // Refresh durasi cooling tiap menit
+    CompressorController compressor;    // ON/OFF prediktif + min-off time
+    CoolingEstimator coolingEstimator;  // ETA ke target (fit eksponensial)
+    Timer etaSampleTimer;               // Periodic ETA_SAMPLE_MS
+    CoolingEta shownEta;                // Terakhir dikirim ke Nextion
+    bool coolingTargetReached;          // Latch: setelah target, ETA = 0 (fase hold)
     
     // ===== FILLING STATE =====
     bool lastFlowState;                 // State flow switch sebelumnya
-    bool lastFloatState;                // State float sensor sebelumnya
-    unsigned long floatTrueStartTime;   // Waktu pertama float jadi TRUE
+    bool fillCompleted;                 // checkFillingCondition sudah return COMPLETE
+    FillController fill;                // Integrasi volume + endpoint prediktif
+    float fullEdgeLiters;               // Isi tangki = satu fill kosong → float (+ overfill); 0 = tidak
+    Timer floatDebounceTimer;           // Armed = float TRUE sedang di-debounce
     static const unsigned long FLOAT_DEBOUNCE_MS = 2000;  // 2 detik debounce
     
     // ===== DRAINING STATE =====
     // ✅ FIX: Tambah state tracking untuk draining
     float drainingFlowThreshold;        // Target flow rate threshold (L/min)
-    unsigned long drainingLowFlowStartTime;  // Waktu flow mulai <= threshold
-    bool drainingLowFlowDetected;       // Apakah flow sudah <= threshold
+    Timer drainingLowFlowTimer;         // Armed = flow <= threshold, menunggu timeout
+    uint32_t drainStartPulses;          // Counter pulse mentah saat valve drain dibuka (kalibrasi)
+    double drainStartLiters;            // SensorManager::getLiters() saat valve drain dibuka
+    float drainExpectedLiters;          // Isi tangki menurut neraca (0 = tidak diketahui)
+    uint64_t drainStartMs;
+    bool drainCompleted;                // checkDrainingCondition sudah return COMPLETE
     static constexpr unsigned long DRAINING_LOW_FLOW_TIMEOUT_MS = 5000;  // 5 detik
     static constexpr float DRAINING_FLOW_THRESHOLD = 0.1f;  // 0.1 L/min
+    // Neraca volume: keluar >= 95% isi → cukup konfirmasi singkat, trickle juga dianggap selesai
+    static constexpr float DRAINING_BALANCE_RATIO = 0.95f;
+    static constexpr float DRAINING_TRICKLE_THRESHOLD = 0.5f;     // L/min
+    static constexpr unsigned long DRAINING_BALANCED_CONFIRM_MS = 1000;
     
     // ===== HELPER METHODS =====
     void updateCoolingDisplay();
-    uint16_t getElapsedMinutes(unsigned long startTime);
+    void updateCoolingEta(const SensorData& data);
+    uint16_t getElapsedMinutes(uint64_t startMs);
 };
 
 #endif
\ No newline at end of file
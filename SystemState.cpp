@@ -4,6 +4,12 @@
 #include "NextionOutput.h"
 #include "SensorManager.h"
 #include "ActuatorControl.h"
+#include "AutoCycle.h"
+#include "Checkpoint.h"
+#include "EventBus.h"
+#include "Logger.h"
+
+std::atomic<uint32_t> fsmDroppedEvents(0);
 
 // ===== STATE NAME TABLE =====
 static const char* STATE_NAMES[] = {
@@ -17,6 +23,97 @@ static const char* STATE_NAMES[] = {
     "ERROR"
 };
 
+// ===== TRANSITION TABLE =====
+// Urutan baris = prioritas. Untuk EV_UI_CHANGED urutannya sama dengan prioritas
+// lama: Bypass > Error recovery > Auto > Filling > Cooling > Draining > Idle.
+
+#define S(name) SystemState::STATE_##name
+#define E(name) FsmEvent::EV_##name
+#define G(name) &SystemStateMachine::guard##name
+#define A(name) &SystemStateMachine::action##name
+
+constexpr FsmTransition SystemStateMachine::TRANSITIONS[] = {
+    // from            event               guard                          action                       to
+    // ----- Priority 0: Bypass menu override semua -----
+    { FSM_ANY_STATE,   E(UI_CHANGED),      G(UiBypass),                   nullptr,                     S(BYPASS_MENU) },
+
+    // ----- Priority 1: Error recovery (error hilang > tombol FILLING OFF, seperti baseline) -----
+    { S(ERROR),        E(UI_CHANGED),      G(ErrorClearedFromFilling),    A(ErrorRecoveredToFilling),  S(FILLING) },
+    { S(ERROR),        E(UI_CHANGED),      G(ErrorCleared),               nullptr,                     S(IDLE) },
+    { S(ERROR),        E(UI_CHANGED),      G(UiFillingOffAfterFillError), A(ErrorExitByUser),          S(IDLE) },
+    { S(ERROR),        E(UI_CHANGED),      nullptr,                       nullptr,                     S(ERROR) },
+    { S(ERROR),        E(ERROR_CLEARED),   G(ErrorFromFilling),           A(ErrorRecoveredToFilling),  S(FILLING) },
+    { S(ERROR),        E(ERROR_CLEARED),   nullptr,                       nullptr,                     S(IDLE) },
+
+    // ----- Priority 2: Auto mode (dengan sub-state circulation) -----
+    { FSM_ANY_STATE,   E(UI_CHANGED),      G(UiAutoCirculation),          nullptr,                     S(AUTO_CIRCULATION) },
+    { FSM_ANY_STATE,   E(UI_CHANGED),      G(UiAuto),                     nullptr,                     S(AUTO) },
+
+    // ----- Priority 3: Manual operations -----
+    { FSM_ANY_STATE,   E(UI_CHANGED),      G(UiFillingIgnored),           A(IgnoreFillingOn),          S(IDLE) },
+    { FSM_ANY_STATE,   E(UI_CHANGED),      G(UiFilling),                  nullptr,                     S(FILLING) },
+    { FSM_ANY_STATE,   E(UI_CHANGED),      G(UiCooling),                  nullptr,                     S(COOLING) },
+    { FSM_ANY_STATE,   E(UI_CHANGED),      G(UiDrainingIgnored),          A(IgnoreDrainingOn),         S(IDLE) },
+    { FSM_ANY_STATE,   E(UI_CHANGED),      G(UiDraining),                 nullptr,                     S(DRAINING) },
+
+    // ----- Default: Idle (per state, supaya state baru wajib memilih fallback-nya) -----
+    { S(IDLE),         E(UI_CHANGED),      nullptr,                       nullptr,                     S(IDLE) },
+    { S(FILLING),      E(UI_CHANGED),      nullptr,                       nullptr,                     S(IDLE) },
+    { S(COOLING),      E(UI_CHANGED),      nullptr,                       nullptr,                     S(IDLE) },
+    { S(DRAINING),     E(UI_CHANGED),      nullptr,                       nullptr,                     S(IDLE) },
+    { S(AUTO),         E(UI_CHANGED),      nullptr,                       nullptr,                     S(IDLE) },
+    { S(AUTO_CIRCULATION), E(UI_CHANGED),  nullptr,                       nullptr,                     S(IDLE) },
+    { S(BYPASS_MENU),  E(UI_CHANGED),      nullptr,                       nullptr,                     S(IDLE) },
+
+    // ----- Auto-complete dari condition handler -----
+    { S(FILLING),      E(FILL_COMPLETE),   nullptr,                       A(FillingComplete),          S(IDLE) },
+    { S(FILLING),      E(FILL_FLOW_ERROR), nullptr,                       A(FillingFlowError),         S(ERROR) },
+    { S(DRAINING),     E(DRAIN_COMPLETE),  nullptr,                       A(DrainingComplete),         S(IDLE) },
+};
+
+constexpr uint8_t SystemStateMachine::TRANSITION_COUNT =
+    sizeof(SystemStateMachine::TRANSITIONS) / sizeof(SystemStateMachine::TRANSITIONS[0]);
+
+#define H(name) &SystemStateMachine::handle##name
+
+// Index = SystemState
+constexpr FsmStateHandlers SystemStateMachine::STATE_HANDLERS[] = {
+    // entry                      update                 exit
+    { H(IdleEntry),               nullptr,               nullptr },                     // IDLE
+    { H(FillingEntry),            H(FillingUpdate),      H(FillingExit) },              // FILLING
+    { H(CoolingEntry),            H(CoolingUpdate),      H(CoolingExit) },              // COOLING
+    { H(DrainingEntry),           H(DrainingUpdate),     H(DrainingExit) },             // DRAINING
+    { H(AutoEntry),               H(AutoUpdate),         H(AutoExit) },                 // AUTO
+    { H(AutoCirculationEntry),    H(AutoUpdate),         H(AutoCirculationExit) },      // AUTO_CIRCULATION
+    { H(BypassMenuEntry),         nullptr,               nullptr },                     // BYPASS_MENU
+    { H(ErrorEntry),              H(ErrorUpdate),        H(ErrorExit) },                // ERROR
+};
+
+#undef S
+#undef E
+#undef G
+#undef A
+#undef H
+
+void SystemStateMachine::validateTable() {
+    static_assert(TRANSITION_COUNT <= FSM_MAX_TRANSITIONS,
+                  "FSM_MAX_TRANSITIONS terlalu kecil");
+    static_assert(sizeof(STATE_HANDLERS) / sizeof(STATE_HANDLERS[0]) == FSM_STATE_COUNT,
+                  "STATE_HANDLERS harus punya satu baris per SystemState");
+    static_assert(rowsValid(TRANSITIONS, TRANSITION_COUNT),
+                  "Tabel transisi berisi state/event di luar range");
+    static_assert(reachable(TRANSITIONS, TRANSITION_COUNT,
+                            stateBit(SystemState::STATE_IDLE), FSM_STATE_COUNT) == allStatesMask(),
+                  "Ada state yang tidak bisa dicapai dari IDLE");
+    static_assert(coReachable(TRANSITIONS, TRANSITION_COUNT,
+                              stateBit(SystemState::STATE_IDLE), FSM_STATE_COUNT) == allStatesMask(),
+                  "Ada state yang tidak punya jalan kembali ke IDLE");
+    static_assert(allHaveFallback(TRANSITIONS, TRANSITION_COUNT, 0, FsmEvent::EV_UI_CHANGED),
+                  "Setiap state wajib punya baris EV_UI_CHANGED tanpa guard");
+    static_assert(allEventsUsed(TRANSITIONS, TRANSITION_COUNT, 0),
+                  "Ada FsmEvent yang tidak dipakai di tabel transisi");
+}
+
 // ===== CONSTRUCTOR / DESTRUCTOR =====
 
 SystemStateMachine::SystemStateMachine(
@@ -26,396 +123,700 @@ SystemStateMachine::SystemStateMachine(
     StateConditionHandler* condHandler,
     SystemStorage* storage,
     NextionGateWay* gateway  // ← TAMBAHAN: parameter baru
-) 
-    : sensorManager(sensors)
-    , actuatorControl(actuators)
+)
+    : conditionHandler(condHandler)
     , nextionOutput(display)
-    , conditionHandler(condHandler)
+    , sensorManager(sensors)
+    , actuatorControl(actuators)
     , systemStorage(storage)
     , nextionGateway(gateway)  // ← TAMBAHAN: initialize pointer
+    , autoCycle(nullptr)
+    , checkpointStore(nullptr)
+    , eventBus(nullptr)
     , currentState(SystemState::STATE_IDLE)
     , previousState(SystemState::STATE_IDLE)
+    , nextState(SystemState::STATE_IDLE)
     , stateEntryTime(0)
-    , lastFillingForceOffTime(0)
-    , lastDrainingForceOffTime(0)
+    , uiData()
+    , uiVersion(0)
+    , eventsProcessed(0)
+    , eventLatencyMaxUs(0)
+    , eventLatencyTotalUs(0)
+    , eventQueueHighWater(0)
+    , transitionStats()
+    , stateChanged(false)
+    , checkpointStage(0)
+    , checkpointStep(0)
+    , resumePending(false)
+    , resumeWaiting(false)
+    , resumeState(SystemState::STATE_IDLE)
+    , recoveryMs(0)
 {
-    mutex = xSemaphoreCreateMutex();
+    mutex = xSemaphoreCreateMutexStatic(&mutexBuffer);
+    eventQueue = xQueueCreateStatic(FSM_QUEUE_LENGTH, sizeof(FsmMessage), eventQueueStorage, &eventQueueBuffer);
     stateEntryTime = millis();
-    
-    Serial.println("[FSM] SystemStateMachine initialized");
+
+    TimerService::initEvent(fillingForceOffTimer, eventQueue, FsmEvent::EV_UI_CHANGED);
+    TimerService::initEvent(drainingForceOffTimer, eventQueue, FsmEvent::EV_UI_CHANGED);
+    TimerService::initFlag(checkpointTimer);
+    TimerService::initEvent(resumeWaitTimer, eventQueue, FsmEvent::EV_DEADLINE);
+
+    LOG_I("FSM", "SystemStateMachine initialized (%u transitions)", TRANSITION_COUNT);
 }
 
 SystemStateMachine::~SystemStateMachine() {
+    timerService.cancel(fillingForceOffTimer);
+    timerService.cancel(drainingForceOffTimer);
+    timerService.cancel(checkpointTimer);
+    timerService.cancel(resumeWaitTimer);
     if (mutex) vSemaphoreDelete(mutex);
+    if (eventQueue) vQueueDelete(eventQueue);
 }
 
 // ===== PUBLIC API =====
 
-void SystemStateMachine::update(const NextionData &data) {
-    lock();
-    
-    SystemState newState = determineState(data);
-    
-    if (newState != currentState) {
-        transitionTo(newState);
-    }
-    
-    // ===== CONTINUOUS STATE CHECKS =====
-    
-    // Update cooling jika sedang di state cooling
-    if (currentState == SystemState::STATE_COOLING) {
-        conditionHandler->updateCooling();
-    }
-    
-    // Check filling condition jika sedang di state filling
-    if (currentState == SystemState::STATE_FILLING) {
-        // ===== FIX: Check valve state sebelum proses condition =====
-        // Jika valve sudah ditutup, jangan proses sensor
-        bool valveOpen = actuatorControl->getValveInletState();
-        
-        if (!valveOpen) {
-            // Valve sudah ditutup - skip condition check
-            Serial.println("[FSM] Valve closed while in FILLING state - skipping condition check");
-        } else {
-            // Valve masih terbuka - process condition normally
-            FillingStatus status = conditionHandler->checkFillingCondition();
-            
-            if (status == FillingStatus::FILLING_COMPLETE) {
-                // Float sensor penuh - auto stop
-                Serial.println("[FSM] Filling complete - Auto transition to IDLE");
-                transitionTo(SystemState::STATE_IDLE);
-            } 
-            else if (status == FillingStatus::FILLING_ERROR) {
-                // Flow error - auto transition to ERROR
-                Serial.println("[FSM] Filling flow error - Auto transition to ERROR");
-                transitionTo(SystemState::STATE_ERROR);
-            }
-        }
+QueueHandle_t SystemStateMachine::getEventQueue() const {
+    return eventQueue;
+}
+
+void SystemStateMachine::setAutoCycle(AutoCycle* cycle) {
+    autoCycle = cycle;
+}
+
+void SystemStateMachine::setEventBus(EventBus* bus) {
+    eventBus = bus;
+}
+
+// ===== CHECKPOINT / RESUME =====
+
+void SystemStateMachine::setCheckpointStore(CheckpointStore* store) {
+    checkpointStore = store;
+}
+
+void SystemStateMachine::resumeFromCheckpoint() {
+    if (!checkpointStore) return;
+    timerService.armPeriodic(checkpointTimer, CHECKPOINT_INTERVAL_MS);
+    if (!checkpointStore->hasCheckpoint()) return;
+
+    const FsmCheckpoint& cp = checkpointStore->getCheckpoint();
+    uint32_t ageS = checkpointStore->getAgeS();
+
+    // Min-off compressor dihormati apa pun keputusannya (umur tidak diketahui = penuh)
+    if (cp.compressorOffAgeS != CHECKPOINT_AGE_UNKNOWN) {
+        uint32_t offS = ageS == CHECKPOINT_AGE_UNKNOWN ? 0 : cp.compressorOffAgeS + ageS;
+        if (offS > COMP_MIN_OFF_MS / 1000) offS = COMP_MIN_OFF_MS / 1000;
+        conditionHandler->restoreCompressorOffAge(offS * 1000UL);
     }
-    
-    // Check draining condition jika sedang di state draining
-    if (currentState == SystemState::STATE_DRAINING) {
-        DrainingStatus status = conditionHandler->checkDrainingCondition();
-        
-        if (status == DrainingStatus::DRAINING_COMPLETE) {
-            // Flow stopped - auto stop
-            Serial.println("[FSM] Draining complete - Auto transition to IDLE");
-            transitionTo(SystemState::STATE_IDLE);
+
+    SystemState state = static_cast<SystemState>(cp.state);
+    bool isAuto = (state == SystemState::STATE_AUTO || state == SystemState::STATE_AUTO_CIRCULATION);
+    bool resumable = isAuto || state == SystemState::STATE_FILLING ||
+                     state == SystemState::STATE_COOLING || state == SystemState::STATE_DRAINING;
+    if (!resumable) {
+        // IDLE tidak perlu apa-apa; BYPASS/ERROR selalu mulai dari IDLE (operator yang memutuskan)
+        if (state != SystemState::STATE_IDLE) {
+            LOG_W("FSM", "Reset in %s - starting IDLE", getStateName(state));
         }
+        return;
+    }
+
+    // Re-validasi sensor: sampel pertama sensor task datang sebagai
+    // EV_SENSOR_CHANGED (tempValid berubah), batas tunggu sebagai EV_DEADLINE
+    resumeState = state;
+    bool needsTemperature = isAuto || state == SystemState::STATE_COOLING;
+    if (needsTemperature && !sensorManager->getData().tempValid) {
+        resumeWaiting = true;
+        timerService.arm(resumeWaitTimer, CHECKPOINT_SENSOR_WAIT_MS);
+        LOG_I("FSM", "Resume %s: waiting for temperature sample", getStateName(state));
+        return;
+    }
+    finishResume(needsTemperature);
+}
+
+void SystemStateMachine::finishResume(bool needsTemperature) {
+    resumeWaiting = false;
+    timerService.cancel(resumeWaitTimer);
+
+    SystemState state = resumeState;
+    const FsmCheckpoint& cp = checkpointStore->getCheckpoint();
+    uint32_t ageS = checkpointStore->getAgeS();
+    bool isAuto = (state == SystemState::STATE_AUTO || state == SystemState::STATE_AUTO_CIRCULATION);
+
+    const char* reason = checkpointStore->checkResume(needsTemperature, sensorManager->getData());
+    if (reason) {
+        LOG_W("FSM", "Not resuming %s after reset: %s - starting IDLE", getStateName(state), reason);
+        return;
+    }
+
+    if (isAuto && autoCycle) {
+        autoCycle->setResume(cp, ageS);
+    }
+    nextionGateway->restoreButtons(cp.uiFlags & CP_UI_FILLING, cp.uiFlags & CP_UI_COOLING,
+                                   cp.uiFlags & CP_UI_DRAINING, cp.uiFlags & CP_UI_AUTO,
+                                   cp.uiFlags & CP_UI_CIRCULATION);
+    resumePending = true;
+    LOG_I("FSM", "Resuming %s (checkpoint %lus old)", getStateName(state), (unsigned long)ageS);
+}
+
+uint32_t SystemStateMachine::getRecoveryMs() const {
+    return recoveryMs;
+}
+
+bool SystemStateMachine::postEvent(FsmEvent event) {
+    return fsmPostEvent(eventQueue, event);
+}
+
+void SystemStateMachine::processNextEvent() {
+    // Tidur di sini - timeout/debounce datang sebagai event dari TimerService
+    FsmMessage msg;
+    if (xQueueReceive(eventQueue, &msg, pdMS_TO_TICKS(HEARTBEAT_MS)) != pdTRUE) {
+        msg.event = FsmEvent::EV_HEARTBEAT;
+        msg.postedUs = micros();
     }
-    
+
+    uint32_t latencyUs = micros() - msg.postedUs;
+    uint32_t depth = uxQueueMessagesWaiting(eventQueue) + 1;
+
+    lock();
+    eventsProcessed++;
+    eventLatencyTotalUs += latencyUs;
+    if (latencyUs > eventLatencyMaxUs) eventLatencyMaxUs = latencyUs;
+    if (depth > eventQueueHighWater) eventQueueHighWater = depth;
     unlock();
+
+    // State FSM hanya disentuh task ini: action (actuator, sensor snapshot,
+    // command display ke mailbox) jalan tanpa memegang lock bersama
+    processEvent(msg.event);
 }
 
 SystemState SystemStateMachine::getState() const {
     return currentState;
 }
 
-String SystemStateMachine::stateName() const {
-    return String(getStateName(currentState));
+const char* SystemStateMachine::stateName() const {
+    return getStateName(currentState);
 }
 
 bool SystemStateMachine::isInAutoMode() const {
-    return (currentState == SystemState::STATE_AUTO || 
+    return (currentState == SystemState::STATE_AUTO ||
             currentState == SystemState::STATE_AUTO_CIRCULATION);
 }
 
 void SystemStateMachine::reset() {
-    lock();
     transitionTo(SystemState::STATE_IDLE);
+}
+
+// ===== TRANSITION METRICS =====
+
+FsmTransitionStats SystemStateMachine::getTransitionStats(uint8_t row) {
+    FsmTransitionStats stats = {};
+    if (row >= TRANSITION_COUNT) return stats;
+
+    lock();
+    stats = transitionStats[row];
+    unlock();
+    return stats;
+}
+
+void SystemStateMachine::printTransitionStats() {
+    lock();
+    for (uint8_t i = 0; i < TRANSITION_COUNT; i++) {
+        const FsmTransition& t = TRANSITIONS[i];
+        const FsmTransitionStats& stats = transitionStats[i];
+        if (stats.count == 0) continue;
+
+        LOG_I("FSM", "#%u %s --%s--> %s: count=%lu avg=%luus max=%luus",
+              i,
+              t.from == FSM_ANY_STATE ? "*" : getStateName(t.from),
+              fsmEventName(t.event),
+              getStateName(t.to),
+              (unsigned long)stats.count,
+              (unsigned long)(stats.totalUs / stats.count),
+              (unsigned long)stats.maxUs);
+    }
+    LOG_I("FSM", "Events processed: %lu, max queue latency: %luus",
+          (unsigned long)eventsProcessed, (unsigned long)eventLatencyMaxUs);
     unlock();
 }
 
+uint32_t SystemStateMachine::getMaxEventLatencyUs() const {
+    return eventLatencyMaxUs;
+}
+
+MailboxStats SystemStateMachine::getMailboxStats() {
+    MailboxStats stats = {};
+    lock();
+    stats.received = eventsProcessed;
+    stats.highWater = eventQueueHighWater;
+    stats.maxLatencyUs = eventLatencyMaxUs;
+    stats.avgLatencyUs = eventsProcessed ? static_cast<uint32_t>(eventLatencyTotalUs / eventsProcessed) : 0;
+    unlock();
+    stats.depth = uxQueueMessagesWaiting(eventQueue);
+    stats.dropped = fsmDroppedEvents.load(std::memory_order_relaxed);
+    return stats;
+}
+
 // ===== PRIVATE METHODS =====
 
+void SystemStateMachine::processEvent(FsmEvent event) {
+    // Keputusan resume belum ada: event ditahan (UI berbasis snapshot,
+    // heartbeat berikutnya mengevaluasi ulang), FSM tetap tidak memblok
+    if (resumeWaiting) {
+        if (!sensorManager->getData().tempValid && TimerService::isArmed(resumeWaitTimer)) {
+            // Edge ISR tetap di-ack, kalau tidak ISR berhenti mem-post
+            if (event == FsmEvent::EV_SENSOR_CHANGED) sensorManager->refreshDigitalInputs();
+            return;
+        }
+        finishResume(true);
+    }
+
+    switch (event) {
+        case FsmEvent::EV_UI_CHANGED:
+        case FsmEvent::EV_HEARTBEAT:
+            // Heartbeat mengevaluasi ulang UI juga - jaring pengaman kalau event hilang
+            refreshUiSnapshot();
+            dispatch(FsmEvent::EV_UI_CHANGED);
+            break;
+
+        case FsmEvent::EV_SENSOR_CHANGED:
+            // Edge dari ISR: baca ulang input digital sebelum do-activity jalan
+            sensorManager->refreshDigitalInputs();
+            break;
+
+        case FsmEvent::EV_DEADLINE:
+        case FsmEvent::EV_RTC_ALARM:
+            break;
+
+        default:
+            // Table event yang di-post langsung dari luar
+            dispatch(event);
+            break;
+    }
+
+    // Do-activity state aktif (bisa men-dispatch event auto-complete)
+    runStateUpdate();
+
+    updateCheckpoint();
+}
+
+void SystemStateMachine::refreshUiSnapshot() {
+    // Panel tidak berubah sejak snapshot terakhir: copy & bandingkan setting tidak perlu
+    if (nextionGateway->getVersion() == uiVersion) return;
+
+    uiVersion = nextionGateway->getData(uiData);
+    systemStorage->updateFromNextion(uiData);
+}
+
+void SystemStateMachine::runStateUpdate() {
+    FsmAction onUpdate = STATE_HANDLERS[static_cast<uint8_t>(currentState)].onUpdate;
+    if (onUpdate) {
+        (this->*onUpdate)();
+    }
+}
+
+void SystemStateMachine::updateCheckpoint() {
+    if (!checkpointStore) return;
+
+    if (stateChanged) {
+        stateChanged = false;
+        saveCheckpoint(true);
+    } else if (timerService.consumeExpired(checkpointTimer) && currentState != SystemState::STATE_IDLE) {
+        saveCheckpoint(false);
+    }
+}
+
+void SystemStateMachine::saveCheckpoint(bool transition) {
+    FsmCheckpoint cp = FsmCheckpoint();
+    cp.state = static_cast<uint8_t>(currentState);
+    cp.uiFlags = (uiData.fillingStatus ? CP_UI_FILLING : 0) |
+                 (uiData.coolingStatus ? CP_UI_COOLING : 0) |
+                 (uiData.drainingStatus ? CP_UI_DRAINING : 0) |
+                 (uiData.autoStatus ? CP_UI_AUTO : 0) |
+                 (uiData.circulationStatus ? CP_UI_CIRCULATION : 0);
+    if (autoCycle) {
+        autoCycle->fillCheckpoint(cp);
+    }
+
+    uint32_t offAgeMs;
+    cp.compressorOffAgeS = conditionHandler->getCompressorOffAgeMs(offAgeMs)
+                         ? offAgeMs / 1000 : CHECKPOINT_AGE_UNKNOWN;
+
+    // Step recipe berganti = transisi juga (mirror NVS langsung)
+    if (cp.autoStage != checkpointStage || cp.stepIndex != checkpointStep) {
+        transition = true;
+        checkpointStage = cp.autoStage;
+        checkpointStep = cp.stepIndex;
+    }
+
+    checkpointStore->save(cp, transition);
+}
+
+void SystemStateMachine::dispatch(FsmEvent event) {
+    // Bounded table walk: maksimal TRANSITION_COUNT baris
+    for (uint8_t i = 0; i < TRANSITION_COUNT; i++) {
+        const FsmTransition& t = TRANSITIONS[i];
+
+        if (t.event != event) continue;
+        if (t.from != FSM_ANY_STATE && t.from != currentState) continue;
+        if (t.guard && !(this->*t.guard)()) continue;
+
+        fire(i);
+        return;
+    }
+}
+
+void SystemStateMachine::fire(uint8_t row) {
+    const FsmTransition& t = TRANSITIONS[row];
+    bool changesState = (t.to != currentState);
+
+    // Baris "tetap di state ini" tanpa action = no-op, tidak dihitung
+    if (!changesState && !t.action) return;
+
+    uint32_t startUs = micros();
+
+    if (changesState) {
+        nextState = t.to;
+        onStateExit(currentState);
+    }
+
+    if (t.action) {
+        (this->*t.action)();
+    }
+
+    if (changesState) {
+        previousState = currentState;
+        currentState = t.to;
+        stateEntryTime = millis();
+        stateChanged = true;
+        onStateEntry(currentState);
+    }
+
+    uint32_t elapsedUs = micros() - startUs;
+    lock();
+    FsmTransitionStats& stats = transitionStats[row];
+    stats.count++;
+    stats.totalUs += elapsedUs;
+    if (elapsedUs > stats.maxUs) stats.maxUs = elapsedUs;
+    unlock();
+}
+
 void SystemStateMachine::transitionTo(SystemState newState) {
+    nextState = newState;
     onStateExit(currentState);
-    
+
     previousState = currentState;
     currentState = newState;
     stateEntryTime = millis();
-    
+    stateChanged = true;
+
     onStateEntry(currentState);
 }
 
-SystemState SystemStateMachine::determineState(const NextionData &data) {
-    // Priority 0: Bypass Menu (highest priority - dapat override semua)
-    if (data.inBypassMenu) {
-        return SystemState::STATE_BYPASS_MENU;
-    }
-    
-    // Priority 1: Error recovery check
-    if (currentState == SystemState::STATE_ERROR) {
-        // Check apakah error berasal dari filling
-        bool fromFillingError = (previousState == SystemState::STATE_FILLING);
-        
-        if (fromFillingError) {
-            // Error recovery untuk FILLING
-            if (conditionHandler->isErrorCleared()) {
-                // Flow kembali normal - langsung ke FILLING
-                Serial.println("[FSM] Flow restored - Auto recovery to FILLING");
-                return SystemState::STATE_FILLING;
-            }
-            
-            // User tekan FILLING OFF (bukan ON, bukan tombol lain)
-            if (!data.fillingStatus) {
-                Serial.println("[FSM] User pressed FILLING OFF - Exit ERROR to IDLE");
-                return SystemState::STATE_IDLE;
-            }
-            
-            // Masih error dan button masih ON - tetap di ERROR
-            return SystemState::STATE_ERROR;
-        }
-        
-        // Error dari state lain (future-proof)
-        if (conditionHandler->isErrorCleared()) {
-            return SystemState::STATE_IDLE;
-        }
-        return SystemState::STATE_ERROR;
-    }
-    
-    // Priority 2: Auto Mode (dengan sub-state circulation)
-    if (data.autoStatus) {
-        if (data.circulationStatus) {
-            return SystemState::STATE_AUTO_CIRCULATION;
-        } else {
-            return SystemState::STATE_AUTO;
-        }
+void SystemStateMachine::onStateEntry(SystemState state) {
+    LOG_I("FSM", "Entering state: %s (from %s)",
+          getStateName(state), getStateName(previousState));
+
+    FsmAction onEntry = STATE_HANDLERS[static_cast<uint8_t>(state)].onEntry;
+    if (onEntry) {
+        (this->*onEntry)();
     }
-    
-    // Priority 3: Manual Operations
-    
-    // FILLING - Check debounce after force off
-    if (data.fillingStatus) {
-        // Ignore if within debounce period after force off
-        unsigned long timeSinceForceOff = millis() - lastFillingForceOffTime;
-        if (timeSinceForceOff < FORCE_OFF_DEBOUNCE_MS) {
-            Serial.println("[FSM] Ignoring FILLING ON (debounce after auto-complete)");
-            return SystemState::STATE_IDLE;
-        }
-        return SystemState::STATE_FILLING;
-    }
-    
-    if (data.coolingStatus) {
-        return SystemState::STATE_COOLING;
-    }
-    
-    // DRAINING - Check debounce after force off
-    if (data.drainingStatus) {
-        // Ignore if within debounce period after force off
-        unsigned long timeSinceForceOff = millis() - lastDrainingForceOffTime;
-        if (timeSinceForceOff < FORCE_OFF_DEBOUNCE_MS) {
-            Serial.println("[FSM] Ignoring DRAINING ON (debounce after auto-complete)");
-            return SystemState::STATE_IDLE;
+
+    // Transisi pertama setelah boot menentukan hasil resume
+    if (resumePending) {
+        resumePending = false;
+        if (state == resumeState) {
+            recoveryMs = millis();
+            LOG_I("FSM", "Resumed %s %lums after reset", getStateName(state), (unsigned long)recoveryMs);
         }
-        return SystemState::STATE_DRAINING;
     }
-    
-    // Default: Idle
-    return SystemState::STATE_IDLE;
-}
 
-void SystemStateMachine::onStateEntry(SystemState state) {
-    Serial.print("[FSM] Entering state: ");
-    Serial.print(getStateName(state));
-    Serial.print(" (from ");
-    Serial.print(getStateName(previousState));
-    Serial.println(")");
-    
-    // Call state-specific handlers
-    switch (state) {
-        case SystemState::STATE_IDLE:
-            handleIdleEntry();
-            break;
-            
-        case SystemState::STATE_FILLING:
-            handleFillingEntry();
-            break;
-            
-        case SystemState::STATE_COOLING:
-            handleCoolingEntry();
-            break;
-            
-        case SystemState::STATE_DRAINING:
-            handleDrainingEntry();
-            break;
-            
-        case SystemState::STATE_AUTO:
-            handleAutoEntry();
-            break;
-            
-        case SystemState::STATE_AUTO_CIRCULATION:
-            handleAutoCirculationEntry();
-            break;
-            
-        case SystemState::STATE_BYPASS_MENU:
-            handleBypassMenuEntry();
-            break;
-            
-        case SystemState::STATE_ERROR:
-            handleErrorEntry();
-            break;
+    if (eventBus) {
+        StateChange change = { previousState, state };
+        eventBus->states.publish(change);
     }
 }
 
 void SystemStateMachine::onStateExit(SystemState state) {
     unsigned long duration = millis() - stateEntryTime;
-    
-    Serial.print("[FSM] Exiting state: ");
-    Serial.print(getStateName(state));
-    Serial.print(" (duration: ");
-    Serial.print(duration);
-    Serial.println(" ms)");
-    
-    // Call state-specific exit handlers
-    switch (state) {
-        case SystemState::STATE_FILLING:
-            handleFillingExit();
-            break;
-            
-        case SystemState::STATE_COOLING:
-            handleCoolingExit();
-            break;
-            
-        case SystemState::STATE_DRAINING:
-            handleDrainingExit();
-            break;
-            
-        case SystemState::STATE_AUTO:
-            handleAutoExit();
-            break;
-            
-        case SystemState::STATE_AUTO_CIRCULATION:
-            handleAutoCirculationExit();
-            break;
-            
-        case SystemState::STATE_ERROR:
-            // Clear error blink saat keluar dari ERROR state
-            nextionOutput->setErrorBlink(false);
-            Serial.println("[ACTION] Exiting ERROR - Clearing error display");
-            break;
-            
-        default:
-            break;
+
+    LOG_I("FSM", "Exiting state: %s (duration: %lu ms)", getStateName(state), duration);
+
+    FsmAction onExit = STATE_HANDLERS[static_cast<uint8_t>(state)].onExit;
+    if (onExit) {
+        (this->*onExit)();
     }
 }
 
+// ===== GUARDS =====
+
+bool SystemStateMachine::guardUiBypass() const {
+    return uiData.inBypassMenu;
+}
+
+bool SystemStateMachine::guardUiFillingOffAfterFillError() const {
+    // User tekan FILLING OFF (bukan ON, bukan tombol lain)
+    return previousState == SystemState::STATE_FILLING && !uiData.fillingStatus;
+}
+
+bool SystemStateMachine::guardUiAutoCirculation() const {
+    return uiData.autoStatus && uiData.circulationStatus;
+}
+
+bool SystemStateMachine::guardUiAuto() const {
+    return uiData.autoStatus;
+}
+
+bool SystemStateMachine::guardUiFillingIgnored() const {
+    // Ignore if within debounce period after force off
+    return uiData.fillingStatus && timerService.isArmed(fillingForceOffTimer);
+}
+
+bool SystemStateMachine::guardUiFilling() const {
+    return uiData.fillingStatus;
+}
+
+bool SystemStateMachine::guardUiCooling() const {
+    return uiData.coolingStatus;
+}
+
+bool SystemStateMachine::guardUiDrainingIgnored() const {
+    // Ignore if within debounce period after force off
+    return uiData.drainingStatus && timerService.isArmed(drainingForceOffTimer);
+}
+
+bool SystemStateMachine::guardUiDraining() const {
+    return uiData.drainingStatus;
+}
+
+bool SystemStateMachine::guardErrorFromFilling() const {
+    // Check apakah error berasal dari filling
+    return previousState == SystemState::STATE_FILLING;
+}
+
+bool SystemStateMachine::guardErrorClearedFromFilling() const {
+    return guardErrorFromFilling() && conditionHandler->isErrorCleared();
+}
+
+bool SystemStateMachine::guardErrorCleared() const {
+    // Baris sebelumnya sudah menangani error dari filling
+    return !guardErrorFromFilling() && conditionHandler->isErrorCleared();
+}
+
+// ===== TRANSITION ACTIONS =====
+
+void SystemStateMachine::actionFillingComplete() {
+    // Float sensor penuh - auto stop
+    LOG_I("FSM", "Filling complete - Auto transition to IDLE");
+}
+
+void SystemStateMachine::actionFillingFlowError() {
+    // Flow error - auto transition to ERROR
+    LOG_W("FSM", "Filling flow error - Auto transition to ERROR");
+}
+
+void SystemStateMachine::actionDrainingComplete() {
+    // Flow stopped - auto stop
+    LOG_I("FSM", "Draining complete - Auto transition to IDLE");
+}
+
+void SystemStateMachine::actionErrorRecoveredToFilling() {
+    // Flow kembali normal - langsung ke FILLING
+    LOG_I("FSM", "Flow restored - Auto recovery to FILLING");
+}
+
+void SystemStateMachine::actionErrorExitByUser() {
+    LOG_I("FSM", "User pressed FILLING OFF - Exit ERROR to IDLE");
+}
+
+void SystemStateMachine::actionIgnoreFillingOn() {
+    LOG_D("FSM", "Ignoring FILLING ON (debounce after auto-complete)");
+}
+
+void SystemStateMachine::actionIgnoreDrainingOn() {
+    LOG_D("FSM", "Ignoring DRAINING ON (debounce after auto-complete)");
+}
+
 // ===== STATE-SPECIFIC HANDLERS =====
 
 void SystemStateMachine::handleIdleEntry() {
-    Serial.println("[ACTION] System idle - All actuators off");
+    LOG_I("ACTION", "System idle - All actuators off");
     actuatorControl->allOff();
-    
+
     // Jika masuk IDLE dari FILLING, force OFF di Nextion
     if (previousState == SystemState::STATE_FILLING) {
         // ===== FIX: Auto-clear fillingStatus di NextionGateWay =====
         nextionGateway->clearFillingStatus();
-        
+
         nextionOutput->forceFillingOff();
-        lastFillingForceOffTime = millis();  // Record timestamp
-        Serial.println("[ACTION] Exited FILLING - Cleared fillingStatus & Forced Nextion button OFF");
+        timerService.arm(fillingForceOffTimer, FORCE_OFF_DEBOUNCE_MS);
+        LOG_I("ACTION", "Exited FILLING - Cleared fillingStatus & Forced Nextion button OFF");
     }
-    
+
     // Jika masuk IDLE dari DRAINING, force OFF di Nextion
     if (previousState == SystemState::STATE_DRAINING) {
         // ===== FIX: Auto-clear drainingStatus di NextionGateWay =====
         nextionGateway->clearDrainingStatus();
-        
+
         nextionOutput->forceDrainingOff();
-        lastDrainingForceOffTime = millis();  // Record timestamp
-        Serial.println("[ACTION] Exited DRAINING - Cleared drainingStatus & Forced Nextion button OFF");
+        timerService.arm(drainingForceOffTimer, FORCE_OFF_DEBOUNCE_MS);
+        LOG_I("ACTION", "Exited DRAINING - Cleared drainingStatus & Forced Nextion button OFF");
     }
 }
 
 void SystemStateMachine::handleFillingEntry() {
-    Serial.println("[ACTION] Start filling sequence");
-    
+    LOG_I("ACTION", "Start filling sequence");
+
     // Start filling (valve open)
     conditionHandler->startFilling();
-    
+
     // NOTE: Nextion already handles animation when button pressed
     // No need to send animation command here
 }
 
+void SystemStateMachine::handleFillingUpdate() {
+    // ===== FIX: Check valve state sebelum proses condition =====
+    // Jika valve sudah ditutup, jangan proses sensor
+    if (!actuatorControl->getValveInletState()) {
+        // Valve sudah ditutup - skip condition check
+        LOG_D("FSM", "Valve closed while in FILLING state - skipping condition check");
+        return;
+    }
+
+    // Valve masih terbuka - process condition normally
+    FillingStatus status = conditionHandler->checkFillingCondition();
+
+    if (status == FillingStatus::FILLING_COMPLETE) {
+        dispatch(FsmEvent::EV_FILL_COMPLETE);
+    }
+    else if (status == FillingStatus::FILLING_ERROR) {
+        dispatch(FsmEvent::EV_FILL_FLOW_ERROR);
+    }
+}
+
 void SystemStateMachine::handleFillingExit() {
-    Serial.println("[ACTION] Stop filling");
+    LOG_I("ACTION", "Stop filling");
     conditionHandler->stopFilling();
-    
+
     // Note: Button dan animasi akan dimatikan di handleIdleEntry
     // jika transition ke IDLE
 }
 
 void SystemStateMachine::handleCoolingEntry() {
-    Serial.println("[ACTION] Start cooling sequence");
-    
+    LOG_I("ACTION", "Start cooling sequence");
+
     // Get cooling target dari SystemStorage
     uint8_t coolingTarget = systemStorage->getCoolingValue();
-    
-    Serial.print("[COOLING] Target from storage: ");
-    Serial.print(coolingTarget);
-    Serial.println("°C");
-    
+
+    LOG_I("COOLING", "Target from storage: %u°C", coolingTarget);
+
     conditionHandler->startCooling(coolingTarget);
 }
 
+void SystemStateMachine::handleCoolingUpdate() {
+    conditionHandler->updateCooling();
+}
+
 void SystemStateMachine::handleCoolingExit() {
-    Serial.println("[ACTION] Stop cooling");
+    LOG_I("ACTION", "Stop cooling");
     conditionHandler->stopCooling();
 }
 
 void SystemStateMachine::handleDrainingEntry() {
-    Serial.println("[ACTION] Start draining sequence");
+    LOG_I("ACTION", "Start draining sequence");
     conditionHandler->startDraining();
 }
 
+void SystemStateMachine::handleDrainingUpdate() {
+    DrainingStatus status = conditionHandler->checkDrainingCondition();
+
+    if (status == DrainingStatus::DRAINING_COMPLETE) {
+        dispatch(FsmEvent::EV_DRAIN_COMPLETE);
+    }
+}
+
 void SystemStateMachine::handleDrainingExit() {
-    Serial.println("[ACTION] Stop draining");
+    LOG_I("ACTION", "Stop draining");
     conditionHandler->stopDraining();
 }
 
 void SystemStateMachine::handleAutoEntry() {
-    Serial.println("[ACTION] Entering AUTO mode (no circulation)");
-    // TODO: Implementasi AUTO mode logic
+    LOG_I("ACTION", "Entering AUTO mode (no circulation)");
+    if (!autoCycle) return;
+
+    // Dari AUTO_CIRCULATION: batch jalan terus, hanya ozone yang berubah
+    if (autoCycle->isRunning()) {
+        autoCycle->setCirculation(false);
+    } else {
+        autoCycle->start(false);
+    }
+}
+
+void SystemStateMachine::handleAutoUpdate() {
+    if (autoCycle) {
+        autoCycle->update();
+    }
 }
 
 void SystemStateMachine::handleAutoExit() {
-    Serial.println("[ACTION] Exiting AUTO mode");
-    // TODO: Cleanup AUTO mode
+    LOG_I("ACTION", "Exiting AUTO mode");
+    if (autoCycle && nextState != SystemState::STATE_AUTO_CIRCULATION) {
+        autoCycle->stop();
+    }
 }
 
 void SystemStateMachine::handleAutoCirculationEntry() {
-    Serial.println("[ACTION] AUTO mode WITH circulation");
-    // TODO: Implementasi AUTO + CIRCULATION logic
+    LOG_I("ACTION", "AUTO mode WITH circulation");
+    if (!autoCycle) return;
+
+    if (autoCycle->isRunning()) {
+        autoCycle->setCirculation(true);
+    } else {
+        autoCycle->start(true);
+    }
 }
 
 void SystemStateMachine::handleAutoCirculationExit() {
-    Serial.println("[ACTION] Exiting AUTO with circulation");
-    // TODO: Cleanup AUTO + CIRCULATION
+    LOG_I("ACTION", "Exiting AUTO with circulation");
+    if (autoCycle && nextState != SystemState::STATE_AUTO) {
+        autoCycle->stop();
+    }
 }
 
 void SystemStateMachine::handleBypassMenuEntry() {
-    Serial.println("[ACTION] Entered bypass menu - System paused");
+    LOG_I("ACTION", "Entered bypass menu - System paused");
     // Nextion sudah auto-turn off semua button saat masuk bypass
     // Tidak perlu action tambahan
 }
 
 void SystemStateMachine::handleErrorEntry() {
-    Serial.println("[ACTION] ERROR state - Emergency stop");
-    
+    LOG_W("ACTION", "ERROR state - Emergency stop");
+
     // Emergency stop semua actuator
     actuatorControl->allOff();
-    
+
     // Pastikan error blink ditampilkan
     nextionOutput->setErrorBlink(true);
-    
-    Serial.println("[ERROR] All actuators stopped, error animation displayed");
+
+    LOG_W("ERROR", "All actuators stopped, error animation displayed");
+}
+
+void SystemStateMachine::handleErrorUpdate() {
+    if (conditionHandler->isErrorCleared()) {
+        dispatch(FsmEvent::EV_ERROR_CLEARED);
+    }
+}
+
+void SystemStateMachine::handleErrorExit() {
+    // Clear error blink saat keluar dari ERROR state
+    nextionOutput->setErrorBlink(false);
+    LOG_I("ACTION", "Exiting ERROR - Clearing error display");
 }
 
 // ===== HELPER FUNCTIONS =====
 
 const char* SystemStateMachine::getStateName(SystemState state) const {
     uint8_t index = static_cast<uint8_t>(state);
-    if (index < 8) {
+    if (index < FSM_STATE_COUNT) {
         return STATE_NAMES[index];
     }
     return "UNKNOWN";
@@ -433,4 +834,4 @@ void SystemStateMachine::unlock() {
     if (mutex) {
         xSemaphoreGive(mutex);
     }
-}
\ No newline at end of file
+}
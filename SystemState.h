@@ -5,12 +5,19 @@
 #include <Arduino.h>
 #include "NextionGateWay.h"
 #include "SystemVariables.h"  // ← untuk SystemStorage
+#include "FsmEvent.h"
+#include "TimerService.h"
+#include "Mailbox.h"
 
 // Forward declarations
 class StateConditionHandler;
 class NextionOutput;
 class SensorManager;
 class ActuatorControl;
+class SystemStateMachine;
+class AutoCycle;
+class CheckpointStore;
+struct EventBus;
 
 // ===== STATE DEFINITIONS =====
 enum class SystemState : uint8_t {
@@ -24,6 +31,40 @@ enum class SystemState : uint8_t {
     STATE_ERROR
 };
 
+constexpr uint8_t FSM_STATE_COUNT = 8;
+constexpr SystemState FSM_ANY_STATE = static_cast<SystemState>(0xFF);  // Wildcard kolom "from"
+
+// ===== TRANSITION TABLE TYPES =====
+#define FSM_MAX_TRANSITIONS 32
+
+typedef bool (SystemStateMachine::*FsmGuard)() const;
+typedef void (SystemStateMachine::*FsmAction)();
+
+// Satu baris: (from × event) → guard → action → to
+// Baris dicek berurutan; baris pertama yang guard-nya lolos yang dijalankan.
+// guard == nullptr berarti selalu lolos. to == from berarti internal transition
+// (tanpa exit/entry).
+struct FsmTransition {
+    SystemState from;
+    FsmEvent event;
+    FsmGuard guard;
+    FsmAction action;
+    SystemState to;
+};
+
+// Handler per state: entry, update berkala (do-activity), exit
+struct FsmStateHandlers {
+    FsmAction onEntry;
+    FsmAction onUpdate;
+    FsmAction onExit;
+};
+
+struct FsmTransitionStats {
+    uint32_t count;         // Berapa kali baris ini dijalankan
+    uint32_t totalUs;       // Total waktu exit + action + entry
+    uint32_t maxUs;         // Waktu terlama
+};
+
 // ===== STATE MACHINE CLASS =====
 class SystemStateMachine {
 public:
@@ -38,14 +79,38 @@ public:
     );
     ~SystemStateMachine();
 
-    void update(const NextionData &data);
-    
+    // ===== EVENT-DRIVEN EXECUTION =====
+    // FSM task memanggil processNextEvent() terus-menerus: tidur di queue sampai
+    // ada event (UI, sensor, expiry TimerService) atau heartbeat supervisi.
+    QueueHandle_t getEventQueue() const;
+    bool postEvent(FsmEvent event);
+    void processNextEvent();
+
+    // Engine batch untuk STATE_AUTO / STATE_AUTO_CIRCULATION
+    void setAutoCycle(AutoCycle* cycle);
+
+    // Setiap transisi di-publish ke topic states (setelah entry state baru)
+    void setEventBus(EventBus* bus);
+
+    // ===== CHECKPOINT / RESUME =====
+    void setCheckpointStore(CheckpointStore* store);
+    // Dari FSM task sebelum event pertama: putuskan lanjut state sebelum reset atau IDLE
+    // (butuh suhu: keputusan ditunda sampai sampel valid/CHECKPOINT_SENSOR_WAIT_MS, tanpa blok)
+    void resumeFromCheckpoint();
+    uint32_t getRecoveryMs() const;  // Reset → state di-resume (0 = tidak resume)
+
     SystemState getState() const;
-    String stateName() const;
-    
+    const char* stateName() const;
+
     bool isInAutoMode() const;
-    
-    void reset();
+
+    void reset();                    // Hanya dari FSM task (pemilik state)
+
+    // ===== TRANSITION METRICS =====
+    FsmTransitionStats getTransitionStats(uint8_t row);
+    void printTransitionStats();
+    uint32_t getMaxEventLatencyUs() const;
+    MailboxStats getMailboxStats();  // Queue event FSM: depth & latency post → proses
 
 private:
     // Dependencies (injected via constructor)
@@ -55,45 +120,176 @@ private:
     ActuatorControl* actuatorControl;
     SystemStorage* systemStorage;
     NextionGateWay* nextionGateway;  // ← TAMBAHAN: untuk clear status
-    
+    AutoCycle* autoCycle;
+    CheckpointStore* checkpointStore;
+    EventBus* eventBus;
+
     // State tracking
     SystemState currentState;
     SystemState previousState;
-    
+    SystemState nextState;           // Tujuan transisi, valid selama onStateExit
+
     unsigned long stateEntryTime;
     SemaphoreHandle_t mutex;
-    
+    StaticSemaphore_t mutexBuffer;
+
+    // Event queue (producer: gateway, sensor ISR/task, FSM sendiri)
+    QueueHandle_t eventQueue;
+    StaticQueue_t eventQueueBuffer;
+    uint8_t eventQueueStorage[FSM_QUEUE_LENGTH * sizeof(FsmMessage)];
+    static const uint32_t HEARTBEAT_MS = 1000;
+
+    // Snapshot input Nextion terakhir (di-refresh saat EV_UI_CHANGED / heartbeat)
+    NextionData uiData;
+    uint32_t uiVersion;              // Versi snapshot gateway di uiData
+
+    // Event metrics (satu-satunya yang dijaga mutex: dibaca task console)
+    uint32_t eventsProcessed;
+    uint32_t eventLatencyMaxUs;
+    uint64_t eventLatencyTotalUs;
+    uint32_t eventQueueHighWater;
+
     // Auto-complete tracking (to prevent re-entry)
-    unsigned long lastFillingForceOffTime;
-    unsigned long lastDrainingForceOffTime;
+    // Armed = tombol ON di-ignore; saat expire post EV_UI_CHANGED untuk evaluasi ulang
+    Timer fillingForceOffTimer;
+    Timer drainingForceOffTimer;
     static const unsigned long FORCE_OFF_DEBOUNCE_MS = 500;  // 500ms debounce
 
+    FsmTransitionStats transitionStats[FSM_MAX_TRANSITIONS];
+
+    // Checkpoint: transisi → langsung, progress → tiap CHECKPOINT_INTERVAL_MS
+    Timer checkpointTimer;
+    bool stateChanged;               // Transisi sejak checkpoint terakhir
+    uint8_t checkpointStage;         // Stage/step auto di checkpoint terakhir
+    uint8_t checkpointStep;
+    bool resumePending;              // Menunggu resumeState dimasuki
+    bool resumeWaiting;              // Menunggu sampel suhu valid sebelum memutuskan resume
+    Timer resumeWaitTimer;           // Post EV_DEADLINE: batas tunggu sensor habis
+    SystemState resumeState;
+    uint32_t recoveryMs;
+
+    // ===== TRANSITION TABLE =====
+    static const FsmTransition TRANSITIONS[];
+    static const uint8_t TRANSITION_COUNT;
+    static const FsmStateHandlers STATE_HANDLERS[];
+
+    void processEvent(FsmEvent event);
+    void finishResume(bool needsTemperature);
+    void refreshUiSnapshot();
+    void runStateUpdate();
+    void updateCheckpoint();
+    void saveCheckpoint(bool transition);
+
+    void dispatch(FsmEvent event);
+    void fire(uint8_t row);
     void transitionTo(SystemState newState);
-    SystemState determineState(const NextionData &data);
-    
+
     void onStateEntry(SystemState state);
     void onStateExit(SystemState state);
-    
+
+    // Guards (kolom "guard" tabel transisi)
+    bool guardUiBypass() const;
+    bool guardUiFillingOffAfterFillError() const;
+    bool guardUiAutoCirculation() const;
+    bool guardUiAuto() const;
+    bool guardUiFillingIgnored() const;
+    bool guardUiFilling() const;
+    bool guardUiCooling() const;
+    bool guardUiDrainingIgnored() const;
+    bool guardUiDraining() const;
+    bool guardErrorFromFilling() const;
+    bool guardErrorClearedFromFilling() const;
+    bool guardErrorCleared() const;
+
+    // Transition actions (kolom "action" tabel transisi)
+    void actionFillingComplete();
+    void actionFillingFlowError();
+    void actionDrainingComplete();
+    void actionErrorRecoveredToFilling();
+    void actionErrorExitByUser();
+    void actionIgnoreFillingOn();
+    void actionIgnoreDrainingOn();
+
     // State-specific action handlers
     void handleIdleEntry();
     void handleFillingEntry();
+    void handleFillingUpdate();
     void handleFillingExit();
     void handleCoolingEntry();
+    void handleCoolingUpdate();
     void handleCoolingExit();
     void handleDrainingEntry();
+    void handleDrainingUpdate();
     void handleDrainingExit();
     void handleAutoEntry();
+    void handleAutoUpdate();
     void handleAutoExit();
     void handleAutoCirculationEntry();
     void handleAutoCirculationExit();
     void handleBypassMenuEntry();
     void handleErrorEntry();
-    
+    void handleErrorUpdate();
+    void handleErrorExit();
+
     void lock();
     void unlock();
-    
+
     // Helper untuk convert state ke string
     const char* getStateName(SystemState state) const;
+
+    // ===== COMPILE-TIME TABLE VALIDATION =====
+    // Rekursif satu-return supaya valid sebagai constexpr C++11
+    static constexpr uint32_t stateBit(SystemState s) {
+        return s == FSM_ANY_STATE ? 0 : (1u << static_cast<uint8_t>(s));
+    }
+    static constexpr uint32_t allStatesMask() {
+        return (1u << FSM_STATE_COUNT) - 1;
+    }
+    static constexpr bool rowsValid(const FsmTransition* t, uint8_t n) {
+        return n == 0 || (
+            (t->from == FSM_ANY_STATE || static_cast<uint8_t>(t->from) < FSM_STATE_COUNT) &&
+            static_cast<uint8_t>(t->to) < FSM_STATE_COUNT &&
+            t->event < FsmEvent::EV_COUNT &&
+            rowsValid(t + 1, n - 1));
+    }
+    // Satu langkah forward reachability: tambahkan "to" dari setiap baris yang "from"-nya sudah tercapai
+    static constexpr uint32_t reachStep(const FsmTransition* t, uint8_t n, uint32_t mask) {
+        return n == 0 ? mask : reachStep(t + 1, n - 1,
+            (t->from == FSM_ANY_STATE || (mask & stateBit(t->from))) ? (mask | stateBit(t->to)) : mask);
+    }
+    static constexpr uint32_t reachable(const FsmTransition* t, uint8_t n, uint32_t mask, uint8_t iter) {
+        return iter == 0 ? mask : reachable(t, n, reachStep(t, n, mask), iter - 1);
+    }
+    // Satu langkah backward: tambahkan "from" dari setiap baris yang "to"-nya bisa mencapai target
+    static constexpr uint32_t coReachStep(const FsmTransition* t, uint8_t n, uint32_t mask) {
+        return n == 0 ? mask : coReachStep(t + 1, n - 1,
+            (mask & stateBit(t->to))
+                ? (mask | (t->from == FSM_ANY_STATE ? allStatesMask() : stateBit(t->from)))
+                : mask);
+    }
+    static constexpr uint32_t coReachable(const FsmTransition* t, uint8_t n, uint32_t mask, uint8_t iter) {
+        return iter == 0 ? mask : coReachable(t, n, coReachStep(t, n, mask), iter - 1);
+    }
+    // State s punya baris sendiri tanpa guard untuk event e (dispatch tidak pernah "jatuh"
+    // tanpa keputusan). Baris FSM_ANY_STATE tidak dihitung: wildcard selalu memenuhi cek
+    // ini, jadi state baru tanpa fallback eksplisit akan lolos diam-diam.
+    static constexpr bool hasFallback(const FsmTransition* t, uint8_t n, SystemState s, FsmEvent e) {
+        return n != 0 && (
+            (t->from == s && t->event == e && t->guard == nullptr) ||
+            hasFallback(t + 1, n - 1, s, e));
+    }
+    static constexpr bool allHaveFallback(const FsmTransition* t, uint8_t n, uint8_t s, FsmEvent e) {
+        return s == FSM_STATE_COUNT ||
+            (hasFallback(t, n, static_cast<SystemState>(s), e) && allHaveFallback(t, n, s + 1, e));
+    }
+    static constexpr bool eventUsed(const FsmTransition* t, uint8_t n, FsmEvent e) {
+        return n != 0 && (t->event == e || eventUsed(t + 1, n - 1, e));
+    }
+    static constexpr bool allEventsUsed(const FsmTransition* t, uint8_t n, uint8_t e) {
+        return e == static_cast<uint8_t>(FsmEvent::EV_COUNT) ||
+            (eventUsed(t, n, static_cast<FsmEvent>(e)) && allEventsUsed(t, n, e + 1));
+    }
+    static void validateTable();
 };
 
-#endif
\ No newline at end of file
+#endif
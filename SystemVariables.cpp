@@ -1,11 +1,36 @@
 // SystemVariables.cpp
 #include "SystemVariables.h"
+#include "Logger.h"
+
+static const char* NVS_NAMESPACE = "settings";
+static const char* NVS_KEY_SETTINGS = "v";
+static const uint8_t AUTO_TIME_EMPTY = 0xFF;
+
+// Lebar angka untuk padding tabel debug (tanpa String(n).length())
+static int digitCount(uint32_t value) {
+    int digits = 1;
+    while (value >= 10) {
+        value /= 10;
+        digits++;
+    }
+    return digits;
+}
+
+static_assert(sizeof(StoredSettings) == 16, "StoredSettings layout berubah - naikkan STORAGE_SETTINGS_VERSION");
 
 // ===== CONSTRUCTOR / DESTRUCTOR =====
 
-SystemStorage::SystemStorage() {
-    mutex = xSemaphoreCreateMutex();
+SystemStorage::SystemStorage()
+    : timeChangedTask(nullptr)
+    , stored()
+    , dirty(false)
+    , dirtySinceMs(0)
+    , wear()
+{
+    mutex = xSemaphoreCreateMutexStatic(&mutexBuffer);
+    TimerService::initFlag(writeTimer);
     initDefaults();
+    snapshot.publish(variables);
 }
 
 SystemStorage::~SystemStorage() {
@@ -15,11 +40,86 @@ SystemStorage::~SystemStorage() {
 // ===== PUBLIC API =====
 
 void SystemStorage::begin() {
-    Serial.println("[STORAGE] Initialized with default values");
+    uint32_t startUs = micros();
+    prefs.begin(NVS_NAMESPACE, false);
+    
+    // Satu blob: satu lookup NVS, tanpa parsing
+    StoredSettings record = StoredSettings();
+    bool present = prefs.getBytesLength(NVS_KEY_SETTINGS) == sizeof(record) &&
+                   prefs.getBytes(NVS_KEY_SETTINGS, &record, sizeof(record)) == sizeof(record);
+    bool loaded = present && record.version == STORAGE_SETTINGS_VERSION;
+    
+    lock();
+    if (loaded) {
+        unpack(record);
+        snapshot.publish(variables);
+        stored = record;
+        wear.writeCount = record.writeCount;
+        wear.pageEraseEstimate = record.writeCount * STORAGE_NVS_ENTRIES_PER_WRITE / STORAGE_NVS_ENTRIES_PER_PAGE;
+    }
+    wear.loadUs = micros() - startUs;
+    unlock();
+    
+    if (loaded) {
+        LOG_I("STORAGE", "Settings loaded from NVS in %luus (%lu writes)",
+              (unsigned long)wear.loadUs, (unsigned long)wear.writeCount);
+    } else if (present) {
+        LOG_W("STORAGE", "Settings record version %u unsupported - using defaults", record.version);
+    } else {
+        LOG_I("STORAGE", "No stored settings - using defaults");
+    }
     printVariables();
 }
 
+void SystemStorage::flush() {
+    if (!timerService.consumeExpired(writeTimer)) return;
+    
+    lock();
+    if (!dirty) {
+        unlock();
+        return;
+    }
+    dirty = false;
+    StoredSettings record = pack();
+    unlock();
+    
+    // Setting kembali ke nilai tersimpan (slider bolak-balik): tidak perlu tulis
+    record.writeCount = stored.writeCount;
+    if (memcmp(&record, &stored, sizeof(record)) == 0) {
+        lock();
+        wear.skippedCount++;
+        unlock();
+        LOG_D("STORAGE", "Settings unchanged - NVS write skipped");
+        return;
+    }
+    
+    // Tulis flash di luar mutex: FSM tidak menunggu NVS
+    record.writeCount++;
+    if (prefs.putBytes(NVS_KEY_SETTINGS, &record, sizeof(record)) != sizeof(record)) {
+        LOG_E("STORAGE", "NVS write failed - retry in %lums", (unsigned long)STORAGE_WRITE_QUIET_MS);
+        lock();
+        if (!dirty) {
+            dirty = true;
+            dirtySinceMs = millis();
+        }
+        timerService.arm(writeTimer, STORAGE_WRITE_QUIET_MS);
+        unlock();
+        return;
+    }
+    stored = record;
+    
+    lock();
+    wear.writeCount = record.writeCount;
+    wear.pageEraseEstimate = record.writeCount * STORAGE_NVS_ENTRIES_PER_WRITE / STORAGE_NVS_ENTRIES_PER_PAGE;
+    unlock();
+    
+    LOG_I("STORAGE", "Settings saved to NVS (write #%lu)", (unsigned long)record.writeCount);
+}
+
 void SystemStorage::updateFromNextion(const NextionData &data) {
+    bool timeChanged = false;
+    bool changed = false;
+    
     lock();
     
     // Update RTC Time (format HH:MM)
@@ -27,11 +127,11 @@ void SystemStorage::updateFromNextion(const NextionData &data) {
         if (isValidTimeFormat(data.setTime)) {
             variables.setTime = data.setTime;
             variables.lastUpdateTime = millis();
-            Serial.print("[STORAGE] setTime → ");
-            Serial.println(variables.setTime);
+            changed = true;
+            timeChanged = true;
+            LOG_I("STORAGE", "setTime → %s", variables.setTime.c_str());
         } else {
-            Serial.print("[STORAGE] Invalid setTime format: ");
-            Serial.println(data.setTime);
+            LOG_W("STORAGE", "Invalid setTime format: %s", data.setTime.c_str());
         }
     }
     
@@ -40,11 +140,11 @@ void SystemStorage::updateFromNextion(const NextionData &data) {
         if (isValidTimeFormat(data.setAuto)) {
             variables.setAuto = data.setAuto;
             variables.lastUpdateTime = millis();
-            Serial.print("[STORAGE] setAuto → ");
-            Serial.println(variables.setAuto);
+            changed = true;
+            markDirty();
+            LOG_I("STORAGE", "setAuto → %s", variables.setAuto.c_str());
         } else {
-            Serial.print("[STORAGE] Invalid setAuto format: ");
-            Serial.println(data.setAuto);
+            LOG_W("STORAGE", "Invalid setAuto format: %s", data.setAuto.c_str());
         }
     }
     
@@ -52,115 +152,112 @@ void SystemStorage::updateFromNextion(const NextionData &data) {
     if (data.daysValue != variables.daysValue) {
         variables.daysValue = data.daysValue;
         variables.lastUpdateTime = millis();
-        Serial.print("[STORAGE] daysValue → ");
-        Serial.println(variables.daysValue);
+        changed = true;
+        markDirty();
+        LOG_I("STORAGE", "daysValue → %u", variables.daysValue);
     }
     
     // Update Auto Temperature
     if (data.autoTemp != variables.autoTemp) {
         variables.autoTemp = data.autoTemp;
         variables.lastUpdateTime = millis();
-        Serial.print("[STORAGE] autoTemp → ");
-        Serial.println(variables.autoTemp);
+        changed = true;
+        markDirty();
+        LOG_I("STORAGE", "autoTemp → %u", variables.autoTemp);
     }
     
     // Update Count Timer
     if (data.countValue != variables.countValue) {
         variables.countValue = data.countValue;
         variables.lastUpdateTime = millis();
-        Serial.print("[STORAGE] countValue → ");
-        Serial.println(variables.countValue);
+        changed = true;
+        markDirty();
+        LOG_I("STORAGE", "countValue → %u", variables.countValue);
     }
     
     // Update Cooling Value
     if (data.coolingValue != variables.coolingValue) {
         variables.coolingValue = data.coolingValue;
         variables.lastUpdateTime = millis();
-        Serial.print("[STORAGE] coolingValue → ");
-        Serial.println(variables.coolingValue);
+        changed = true;
+        markDirty();
+        LOG_I("STORAGE", "coolingValue → %u", variables.coolingValue);
     }
     
+    if (changed) {
+        snapshot.publish(variables);
+    }
+    TaskHandle_t task = timeChangedTask;
     unlock();
+    
+    // Task jam tidur sampai ada perubahan, tidak polling setTime
+    if (timeChanged && task) {
+        xTaskNotify(task, STORAGE_NOTIFY_SETTIME, eSetBits);
+    }
 }
 
-SystemVariables SystemStorage::getVariables() {
-    SystemVariables copy;
+void SystemStorage::setTimeChangedTask(TaskHandle_t task) {
     lock();
-    copy = variables;
+    timeChangedTask = task;
     unlock();
-    return copy;
+}
+
+SystemVariables SystemStorage::getVariables() {
+    return snapshot.read();
 }
 
 // ===== INDIVIDUAL GETTERS =====
 
-String SystemStorage::getSetTime() {
-    lock();
-    String value = variables.setTime;
-    unlock();
-    return value;
+TimeText SystemStorage::getSetTime() {
+    return snapshot.read().setTime;
 }
 
-String SystemStorage::getSetAuto() {
-    lock();
-    String value = variables.setAuto;
-    unlock();
-    return value;
+TimeText SystemStorage::getSetAuto() {
+    return snapshot.read().setAuto;
 }
 
 uint16_t SystemStorage::getDaysValue() {
-    lock();
-    uint16_t value = variables.daysValue;
-    unlock();
-    return value;
+    return snapshot.read().daysValue;
 }
 
 uint8_t SystemStorage::getAutoTemp() {
-    lock();
-    uint8_t value = variables.autoTemp;
-    unlock();
-    return value;
+    return snapshot.read().autoTemp;
 }
 
 uint16_t SystemStorage::getCountValue() {
-    lock();
-    uint16_t value = variables.countValue;
-    unlock();
-    return value;
+    return snapshot.read().countValue;
 }
 
 uint8_t SystemStorage::getCoolingValue() {
-    lock();
-    uint8_t value = variables.coolingValue;
-    unlock();
-    return value;
+    return snapshot.read().coolingValue;
 }
 
 // ===== VALIDATION =====
 
-bool SystemStorage::isValidTimeFormat(const String &time) {
+bool SystemStorage::isValidTimeFormat(const TimeText &time) {
     // Format harus HH:MM (5 karakter)
     if (time.length() != 5) {
         return false;
     }
     
     // Cek posisi ':' di index 2
-    if (time.charAt(2) != ':') {
+    if (time[2] != ':') {
         return false;
     }
     
     // Cek apakah HH adalah digit
-    if (!isDigit(time.charAt(0)) || !isDigit(time.charAt(1))) {
+    if (!isDigit(time[0]) || !isDigit(time[1])) {
         return false;
     }
     
     // Cek apakah MM adalah digit
-    if (!isDigit(time.charAt(3)) || !isDigit(time.charAt(4))) {
+    if (!isDigit(time[3]) || !isDigit(time[4])) {
         return false;
     }
     
     // Extract HH dan MM
-    int hours = time.substring(0, 2).toInt();
-    int minutes = time.substring(3, 5).toInt();
+    int hours = (time[0] - '0') * 10 + (time[1] - '0');
+    int minutes = (time[3] - '0') * 10 + (time[4] - '0');
     
     // Validasi range
     if (hours < 0 || hours > 23) {
@@ -185,7 +282,7 @@ void SystemStorage::printVariables() {
     
     Serial.print("║ setTime      : "); 
     if (variables.setTime.length() > 0) {
-        Serial.print(variables.setTime);
+        Serial.print(variables.setTime.c_str());
         for(int i = variables.setTime.length(); i < 23; i++) Serial.print(" ");
     } else {
         Serial.print("--:--");
@@ -195,7 +292,7 @@ void SystemStorage::printVariables() {
     
     Serial.print("║ setAuto      : "); 
     if (variables.setAuto.length() > 0) {
-        Serial.print(variables.setAuto);
+        Serial.print(variables.setAuto.c_str());
         for(int i = variables.setAuto.length(); i < 23; i++) Serial.print(" ");
     } else {
         Serial.print("--:--");
@@ -206,28 +303,37 @@ void SystemStorage::printVariables() {
     Serial.print("║ daysValue    : "); 
     Serial.print(variables.daysValue);
     Serial.print(" days");
-    int len = String(variables.daysValue).length() + 5;
+    int len = digitCount(variables.daysValue) + 5;
     for(int i = len; i < 23; i++) Serial.print(" ");
     Serial.println("║");
     
     Serial.print("║ autoTemp     : "); 
     Serial.print(variables.autoTemp);
     Serial.print("°C");
-    len = String(variables.autoTemp).length() + 2;
+    len = digitCount(variables.autoTemp) + 2;
     for(int i = len; i < 23; i++) Serial.print(" ");
     Serial.println("║");
     
     Serial.print("║ countValue   : "); 
     Serial.print(variables.countValue);
     Serial.print(" sec");
-    len = String(variables.countValue).length() + 4;
+    len = digitCount(variables.countValue) + 4;
     for(int i = len; i < 23; i++) Serial.print(" ");
     Serial.println("║");
     
     Serial.print("║ coolingValue : "); 
     Serial.print(variables.coolingValue);
     Serial.print("°C");
-    len = String(variables.coolingValue).length() + 2;
+    len = digitCount(variables.coolingValue) + 2;
+    for(int i = len; i < 23; i++) Serial.print(" ");
+    Serial.println("║");
+    
+    Serial.print("║ NVS writes   : "); 
+    Serial.print(wear.writeCount);
+    Serial.print(" (~");
+    Serial.print(wear.pageEraseEstimate);
+    Serial.print(" erases)");
+    len = digitCount(wear.writeCount) + digitCount(wear.pageEraseEstimate) + 11;
     for(int i = len; i < 23; i++) Serial.print(" ");
     Serial.println("║");
     
@@ -236,11 +342,18 @@ void SystemStorage::printVariables() {
     unlock();
 }
 
+StorageWearStats SystemStorage::getWearStats() {
+    lock();
+    StorageWearStats copy = wear;
+    unlock();
+    return copy;
+}
+
 // ===== PRIVATE METHODS =====
 
 void SystemStorage::initDefaults() {
-    variables.setTime = "";
-    variables.setAuto = "";
+    variables.setTime.clear();
+    variables.setAuto.clear();
     variables.daysValue = 0;
     variables.autoTemp = 0;
     variables.countValue = 0;
@@ -248,6 +361,49 @@ void SystemStorage::initDefaults() {
     variables.lastUpdateTime = 0;
 }
 
+// Dipanggil di dalam lock. Setiap perubahan mengulang periode diam, dibatasi
+// STORAGE_WRITE_MAX_DELAY_MS supaya drag panjang tetap tersimpan.
+void SystemStorage::markDirty() {
+    unsigned long now = millis();
+    if (!dirty) {
+        dirty = true;
+        dirtySinceMs = now;
+    } else {
+        wear.coalescedCount++;
+    }
+    
+    if (now - dirtySinceMs < STORAGE_WRITE_MAX_DELAY_MS || !timerService.isArmed(writeTimer)) {
+        timerService.arm(writeTimer, STORAGE_WRITE_QUIET_MS);
+    }
+}
+
+StoredSettings SystemStorage::pack() {
+    StoredSettings record = StoredSettings();
+    record.version = STORAGE_SETTINGS_VERSION;
+    record.autoHour = AUTO_TIME_EMPTY;
+    record.autoMinute = AUTO_TIME_EMPTY;
+    if (isValidTimeFormat(variables.setAuto)) {
+        record.autoHour = atoi(variables.setAuto.c_str());
+        record.autoMinute = atoi(variables.setAuto.from(3));
+    }
+    record.autoTemp = variables.autoTemp;
+    record.coolingValue = variables.coolingValue;
+    record.daysValue = variables.daysValue;
+    record.countValue = variables.countValue;
+    return record;
+}
+
+void SystemStorage::unpack(const StoredSettings &record) {
+    variables.setAuto.clear();
+    if (record.autoHour <= 23 && record.autoMinute <= 59) {
+        variables.setAuto.format("%02u:%02u", record.autoHour, record.autoMinute);
+    }
+    variables.autoTemp = record.autoTemp;
+    variables.coolingValue = record.coolingValue;
+    variables.daysValue = record.daysValue;
+    variables.countValue = record.countValue;
+}
+
 // ===== MUTEX =====
 
 void SystemStorage::lock() {
@@ -3,15 +3,28 @@
 #define SYSTEM_VARIABLES_H
 
 #include <Arduino.h>
+#include <Preferences.h>
 #include "NextionGateWay.h"
+#include "TimerService.h"
+#include "SeqLock.h"
+
+// Bit notifikasi ke task jam (bit 0 dipakai RTC_NOTIFY_MINUTE)
+#define STORAGE_NOTIFY_SETTIME    (1UL << 1)
+
+// ===== PERSISTENCE CONFIG =====
+#define STORAGE_SETTINGS_VERSION      1
+#define STORAGE_WRITE_QUIET_MS        5000     // Tulis NVS setelah setting diam selama ini (slider drag)
+#define STORAGE_WRITE_MAX_DELAY_MS    60000    // Batas tunda jika setting terus berubah
+#define STORAGE_NVS_ENTRIES_PER_WRITE 3        // Blob 16 byte: index + header + 1 data entry (32 byte)
+#define STORAGE_NVS_ENTRIES_PER_PAGE  126      // Page 4 KB; penuh → pindah page, page lama di-erase
 
 // ===== STORAGE STRUCTURE =====
 struct SystemVariables {
     // RTC Settings
-    String setTime;              // Format dari settime=HH:MM
+    TimeText setTime;            // Format dari settime=HH:MM
     
     // Auto Cycle Settings
-    String setAuto;              // Konfigurasi auto cycle dari setAuto=HH:MM
+    TimeText setAuto;            // Konfigurasi auto cycle dari setAuto=HH:MM
     uint16_t daysValue;          // Interval cycle dalam hari dari days:X
     uint8_t autoTemp;            // Target temperature auto mode dari autotempX
     
@@ -25,39 +38,81 @@ struct SystemVariables {
     unsigned long lastUpdateTime;
 };
 
+// Record NVS (namespace "settings", key "v"): layout tetap, ganti
+// STORAGE_SETTINGS_VERSION jika berubah. setTime tidak disimpan (ada di RTC).
+struct StoredSettings {
+    uint8_t version;
+    uint8_t autoHour;            // 0xFF = setAuto kosong
+    uint8_t autoMinute;
+    uint8_t autoTemp;
+    uint8_t coolingValue;
+    uint8_t reserved;
+    uint16_t daysValue;
+    uint16_t countValue;
+    uint16_t reserved2;
+    uint32_t writeCount;         // Total tulis record ini sejak NVS kosong
+};
+
+struct StorageWearStats {
+    uint32_t writeCount;         // Tulis NVS (persisten)
+    uint32_t coalescedCount;     // Perubahan yang digabung ke satu tulis (sejak boot)
+    uint32_t skippedCount;       // Flush tanpa tulis: nilai sama dengan NVS (sejak boot)
+    uint32_t pageEraseEstimate;  // Perkiraan erase page dari entry yang dipakai
+    uint32_t loadUs;             // Durasi load saat boot
+};
+
 // ===== STORAGE MANAGER CLASS =====
 class SystemStorage {
 public:
     SystemStorage();
     ~SystemStorage();
     
-    void begin();
+    void begin();     // Load setting tersimpan dari NVS
+    void flush();     // Dipanggil dari loop(): tulis NVS jika setting sudah diam
     
     // Update dari Nextion (hanya ambil value, bukan status button)
     void updateFromNextion(const NextionData &data);
     
-    // Getter
+    // Getter: snapshot seqlock, koheren antar field tanpa lock
     SystemVariables getVariables();
     
-    // Individual getters
-    String getSetTime();
-    String getSetAuto();
+    // Individual getters (ambil beberapa field → pakai getVariables() sekali)
+    TimeText getSetTime();
+    TimeText getSetAuto();
     uint16_t getDaysValue();
     uint8_t getAutoTemp();
     uint16_t getCountValue();
     uint8_t getCoolingValue();
     
+    // Task yang dibangunkan (STORAGE_NOTIFY_SETTIME) saat setTime berubah
+    void setTimeChangedTask(TaskHandle_t task);
+    
     // Validation helpers
-    bool isValidTimeFormat(const String &time);
+    bool isValidTimeFormat(const TimeText &time);
     
     // Debug utilities
     void printVariables();
+    StorageWearStats getWearStats();
 
 private:
-    SystemVariables variables;
-    SemaphoreHandle_t mutex;
+    SystemVariables variables;       // Milik writer (FSM), di-publish ke snapshot
+    SeqLock<SystemVariables> snapshot;
+    SemaphoreHandle_t mutex;         // Writer + state persistence
+    StaticSemaphore_t mutexBuffer;
+    TaskHandle_t timeChangedTask;
+    
+    // ===== PERSISTENCE =====
+    Preferences prefs;
+    StoredSettings stored;       // Isi NVS terakhir (pembanding, skip tulis identik)
+    bool dirty;
+    unsigned long dirtySinceMs;
+    StorageWearStats wear;
+    Timer writeTimer;            // Flag: periode diam habis
     
     void initDefaults();
+    void markDirty();
+    StoredSettings pack();
+    void unpack(const StoredSettings &record);
     
     void lock();
     void unlock();
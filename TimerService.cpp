@@ -0,0 +1,314 @@
+// TimerService.cpp
+#include "TimerService.h"
+#include "Logger.h"
+
+static const uint64_t L0_MASK = TIMER_L0_SIZE - 1;
+static const uint64_t LN_MASK = TIMER_LN_SIZE - 1;
+static const uint64_t NO_WAKE = 0xFFFFFFFFFFFFFFFFULL;
+
+portMUX_TYPE TimerService::mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Bit shift index slot untuk level n (n >= 1)
+static inline uint8_t levelShift(uint8_t level) {
+    return TIMER_L0_BITS + (level - 1) * TIMER_LN_BITS;
+}
+
+// ===== PUBLIC API =====
+
+void TimerService::begin() {
+    if (taskHandle) return;
+
+    // Timer yang di-arm sebelum begin() sudah menetapkan currentTick
+    portENTER_CRITICAL(&mux);
+    if (stats.armed == 0) currentTick = nowTick();
+    wakeTick = NO_WAKE;
+    portEXIT_CRITICAL(&mux);
+
+    taskHandle = xTaskCreateStaticPinnedToCore(
+        timerTask,
+        "TimerTask",
+        TIMER_TASK_STACK,
+        this,
+        TIMER_TASK_PRIORITY,
+        taskStack,
+        &taskBuffer,
+        TIMER_TASK_CORE
+    );
+
+    LOG_I("TIMER", "Timer wheel started (tick %ums, %u levels)", TIMER_TICK_MS, TIMER_LEVELS);
+}
+
+// ===== SETUP =====
+
+void TimerService::initCallback(Timer& timer, TimerCallback callback, void* arg) {
+    memset(&timer, 0, sizeof(timer));
+    timer.callback = callback;
+    timer.arg = arg;
+}
+
+void TimerService::initEvent(Timer& timer, QueueHandle_t queue, FsmEvent event) {
+    memset(&timer, 0, sizeof(timer));
+    timer.queue = queue;
+    timer.event = event;
+}
+
+void TimerService::initFlag(Timer& timer) {
+    memset(&timer, 0, sizeof(timer));
+}
+
+// ===== CONTROL =====
+
+void TimerService::arm(Timer& timer, uint32_t delayMs) {
+    armAt(timer, delayMs, 0);
+}
+
+void TimerService::armPeriodic(Timer& timer, uint32_t periodMs) {
+    armAt(timer, periodMs, msToTicks(periodMs));
+}
+
+void TimerService::cancel(Timer& timer) {
+    portENTER_CRITICAL(&mux);
+    if (timer.armed) {
+        unlink(timer);
+        timer.armed = false;
+        stats.armed--;
+    }
+    timer.expired = false;
+    portEXIT_CRITICAL(&mux);
+}
+
+bool TimerService::consumeExpired(Timer& timer) {
+    portENTER_CRITICAL(&mux);
+    bool expired = timer.expired;
+    timer.expired = false;
+    portEXIT_CRITICAL(&mux);
+    return expired;
+}
+
+uint32_t TimerService::remainingMs(const Timer& timer) {
+    uint64_t now = nowTick();
+    uint64_t remaining = 0;
+
+    portENTER_CRITICAL(&mux);
+    if (timer.armed && timer.expiryTick > now) {
+        remaining = (timer.expiryTick - now) * TIMER_TICK_MS;
+    }
+    portEXIT_CRITICAL(&mux);
+
+    return remaining > 0xFFFFFFFFULL ? 0xFFFFFFFF : static_cast<uint32_t>(remaining);
+}
+
+TimerStats TimerService::getStats() {
+    portENTER_CRITICAL(&mux);
+    TimerStats copy = stats;
+    portEXIT_CRITICAL(&mux);
+    return copy;
+}
+
+// ===== DEBUG =====
+
+void TimerService::printStats() {
+    TimerStats s = getStats();
+    LOG_I("TIMER", "armed=%lu fired=%lu cascades=%lu maxLate=%lums",
+          (unsigned long)s.armed,
+          (unsigned long)s.fired,
+          (unsigned long)s.cascades,
+          (unsigned long)(s.maxLateTicks * TIMER_TICK_MS));
+}
+
+// ===== WHEEL =====
+
+uint32_t TimerService::msToTicks(uint32_t ms) {
+    // Dibulatkan ke atas: timer tidak pernah expire lebih cepat dari delay
+    uint32_t ticks = (ms + TIMER_TICK_MS - 1) / TIMER_TICK_MS;
+    return ticks == 0 ? 1 : ticks;
+}
+
+void TimerService::armAt(Timer& timer, uint32_t delayMs, uint32_t periodTicks) {
+    // Expiry dibulatkan ke atas dari waktu absolut (ms), bukan dari tick sekarang,
+    // supaya tidak expire sampai satu tick lebih cepat
+    uint64_t nowMsValue = nowMs();
+    uint64_t now = nowMsValue / TIMER_TICK_MS;
+    uint64_t expiry = (nowMsValue + delayMs + TIMER_TICK_MS - 1) / TIMER_TICK_MS;
+    if (expiry <= now) expiry = now + 1;
+
+    portENTER_CRITICAL(&mux);
+
+    bool wasIdle = (stats.armed == 0);
+    bool wake = false;
+    if (timer.armed) {
+        unlink(timer);
+    } else {
+        stats.armed++;
+    }
+
+    // Wheel kosong: lompati tick idle, task tidak perlu mengejar satu per satu
+    if (wasIdle && currentTick < now) {
+        currentTick = now;
+    }
+
+    timer.expiryTick = expiry;
+    timer.periodTicks = periodTicks;
+    timer.expired = false;
+    timer.armed = true;
+    insert(timer);
+
+    // Expire sebelum TimerTask bangun: bangunkan supaya jadwal tidur dihitung ulang
+    if (expiry < wakeTick) {
+        wakeTick = expiry;
+        wake = true;
+    }
+
+    portEXIT_CRITICAL(&mux);
+
+    if (wake && taskHandle) {
+        xTaskNotifyGive(taskHandle);
+    }
+}
+
+// insert/unlink/cascade dipanggil dengan mux dipegang
+
+void TimerService::insert(Timer& timer) {
+    uint64_t expiry = timer.expiryTick;
+    if (expiry < currentTick) expiry = currentTick;
+    uint64_t delta = expiry - currentTick;
+
+    Timer** slot;
+    if (delta < TIMER_L0_SIZE) {
+        slot = &level0[expiry & L0_MASK];
+    } else {
+        uint8_t level = 1;
+        while (level < TIMER_LEVELS - 1 && delta >= (1ULL << levelShift(level + 1))) {
+            level++;
+        }
+        // Di luar jangkauan level teratas: clamp ke slot terjauh, di-cascade ulang nanti
+        if (delta >= (1ULL << (levelShift(TIMER_LEVELS - 1) + TIMER_LN_BITS))) {
+            expiry = currentTick + (1ULL << (levelShift(TIMER_LEVELS - 1) + TIMER_LN_BITS)) - 1;
+        }
+        slot = &levelN[level - 1][(expiry >> levelShift(level)) & LN_MASK];
+    }
+
+    timer.next = *slot;
+    if (timer.next) timer.next->pprev = &timer.next;
+    *slot = &timer;
+    timer.pprev = slot;
+}
+
+void TimerService::unlink(Timer& timer) {
+    *timer.pprev = timer.next;
+    if (timer.next) timer.next->pprev = timer.pprev;
+    timer.next = nullptr;
+    timer.pprev = nullptr;
+}
+
+void TimerService::cascade(uint8_t level, uint8_t index) {
+    Timer* timer = levelN[level - 1][index];
+    levelN[level - 1][index] = nullptr;
+
+    while (timer) {
+        Timer* next = timer->next;
+        insert(*timer);
+        stats.cascades++;
+        timer = next;
+    }
+}
+
+// ===== TASK =====
+
+bool TimerService::processTick(uint64_t now) {
+    portENTER_CRITICAL(&mux);
+
+    if (currentTick > now) {
+        portEXIT_CRITICAL(&mux);
+        return false;
+    }
+
+    // Awal putaran level 0: turunkan slot level atas yang jatuh tempo
+    if ((currentTick & L0_MASK) == 0) {
+        for (uint8_t level = 1; level < TIMER_LEVELS; level++) {
+            uint8_t index = (currentTick >> levelShift(level)) & LN_MASK;
+            cascade(level, index);
+            if (index != 0) break;
+        }
+    }
+
+    for (;;) {
+        Timer* timer = level0[currentTick & L0_MASK];
+        if (!timer) break;
+
+        unlink(*timer);
+        stats.fired++;
+        if (now > timer->expiryTick && now - timer->expiryTick > stats.maxLateTicks) {
+            stats.maxLateTicks = now - timer->expiryTick;
+        }
+
+        TimerCallback callback = timer->callback;
+        void* arg = timer->arg;
+        QueueHandle_t queue = timer->queue;
+        FsmEvent event = timer->event;
+
+        timer->expired = true;
+        if (timer->periodTicks) {
+            timer->expiryTick += timer->periodTicks;
+            if (timer->expiryTick <= currentTick) {
+                timer->expiryTick = currentTick + timer->periodTicks;  // Terlambat - jangan burst
+            }
+            insert(*timer);
+        } else {
+            timer->armed = false;
+            stats.armed--;
+        }
+
+        // Callback/post di luar critical section
+        portEXIT_CRITICAL(&mux);
+        if (callback) callback(arg);
+        if (queue) fsmPostEvent(queue, event);
+        portENTER_CRITICAL(&mux);
+    }
+
+    currentTick++;
+    portEXIT_CRITICAL(&mux);
+    return true;
+}
+
+// Dipanggil dengan mux dipegang. Tick berikutnya yang perlu diproses: slot
+// level 0 terisi pertama, atau awal putaran level 0 (cascade level atas).
+uint64_t TimerService::nextWakeTick() {
+    if (stats.armed == 0) return NO_WAKE;
+
+    uint64_t tick = currentTick;
+    if ((tick & L0_MASK) == 0) return tick;
+
+    do {
+        if (level0[tick & L0_MASK]) return tick;
+        tick++;
+    } while (tick & L0_MASK);
+
+    return tick;
+}
+
+void TimerService::timerTask(void* pvParameters) {
+    TimerService* self = static_cast<TimerService*>(pvParameters);
+
+    for (;;) {
+        uint64_t now = nowTick();
+        while (self->processTick(now)) {
+        }
+
+        portENTER_CRITICAL(&self->mux);
+        uint64_t next = self->nextWakeTick();
+        self->wakeTick = next;
+        portEXIT_CRITICAL(&self->mux);
+
+        // Tidak ada timer aktif: tidur sampai arm() berikutnya.
+        // arm() yang lebih awal dari wakeTick membangunkan task lewat notify.
+        TickType_t wait = portMAX_DELAY;
+        if (next != NO_WAKE) {
+            uint64_t nowMsValue = nowMs();
+            uint64_t dueMs = next * TIMER_TICK_MS;
+            wait = dueMs > nowMsValue ? pdMS_TO_TICKS(dueMs - nowMsValue) : 0;
+            if (wait == 0 && dueMs > nowMsValue) wait = 1;
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
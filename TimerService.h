@@ -0,0 +1,113 @@
+// TimerService.h
+#ifndef TIMER_SERVICE_H
+#define TIMER_SERVICE_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "FsmEvent.h"
+
+// ===== WHEEL CONFIG =====
+// Basis waktu esp_timer_get_time() 64-bit (tidak wrap seperti millis() 49 hari).
+// Level 0: 256 slot × 10 ms = 2.56 s, level 1-3: 64 slot masing-masing
+// → jangkauan langsung ±7.7 hari; lebih jauh di-clamp dan di-cascade ulang.
+#define TIMER_TICK_MS         10
+#define TIMER_L0_BITS         8
+#define TIMER_LN_BITS         6
+#define TIMER_LEVELS          4
+#define TIMER_TASK_STACK      3072
+#define TIMER_TASK_PRIORITY   4      // Di atas FsmTask: expiry terkirim tepat waktu
+#define TIMER_TASK_CORE       1
+
+#define TIMER_L0_SIZE         (1 << TIMER_L0_BITS)
+#define TIMER_LN_SIZE         (1 << TIMER_LN_BITS)
+
+typedef void (*TimerCallback)(void* arg);
+
+// ===== TIMER NODE =====
+// Intrusive: memory milik pemanggil (biasanya member class), service tidak
+// pernah alokasi. Saat expire bisa memanggil callback (di TimerTask, jangan
+// blocking lama), post FsmEvent ke queue, atau hanya set flag expired.
+struct Timer {
+    Timer* next;
+    Timer** pprev;              // Pointer ke pointer yang menunjuk node ini → unlink O(1)
+    uint64_t expiryTick;
+    uint32_t periodTicks;       // 0 = one-shot
+
+    TimerCallback callback;
+    void* arg;
+    QueueHandle_t queue;
+    FsmEvent event;
+
+    volatile bool armed;
+    volatile bool expired;      // Set saat fire, di-clear saat arm/cancel/consumeExpired
+};
+
+struct TimerStats {
+    uint32_t armed;             // Timer yang sedang aktif
+    uint32_t fired;             // Total expiry
+    uint32_t cascades;          // Total node yang dipindah antar level
+    uint32_t maxLateTicks;      // Keterlambatan expiry terburuk (tick)
+};
+
+// ===== TIMER SERVICE CLASS =====
+// arm/cancel O(1) dari task mana pun (portMUX, bukan mutex - aman dari ISR).
+// TimerTask tidur sampai slot level 0 terisi berikutnya (atau awal putaran
+// level 0 untuk cascade), bukan polling tiap tick; tanpa timer aktif tidur total.
+//
+// Tidak punya constructor (seperti Logger): init*() boleh dipanggil dari
+// constructor global lain. mux diinisialisasi statis, jadi arm() sebelum
+// begin() aman; timer baru jalan setelah begin().
+class TimerService {
+public:
+    void begin();
+
+    // ===== SETUP (tidak menyentuh state service) =====
+    static void initCallback(Timer& timer, TimerCallback callback, void* arg);
+    static void initEvent(Timer& timer, QueueHandle_t queue, FsmEvent event);
+    static void initFlag(Timer& timer);
+
+    // ===== CONTROL =====
+    void arm(Timer& timer, uint32_t delayMs);          // Arm ulang jika sudah aktif
+    void armPeriodic(Timer& timer, uint32_t periodMs);
+    void cancel(Timer& timer);
+
+    static bool isArmed(const Timer& timer) { return timer.armed; }
+    static bool hasExpired(const Timer& timer) { return timer.expired; }
+    bool consumeExpired(Timer& timer);                 // Test-and-clear flag expired
+    uint32_t remainingMs(const Timer& timer);
+
+    // ===== TIME BASE =====
+    static uint64_t nowMs() { return static_cast<uint64_t>(esp_timer_get_time()) / 1000ULL; }
+    static uint64_t nowTick() { return nowMs() / TIMER_TICK_MS; }
+
+    TimerStats getStats();
+
+    // ===== DEBUG =====
+    void printStats();
+
+private:
+    Timer* level0[TIMER_L0_SIZE];
+    Timer* levelN[TIMER_LEVELS - 1][TIMER_LN_SIZE];
+
+    uint64_t currentTick;       // Tick berikutnya yang akan diproses
+    uint64_t wakeTick;          // Tick tujuan tidur TimerTask (UINT64_MAX = idle)
+    static portMUX_TYPE mux;    // Static init: siap sebelum constructor global
+    TaskHandle_t taskHandle;
+    StaticTask_t taskBuffer;
+    StackType_t taskStack[TIMER_TASK_STACK];
+    TimerStats stats;
+
+    static uint32_t msToTicks(uint32_t ms);
+    void armAt(Timer& timer, uint32_t delayMs, uint32_t periodTicks);
+    void insert(Timer& timer);
+    void unlink(Timer& timer);
+    void cascade(uint8_t level, uint8_t index);
+    bool processTick(uint64_t now);
+    uint64_t nextWakeTick();
+
+    static void timerTask(void* pvParameters);
+};
+
+extern TimerService timerService;
+
+#endif
@@ -0,0 +1,57 @@
+// WaterQuality.cpp
+#include "WaterQuality.h"
+#include "Logger.h"
+
+// ===== CONSTRUCTOR =====
+
+WaterQuality::WaterQuality()
+    : inletTds(TDS_DEFAULT_INLET_PPM)
+    , inletKnown(false)
+{
+}
+
+// ===== PUBLIC API =====
+
+void WaterQuality::learnInlet(int tds) {
+    if (tds < 0) return;
+
+    if (inletKnown) {
+        inletTds += TDS_LEARN_ALPHA * (tds - inletTds);
+    } else {
+        inletTds = tds;
+        inletKnown = true;
+    }
+    LOG_D("TDS", "Inlet TDS %.0f ppm", inletTds);
+}
+
+float WaterQuality::planExchange(float tankLiters, int tds, uint16_t limitPpm) {
+    if (tankLiters <= 0 || tds <= limitPpm) return 0;
+
+    float target = limitPpm * TDS_TARGET_RATIO;
+    if (inletTds >= target) {
+        // Air masuk sendiri tidak memenuhi limit: ganti penuh adalah yang terbaik
+        LOG_W("TDS", "Inlet %.0f ppm >= target %.0f ppm - full exchange", inletTds, target);
+        return tankLiters;
+    }
+
+    float liters = tankLiters * (tds - target) / (tds - inletTds);
+    if (liters < TDS_MIN_EXCHANGE_L) liters = TDS_MIN_EXCHANGE_L;
+    if (liters > tankLiters) liters = tankLiters;
+    return liters;
+}
+
+float WaterQuality::predictTds(float tankLiters, int tds, float exchangeLiters) const {
+    if (tankLiters <= 0) return tds;
+    return ((tankLiters - exchangeLiters) * tds + exchangeLiters * inletTds) / tankLiters;
+}
+
+void WaterQuality::logSaving(float tankLiters, float exchangeLiters, uint32_t elapsedMs,
+                             int tdsBefore, float tdsPredicted) {
+    float savedLiters = tankLiters - exchangeLiters;
+    // Drain dan fill kira-kira linear terhadap volume
+    float fullMs = exchangeLiters > 0 ? elapsedMs * tankLiters / exchangeLiters : elapsedMs;
+
+    LOG_I("TDS", "Exchanged %.1f of %.1f L in %lus: %d → %.0f ppm, saved %.1f L and ~%lus vs full dump",
+          exchangeLiters, tankLiters, (unsigned long)(elapsedMs / 1000), tdsBefore, tdsPredicted,
+          savedLiters, (unsigned long)((fullMs - elapsedMs) / 1000));
+}
@@ -0,0 +1,36 @@
+// WaterQuality.h
+#ifndef WATER_QUALITY_H
+#define WATER_QUALITY_H
+
+#include <Arduino.h>
+
+// ===== QUALITY CONFIG =====
+#define TDS_DEFAULT_INLET_PPM     150      // Sebelum ada fill dari tangki kosong
+#define TDS_LEARN_ALPHA           0.3f
+#define TDS_TARGET_RATIO          0.95f    // Target 5% di bawah limit (noise sensor)
+#define TDS_MIN_EXCHANGE_L        1.0f     // Lebih kecil dari ini tidak sebanding dengan satu siklus valve
+
+// ===== WATER QUALITY CLASS =====
+// Partial drain-and-refill berbasis neraca massa TDS. Tangki V liter dengan
+// TDS C, buang x liter lalu isi x liter air masuk (TDS Cf):
+//   C' = ((V - x)·C + x·Cf) / V  ≤  L   →   x = V·(C - L) / (C - Cf)
+// Cf dipelajari dari TDS tangki setelah fill dari kosong.
+class WaterQuality {
+public:
+    WaterQuality();
+
+    void learnInlet(int tds);                                   // Tangki baru diisi dari kosong
+    float planExchange(float tankLiters, int tds, uint16_t limitPpm);  // Liter drain = refill, 0 = tidak perlu
+    float predictTds(float tankLiters, int tds, float exchangeLiters) const;
+    float getInletTds() const { return inletTds; }
+
+    // Penghematan dibanding buang-isi penuh, di log
+    void logSaving(float tankLiters, float exchangeLiters, uint32_t elapsedMs,
+                   int tdsBefore, float tdsPredicted);
+
+private:
+    float inletTds;
+    bool inletKnown;
+};
+
+#endif
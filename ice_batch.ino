@@ -9,21 +9,45 @@
 #include "ActuatorControl.h"              // ← ADD
 #include "NextionOutput.h"                // ← ADD
 #include "StateConditionHandler.h"        // ← ADD
+#include "AutoCycle.h"
+#include "Checkpoint.h"
+#include "HeapMonitor.h"
+#include "EventBus.h"
+#include "Recipe.h"
+#include "FlowCalibration.h"
+#include "Logger.h"
+#include "TimerService.h"
 #include "esp_task_wdt.h"
 
 // ===== GLOBAL INSTANCES =====
+Logger logger;                            // Zero-initialized, aman dipakai constructor lain
+TimerService timerService;                // Zero-initialized, Timer boleh di-init di constructor lain
 NextionGateWay nextion;
 SystemStorage storage;
 RTCManager rtcManager;
+CheckpointStore checkpointStore(&rtcManager);
+HeapMonitor heapMonitor;                  // Tren heap: steady-state tanpa malloc/free
+EventBus eventBus;                        // Fan-out sensor / state / actuator / UI
 SensorManager sensorManager;
 SensorDisplayManager displayManager;
 ActuatorControl actuatorControl;          // ← ADD
 NextionOutput nextionOutput;              // ← ADD
+RecipeStore recipeStore;
+FlowCalibration flowCalibration(&rtcManager);
 StateConditionHandler conditionHandler(   // ← ADD (with dependencies)
     &sensorManager,
     &actuatorControl,
     &nextionOutput
 );
+AutoCycle autoCycle(
+    &conditionHandler,
+    &actuatorControl,
+    &sensorManager,
+    &nextionOutput,
+    &storage,
+    &rtcManager,
+    &recipeStore
+);
 SystemStateMachine fsm(                   // ← UPDATE (with dependencies)
     &sensorManager,
     &actuatorControl,
@@ -33,8 +57,26 @@ SystemStateMachine fsm(                   // ← UPDATE (with dependencies)
     &nextion  // ← BENAR (object yang sudah dideklarasi di line 15)
 );
 
+// ===== TASK STACKS =====
+// Stack & TCB statis: footprint RAM diketahui saat link, create tidak bisa gagal
+// (ESP-IDF: ukuran stack dalam byte, StackType_t = uint8_t)
+#define NEXTION_TASK_STACK        4096
+#define SENSOR_TASK_STACK         2048
+#define FSM_TASK_STACK            4096
+#define RTC_TASK_STACK            2048
+
+static StackType_t nextionTaskStack[NEXTION_TASK_STACK];
+static StackType_t sensorTaskStack[SENSOR_TASK_STACK];
+static StackType_t fsmTaskStack[FSM_TASK_STACK];
+static StackType_t rtcTaskStack[RTC_TASK_STACK];
+static StaticTask_t nextionTaskBuffer;
+static StaticTask_t sensorTaskBuffer;
+static StaticTask_t fsmTaskBuffer;
+static StaticTask_t rtcTaskBuffer;
+
 TaskHandle_t nextionTaskHandle;
-TaskHandle_t debugTaskHandle;
+TaskHandle_t sensorTaskHandle;
+TaskHandle_t fsmTaskHandle;
 TaskHandle_t rtcTaskHandle;
 
 // ===== TASKS =====
@@ -46,55 +88,185 @@ void nextionTask(void *pvParameters) {
     }
 }
 
-void debugStateTask(void *pvParameters) {
-    SystemState lastState = SystemState::STATE_ERROR;
+void sensorTask(void *pvParameters) {
+    TickType_t lastWake = xTaskGetTickCount();
 
     for (;;) {
-        NextionData data = nextion.getData();
-        
-        // Update Storage dari Nextion
-        storage.updateFromNextion(data);
-        
         // ===== UPDATE SENSORS =====
+        // Sampling tetap periodik; FSM hanya dibangunkan jika ada perubahan berarti.
+        // Subscriber topic sensors (display) dipanggil dari sini dengan sampel yang sama.
         sensorManager.update();
-        
-        // ===== SYNC SENSORS TO NEXTION =====
-        displayManager.syncToNextion();
-        
-        // ===== UPDATE FSM =====
-        fsm.update(data);
 
-        // Debug log state changes
-        if (fsm.getState() != lastState) {
-            lastState = fsm.getState();
-            Serial.print("[FSM] State changed → ");
-            Serial.println(fsm.stateName());
-        }
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(200));
+    }
+}
+
+void fsmTask(void *pvParameters) {
+    // Lanjutkan state sebelum reset (atau IDLE) sebelum event pertama diproses
+    fsm.resumeFromCheckpoint();
 
-        vTaskDelay(pdMS_TO_TICKS(200));
+    for (;;) {
+        // ===== UPDATE FSM =====
+        // Blocking di event queue (UI, sensor, deadline, heartbeat)
+        fsm.processNextEvent();
     }
 }
 
+// Debug log state changes (subscriber topic states, jalan di FSM task setelah
+// entry: state sekarang = change.to)
+void logStateChange(void* context, const StateChange& change) {
+    LOG_I("FSM", "State changed → %s", static_cast<SystemStateMachine*>(context)->stateName());
+}
+
+// Tidur sampai menit berganti (ISR SQW) atau settime baru (storage).
+// tClock hanya dikirim jika HH:MM berubah: 1 perintah per menit, bukan per detik.
 void rtcTask(void *pvParameters) {
-    static String lastSetTime = "";
+    int16_t shownMinute = -1;                 // Menit-hari yang sedang tampil
+    uint32_t events = STORAGE_NOTIFY_SETTIME; // Iterasi pertama: ambil setTime yang sudah ada
+    
+    rtcManager.setNotifyTask(xTaskGetCurrentTaskHandle());
+    storage.setTimeChangedTask(xTaskGetCurrentTaskHandle());
     
     for (;;) {
-        // Cek apakah ada setTime baru dari storage
-        String currentSetTime = storage.getSetTime();
-        
-        if (currentSetTime.length() > 0 && currentSetTime != lastSetTime) {
-            // Ada perubahan setTime, update RTC
-            if (rtcManager.setTime(currentSetTime)) {
-                Serial.print("[RTC] Time updated from storage: ");
-                Serial.println(currentSetTime);
-                lastSetTime = currentSetTime;
+        if (events & STORAGE_NOTIFY_SETTIME) {
+            TimeText currentSetTime = storage.getSetTime();
+            if (currentSetTime.length() > 0 && rtcManager.setTime(currentSetTime.c_str())) {
+                LOG_I("RTC", "Time updated from storage: %s", currentSetTime.c_str());
             }
         }
         
-        // Kirim waktu ke Nextion setiap 1 detik
-        rtcManager.sendToNextion("tClock");
+        // Resync jam software berkala / fallback jika SQW mati
+        rtcManager.update();
+        
+        uint8_t hour, minute, second;
+        rtcManager.getTime(hour, minute, second);
+        int16_t minuteOfDay = hour * 60 + minute;
+        
+        if (rtcManager.isRTCValid() && minuteOfDay != shownMinute) {
+            rtcManager.sendToNextion("tClock");
+            shownMinute = minuteOfDay;
+        }
+        
+        // Timeout = watchdog SQW; tanpa SQW bangun sendiri tepat setelah menit
+        // berganti / alarm jadwal jatuh tempo
+        uint32_t waitMs = RTC_TASK_CHECK_MS;
+        if (!rtcManager.isSqwAlive()) {
+            uint32_t nextMinuteMs = (60 - second) * 1000UL + RTC_TASK_WAKE_MARGIN_MS;
+            if (nextMinuteMs < waitMs) waitMs = nextMinuteMs;
+            
+            uint32_t alarm = rtcManager.getNextAlarm();
+            uint32_t now = rtcManager.getUnixTime();
+            if (alarm > now && (alarm - now) * 1000UL < waitMs) {
+                waitMs = (alarm - now) * 1000UL + RTC_TASK_WAKE_MARGIN_MS;
+            }
+        }
         
-        vTaskDelay(pdMS_TO_TICKS(1000));
+        events = 0;
+        xTaskNotifyWait(0, 0xFFFFFFFFUL, &events, pdMS_TO_TICKS(waitMs));
+    }
+}
+
+// ===== SERIAL CONSOLE =====
+// "recipe" tampilkan, "recipe default" reset, "recipe <steps>" simpan recipe baru
+// "flowcal" history K-factor, "flowcal capacity <L>" volume kosong → float, "flowcal reset"
+// "heap" tren free heap / blok terbesar sejak baseline
+// "mailbox" isi, drop dan latency mailbox FSM & Nextion TX
+// "bus" pesan terkirim / difilter / di-rate-limit per subscriber event bus
+// "compressor" model thermal, tracking error & start/jam compressor controller
+
+static char consoleLine[RECIPE_MAX_SOURCE + 8];
+static size_t consoleLength = 0;
+static bool consoleOverflow = false;
+
+void handleFlowCalCommand(const char* args) {
+    while (*args == ' ') args++;
+
+    if (*args == '\0') {
+        flowCalibration.printHistory();
+    } else if (strcmp(args, "reset") == 0) {
+        flowCalibration.reset();
+    } else if (strncmp(args, "capacity ", 9) == 0) {
+        flowCalibration.setCapacityLiters(atof(args + 9));
+    } else {
+        LOG_W("CONSOLE", "Usage: flowcal [capacity <L> | reset]");
+    }
+}
+
+void logMailboxStats(const char* name, const MailboxStats& stats, uint32_t capacity) {
+    LOG_I("CONSOLE", "%s: depth %lu/%lu high %lu dropped %lu latency avg %luus max %luus",
+          name, (unsigned long)stats.depth, (unsigned long)capacity,
+          (unsigned long)stats.highWater, (unsigned long)stats.dropped,
+          (unsigned long)stats.avgLatencyUs, (unsigned long)stats.maxLatencyUs);
+}
+
+void logCompressorMetrics(const CompressorMetrics& m) {
+    LOG_I("CONSOLE", "Compressor model: cool %.3f°C/min, gain %.3f°C/min, coast -%.2f/+%.2f°C",
+          m.model.coolRate, m.model.gainRate, m.model.coastDown, m.model.coastUp);
+    LOG_I("CONSOLE", "Compressor tracking RMS %.2f°C max %.2f°C, starts %.0f/h (total %lu)",
+          m.trackingRmsC, m.trackingMaxC, m.startsPerHour, (unsigned long)m.starts);
+}
+
+void handleConsoleCommand(const char* line) {
+    if (strncmp(line, "flowcal", 7) == 0) {
+        handleFlowCalCommand(line + 7);
+        return;
+    }
+    if (strcmp(line, "heap") == 0) {
+        heapMonitor.printTrend();
+        return;
+    }
+    if (strcmp(line, "bus") == 0) {
+        eventBus.printStats();
+        return;
+    }
+    if (strcmp(line, "mailbox") == 0) {
+        logMailboxStats("FSM", fsm.getMailboxStats(), FSM_QUEUE_LENGTH);
+        logMailboxStats("Nextion TX", nextion.getTxStats(), NEXTION_TX_MAILBOX);
+        return;
+    }
+    if (strcmp(line, "compressor") == 0) {
+        logCompressorMetrics(conditionHandler.getCompressorMetrics());
+        return;
+    }
+    if (strncmp(line, "recipe", 6) != 0) {
+        LOG_W("CONSOLE", "Unknown command: %s", line);
+        return;
+    }
+
+    const char* args = line + 6;
+    while (*args == ' ') args++;
+
+    if (*args == '\0') {
+        recipeStore.printRecipe();
+    } else if (strcmp(args, "default") == 0) {
+        recipeStore.resetToDefault();
+    } else {
+        RecipeError error;
+        if (recipeStore.load(args, error)) {
+            recipeStore.printRecipe();
+        }
+    }
+}
+
+void pollConsole() {
+    while (Serial.available() > 0) {
+        char c = Serial.read();
+
+        if (c == '\n' || c == '\r') {
+            // Baris terpotong tidak pernah dieksekusi (recipe setengah jadi)
+            if (consoleOverflow) {
+                LOG_W("CONSOLE", "Line too long - ignored");
+            } else if (consoleLength > 0) {
+                consoleLine[consoleLength] = '\0';
+                handleConsoleCommand(consoleLine);
+            }
+            consoleLength = 0;
+            consoleOverflow = false;
+        } else if (consoleLength < sizeof(consoleLine) - 1) {
+            consoleLine[consoleLength++] = c;
+        } else {
+            consoleOverflow = true;
+        }
     }
 }
 
@@ -104,59 +276,115 @@ void setup() {
     Serial.begin(115200);
     delay(500);
 
+    // ===== ASYNC LOGGER =====
+    // Mulai paling awal: semua modul logging lewat ring buffer, bukan Serial langsung
+    logger.begin();
+
+    // ===== TIMER SERVICE =====
+    // Sebelum modul lain: begin() modul boleh langsung arm timer
+    timerService.begin();
+
     // ===== WATCHDOG TIMER INIT =====
-    Serial.println("[WDT] Initializing Watchdog Timer (30 seconds)...");
+    LOG_I("WDT", "Initializing Watchdog Timer (30 seconds)...");
     esp_task_wdt_init(30, true);
     esp_task_wdt_add(NULL);
-    Serial.println("[WDT] Watchdog Timer enabled");
+    LOG_I("WDT", "Watchdog Timer enabled");
 
     // ===== INITIALIZE MODULES =====
     nextion.begin();
+    nextion.setEventQueue(fsm.getEventQueue());
+    nextion.setEventBus(&eventBus);
     storage.begin();
+    nextion.seedSettings(storage.getVariables());
+    recipeStore.begin();
+    flowCalibration.begin();
+    autoCycle.begin();                    // Model pre-cool dari NVS
     rtcManager.begin();
     rtcManager.setNextionGateway(&nextion);
+    checkpointStore.begin();              // Setelah RTC: umur checkpoint
+    fsm.setCheckpointStore(&checkpointStore);
+    rtcManager.setEventQueue(fsm.getEventQueue());
     
+    sensorManager.setEventQueue(fsm.getEventQueue());
+    sensorManager.setCalibration(&flowCalibration);
+    conditionHandler.setFlowCalibration(&flowCalibration);
+    conditionHandler.setEventQueue(fsm.getEventQueue());
+    autoCycle.setEventQueue(fsm.getEventQueue());
+    fsm.setAutoCycle(&autoCycle);
+    fsm.setEventBus(&eventBus);
+    sensorManager.setEventBus(&eventBus);
+    actuatorControl.setEventBus(&eventBus);
+    eventBus.states.subscribe("log", logStateChange, &fsm);
     sensorManager.begin();
-    displayManager.begin(&sensorManager, &nextion);
+    displayManager.begin(&eventBus, &nextion);
     
     actuatorControl.begin();              // ← ADD
     nextionOutput.begin();                // ← ADD
+    nextionOutput.setGateway(&nextion);
+    nextionOutput.restoreSettings(storage.getVariables());
     
-    Serial.println("[SYSTEM] All systems initialized");
+    LOG_I("SYSTEM", "All systems initialized");
 
     // ===== CREATE TASKS =====
-    xTaskCreatePinnedToCore(
+    nextionTaskHandle = xTaskCreateStaticPinnedToCore(
         nextionTask,
         "NextionTask",
-        4096,
+        NEXTION_TASK_STACK,
         nullptr,
         2,
-        &nextionTaskHandle,
+        nextionTaskStack,
+        &nextionTaskBuffer,
         1
     );
 
-    xTaskCreatePinnedToCore(
-        debugStateTask,
-        "DebugStateTask",
-        2048,
+    sensorTaskHandle = xTaskCreateStaticPinnedToCore(
+        sensorTask,
+        "SensorTask",
+        SENSOR_TASK_STACK,
         nullptr,
         1,
-        &debugTaskHandle,
+        sensorTaskStack,
+        &sensorTaskBuffer,
         0
     );
 
-    xTaskCreatePinnedToCore(
+    // Prioritas di atas NextionTask: event UI langsung diproses
+    fsmTaskHandle = xTaskCreateStaticPinnedToCore(
+        fsmTask,
+        "FsmTask",
+        FSM_TASK_STACK,
+        nullptr,
+        3,
+        fsmTaskStack,
+        &fsmTaskBuffer,
+        1
+    );
+
+    // Evaluasi awal input Nextion tanpa menunggu heartbeat
+    fsm.postEvent(FsmEvent::EV_UI_CHANGED);
+
+    rtcTaskHandle = xTaskCreateStaticPinnedToCore(
         rtcTask,
         "RTCTask",
-        2048,
+        RTC_TASK_STACK,
         nullptr,
         1,
-        &rtcTaskHandle,
+        rtcTaskStack,
+        &rtcTaskBuffer,
         0
     );
+
+    // Task, queue & mutex statis; sisa alokasi = driver core (Serial, NVS): mulai warm-up baseline heap
+    heapMonitor.begin();
 }
 
 void loop() {
     esp_task_wdt_reset();
+    pollConsole();
+    storage.flush();                      // Tulis NVS di task prioritas rendah
+    checkpointStore.flush();
+    flowCalibration.flush();
+    autoCycle.flush();
+    heapMonitor.update();
     vTaskDelay(pdMS_TO_TICKS(100));
 }
@@ -0,0 +1,366 @@
+#!/usr/bin/env python3
+"""Host tool untuk log tokenized ice_batch (LOG_FORMAT=LOG_FORMAT_TOKENIZED).
+
+String table di-generate dari source yang sama dengan firmware, memakai hash
+yang sama dengan logToken() di LogToken.h. Jalankan sebagai bagian dari build;
+--header juga menulis ulang tabel index yang di-compile ke firmware:
+
+    python3 tools/logtok.py table . -o build/log_tokens.json --header LogTokenTable.h
+
+Decode stream dari serial (atau file capture):
+
+    stty -F /dev/ttyUSB0 115200 raw
+    python3 tools/logtok.py decode --table build/log_tokens.json /dev/ttyUSB0
+    python3 tools/logtok.py decode --src . capture.bin
+
+Byte di luar frame yang valid (boot ROM, dump print*, laporan drop) diteruskan
+apa adanya sebagai teks.
+"""
+
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+
+FRAME_SYNC = 0x1E
+CODE_TIME_SYNC, CODE_RAW_TOKEN, CODE_FIRST_INDEX = range(3)
+HEADER_NAME = "LogTokenTable.h"
+SOURCE_EXTS = (".cpp", ".h", ".ino")
+LEVELS = {"E": "ERROR", "W": "WARN", "I": "INFO", "D": "DEBUG"}
+
+ARG_UNSIGNED, ARG_SIGNED, ARG_FLOAT, ARG_STRING = range(4)
+
+CALL_RE = re.compile(
+    r'\bLOG_([EWID])\(\s*"((?:\\.|[^"\\])*)"\s*,\s*((?:"(?:\\.|[^"\\])*"\s*)+)')
+LITERAL_RE = re.compile(r'"((?:\\.|[^"\\])*)"')
+CONVERSION_RE = re.compile(
+    r'%(?:%|[-+ #0]*(?:\*|\d+)?(?:\.(?:\*|\d+))?(?:hh|h|ll|l|L|z|j|t)?([diouxXeEfgGcs]))')
+LENGTH_RE = re.compile(r'(%[-+ #0]*(?:\*|\d+)?(?:\.(?:\*|\d+))?)(?:hh|h|ll|l|L|z|j|t)')
+HEADER_ENTRY_RE = re.compile(r'0x([0-9a-fA-F]{8})u')
+
+
+# ===== TOKEN HASH (harus identik dengan LogToken.h) =====
+
+def fnv1a(data, h):
+    for b in data:
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def log_token(tag, fmt):
+    h = fnv1a(tag, 2166136261)
+    h = ((h ^ 0x1F) * 16777619) & 0xFFFFFFFF
+    return fnv1a(fmt, h)
+
+
+# ===== SOURCE SCANNER =====
+
+def strip_comments(text):
+    """Hapus komentar C/C++ tanpa merusak isi string literal."""
+    out = []
+    i, n = 0, len(text)
+    while i < n:
+        c = text[i]
+        if c == '"' or c == "'":
+            j = i + 1
+            while j < n and text[j] != c:
+                j += 2 if text[j] == "\\" else 1
+            out.append(text[i:j + 1])
+            i = j + 1
+        elif text.startswith("//", i):
+            j = text.find("\n", i)
+            i = n if j < 0 else j
+        elif text.startswith("/*", i):
+            j = text.find("*/", i + 2)
+            j = n if j < 0 else j + 2
+            out.append("\n" * text.count("\n", i, j))  # Jaga nomor baris
+            i = j
+        else:
+            out.append(c)
+            i += 1
+    return "".join(out)
+
+
+def unescape(literal):
+    """C escape -> bytes (source diasumsikan UTF-8, sama seperti compiler)."""
+    raw = literal.encode("utf-8")
+    out = bytearray()
+    i = 0
+    simple = {b"n": 10, b"t": 9, b"r": 13, b"0": 0, b"\\": 92, b'"': 34, b"'": 39}
+    while i < len(raw):
+        if raw[i:i + 1] != b"\\":
+            out.append(raw[i])
+            i += 1
+            continue
+        nxt = raw[i + 1:i + 2]
+        if nxt == b"x":
+            m = re.match(rb"[0-9a-fA-F]+", raw[i + 2:])
+            out.append(int(m.group(0), 16) & 0xFF)
+            i += 2 + len(m.group(0))
+        elif nxt in simple:
+            out.append(simple[nxt])
+            i += 2
+        else:
+            out.append(raw[i + 1])
+            i += 2
+    return bytes(out)
+
+
+def build_table(src_dir):
+    table = {}
+    for root, _, files in os.walk(src_dir):
+        if os.sep + "." in root or "tools" in root.split(os.sep):
+            continue
+        for name in sorted(files):
+            if not name.endswith(SOURCE_EXTS):
+                continue
+            path = os.path.join(root, name)
+            with open(path, encoding="utf-8") as f:
+                text = strip_comments(f.read())
+            for m in CALL_RE.finditer(text):
+                tag = unescape(m.group(2))
+                fmt = b"".join(unescape(p) for p in LITERAL_RE.findall(m.group(3)))
+                token = log_token(tag, fmt)
+                entry = {
+                    "level": LEVELS[m.group(1)],
+                    "tag": tag.decode("utf-8"),
+                    "fmt": fmt.decode("utf-8"),
+                    "file": os.path.relpath(path, src_dir),
+                    "line": text.count("\n", 0, m.start()) + 1,
+                }
+                old = table.get(token)
+                if old and (old["tag"], old["fmt"]) != (entry["tag"], entry["fmt"]):
+                    sys.exit("token collision 0x%08x: %r vs %r" % (token, old, entry))
+                table.setdefault(token, entry)
+    return table
+
+
+# ===== INDEX TABLE (LogTokenTable.h) =====
+
+def table_id(index):
+    """ID tabel yang dikirim firmware di time-sync: FNV-1a atas token u32 LE."""
+    return fnv1a(b"".join(struct.pack("<I", t) for t in index), 2166136261)
+
+
+def write_header(path, index):
+    ident = table_id(index)
+    lines = [
+        "// LogTokenTable.h",
+        "// GENERATED oleh tools/logtok.py - jangan diedit manual.",
+        "// Token terurut: index di sini = index di frame log tokenized.",
+        "#ifndef LOG_TOKEN_TABLE_H",
+        "#define LOG_TOKEN_TABLE_H",
+        "",
+        "#define LOG_TOKEN_TABLE_SIZE  %d" % len(index),
+        "#define LOG_TOKEN_TABLE_ID    0x%08xu" % ident,
+        "",
+        "constexpr uint32_t LOG_TOKEN_TABLE[%d] = {" % max(len(index), 1),
+    ]
+    for i in range(0, len(index), 6):
+        lines.append("    " + " ".join("0x%08xu," % t for t in index[i:i + 6]))
+    if not index:
+        lines.append("    0")
+    lines += ["};", "", "#endif", ""]
+    with open(path, "w", encoding="utf-8", newline="\n") as f:
+        f.write("\n".join(lines))
+
+
+def read_header(path):
+    """Index yang di-compile ke firmware; [] jika header belum ada."""
+    if not os.path.exists(path):
+        return []
+    with open(path, encoding="utf-8") as f:
+        text = f.read()
+    body = text[text.find("LOG_TOKEN_TABLE["):]
+    size = int(re.search(r"LOG_TOKEN_TABLE_SIZE\s+(\d+)", text).group(1))
+    return [int(h, 16) for h in HEADER_ENTRY_RE.findall(body)][:size]
+
+
+# ===== FRAME DECODER =====
+
+def crc16(data, crc=0xFFFF):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def read_varint(buf, pos):
+    value, shift = 0, 0
+    while True:
+        b = buf[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            return value, pos
+
+
+def unzigzag(v):
+    return (v >> 1) ^ -(v & 1)
+
+
+def format_message(entry, body):
+    fmt = entry["fmt"]
+    count = sum(1 for m in CONVERSION_RE.finditer(fmt) if m.group(1))
+    sig_len = (count + 3) // 4
+    sig, pos = body[:sig_len], sig_len
+    args = []
+    for i in range(count):
+        kind = (sig[i // 4] >> (2 * (i % 4))) & 3
+        if kind == ARG_UNSIGNED:
+            v, pos = read_varint(body, pos)
+        elif kind == ARG_SIGNED:
+            v, pos = read_varint(body, pos)
+            v = unzigzag(v)
+        elif kind == ARG_FLOAT:
+            v = struct.unpack_from("<f", body, pos)[0]
+            pos += 4
+        else:
+            n = body[pos]
+            v = body[pos + 1:pos + 1 + n].decode("utf-8", "replace")
+            pos += 1 + n
+        args.append(v)
+    try:
+        return LENGTH_RE.sub(r"\1", fmt) % tuple(args)
+    except (TypeError, ValueError):
+        return "%s %r" % (fmt, args)
+
+
+def decode_stream(stream, table, index, out):
+    buf = bytearray()
+    text = bytearray()
+    base_ms = None
+    ident = table_id(index)
+    index_ok = True
+
+    def flush_text():
+        if text:
+            out.write(text.decode("utf-8", "replace"))
+            text.clear()
+
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            break
+        buf += chunk
+        while buf:
+            if buf[0] != FRAME_SYNC:
+                text.append(buf.pop(0))
+                continue
+            if len(buf) < 2 or len(buf) < 2 + buf[1] + 2:
+                break  # Frame belum lengkap
+            length = buf[1]
+            frame = bytes(buf[1:2 + length])
+            crc = buf[2 + length] | buf[3 + length] << 8
+            if length < 1 or crc16(frame) != crc:
+                text.append(buf.pop(0))  # Bukan frame - resync byte berikutnya
+                base_ms = None           # Mungkin ada frame hilang: rantai TS putus
+                continue
+            del buf[:4 + length]
+            flush_text()
+
+            payload = frame[1:]
+            ident_code, pos = read_varint(payload, 0)
+            code = ident_code >> 1
+            delta = 0
+            if ident_code & 1:
+                delta, pos = read_varint(payload, pos)
+                delta = unzigzag(delta)
+
+            if code == CODE_TIME_SYNC:
+                base_ms, pos = read_varint(payload, pos)
+                sync_ok = struct.unpack_from("<I", payload, pos)[0] == ident
+                if sync_ok != index_ok:
+                    index_ok = sync_ok
+                    if not sync_ok:
+                        out.write("<%s firmware tidak cocok dengan table - regenerate>\n" % HEADER_NAME)
+                continue
+
+            if base_ms is not None:
+                base_ms += delta
+            if code == CODE_RAW_TOKEN:
+                token = struct.unpack_from("<I", payload, pos)[0]
+                pos += 4
+            elif index_ok and code - CODE_FIRST_INDEX < len(index):
+                token = index[code - CODE_FIRST_INDEX]
+            else:
+                token = None
+            body = payload[pos:]
+
+            ts = "%10d" % base_ms if base_ms is not None else "%10s" % "?"
+            entry = table.get(token)
+            if token is None:
+                out.write("%s ????? <unknown index %d, %d bytes>\n" % (
+                    ts, code - CODE_FIRST_INDEX, len(body)))
+            elif entry is None:
+                out.write("%s ????? <unknown token 0x%08x, %d bytes>\n" % (ts, token, len(body)))
+            else:
+                out.write("%s %-5s [%s] %s\n" % (
+                    ts, entry["level"], entry["tag"], format_message(entry, body)))
+        out.flush()
+    flush_text()
+
+
+# ===== CLI =====
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="cmd", required=True)
+
+    p_table = sub.add_parser("table", help="generate string table dari source")
+    p_table.add_argument("src", help="direktori sketch")
+    p_table.add_argument("-o", "--output", help="file JSON (default stdout)")
+    p_table.add_argument("--header", help="tulis ulang index firmware (LogTokenTable.h)")
+
+    p_decode = sub.add_parser("decode", help="decode stream log biner")
+    group = p_decode.add_mutually_exclusive_group(required=True)
+    group.add_argument("--table", help="file JSON dari perintah table")
+    group.add_argument("--src", help="bangun table langsung dari direktori sketch "
+                                     "(index dari %s di direktori itu)" % HEADER_NAME)
+    p_decode.add_argument("input", nargs="?", help="file/device (default stdin)")
+
+    args = parser.parse_args()
+
+    if args.cmd == "table":
+        table = build_table(args.src)
+        if args.header:
+            index = sorted(table)
+            write_header(args.header, index)
+        else:
+            index = read_header(os.path.join(args.src, HEADER_NAME))
+        data = {
+            "index": ["0x%08x" % t for t in index],
+            "tokens": {"0x%08x" % k: v for k, v in sorted(table.items())},
+        }
+        if args.output:
+            os.makedirs(os.path.dirname(args.output) or ".", exist_ok=True)
+            with open(args.output, "w", encoding="utf-8") as f:
+                json.dump(data, f, indent=1, ensure_ascii=False)
+        else:
+            json.dump(data, sys.stdout, indent=1, ensure_ascii=False)
+        return
+
+    if args.table:
+        with open(args.table, encoding="utf-8") as f:
+            data = json.load(f)
+        table = {int(k, 16): v for k, v in data["tokens"].items()}
+        index = [int(t, 16) for t in data["index"]]
+    else:
+        table = build_table(args.src)
+        index = read_header(os.path.join(args.src, HEADER_NAME))
+
+    if args.input:
+        with open(args.input, "rb", buffering=0) as stream:
+            decode_stream(stream, table, index, sys.stdout)
+    else:
+        decode_stream(sys.stdin.buffer, table, index, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()